@@ -0,0 +1,132 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * État des actionneurs de l'enfant persisté en NVS (écritures regroupées)
+ */
+
+#include "app_actuator.h"
+
+#include "app_deferred.h"
+#include "app_settings.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+#define TAG "app_actuator"
+
+#define ACTUATOR_KEY "act_state"
+#define ACTUATOR_RECORD_VERSION 1
+
+/** Enregistrement NVS: versionné pour ignorer un format ancien */
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t pinLevels;
+    uint8_t ledColor;
+} actuator_record_t;
+
+static portMUX_TYPE sStateLock = portMUX_INITIALIZER_UNLOCKED;
+static app_actuator_state_t sCurrent;
+static app_actuator_state_t sPersisted;  // Tâche d'écriture seulement
+static app_actuator_stats_t sStats;
+static app_deferred_writer_t sWriter;
+
+static bool state_equal(const app_actuator_state_t *a, const app_actuator_state_t *b)
+{
+    return a->pinLevels == b->pinLevels && a->ledColor == b->ledColor;
+}
+
+/**
+ * @brief Écrit l'état courant, une fois par rafale de commandes (tâche d'écriture)
+ *
+ * Un retour à l'état déjà enregistré ne produit aucune écriture.
+ *
+ * @param context Non utilisé
+ */
+static void write_state(void *context)
+{
+    app_actuator_state_t snapshot;
+    (void)context;
+
+    portENTER_CRITICAL(&sStateLock);
+    snapshot = sCurrent;
+    portEXIT_CRITICAL(&sStateLock);
+
+    if (state_equal(&snapshot, &sPersisted)) {
+        portENTER_CRITICAL(&sStateLock);
+        sStats.unchanged++;
+        portEXIT_CRITICAL(&sStateLock);
+        return;
+    }
+
+    actuator_record_t record = {
+        .version = ACTUATOR_RECORD_VERSION,
+        .pinLevels = snapshot.pinLevels,
+        .ledColor = snapshot.ledColor,
+    };
+    esp_err_t err = app_settings_set_blob(ACTUATOR_KEY, &record, sizeof(record));
+
+    portENTER_CRITICAL(&sStateLock);
+    if (err == ESP_OK) {
+        sStats.writes++;
+    } else {
+        sStats.failures++;
+    }
+    portEXIT_CRITICAL(&sStateLock);
+
+    if (err == ESP_OK) {
+        sPersisted = snapshot;
+        ESP_LOGI(TAG, "Saved actuator state: pins 0x%02x, led 0x%02x", snapshot.pinLevels, snapshot.ledColor);
+    }
+}
+
+bool app_actuator_init(app_actuator_state_t *inOutState)
+{
+    actuator_record_t record;
+    size_t length = sizeof(record);
+    bool restored = false;
+
+    esp_err_t err = app_settings_get_blob(ACTUATOR_KEY, &record, &length);
+    if (err == ESP_OK && length == sizeof(record) && record.version == ACTUATOR_RECORD_VERSION) {
+        inOutState->pinLevels = record.pinLevels;
+        inOutState->ledColor = record.ledColor;
+        restored = true;
+        ESP_LOGI(TAG, "Restored actuator state: pins 0x%02x, led 0x%02x", record.pinLevels, record.ledColor);
+    } else if (err != ESP_ERR_NVS_NOT_FOUND && err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to read actuator state: %s", esp_err_to_name(err));
+    }
+
+    sCurrent = *inOutState;
+    sPersisted = *inOutState;
+    sStats.restored = restored;
+
+    if (!app_deferred_start(&sWriter, "actuator_nvs", APP_ACTUATOR_SETTLE_MS, APP_ACTUATOR_MAX_DEFER_MS,
+                            write_state, NULL)) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+    }
+    return restored;
+}
+
+void app_actuator_update(const app_actuator_state_t *state)
+{
+    bool changed;
+
+    portENTER_CRITICAL(&sStateLock);
+    changed = !state_equal(state, &sCurrent);
+    if (changed) {
+        sCurrent = *state;
+        sStats.changes++;
+    }
+    portEXIT_CRITICAL(&sStateLock);
+
+    if (changed) {
+        app_deferred_notify(&sWriter);
+    }
+}
+
+void app_actuator_get_stats(app_actuator_stats_t *outStats)
+{
+    portENTER_CRITICAL(&sStateLock);
+    *outStats = sStats;
+    portEXIT_CRITICAL(&sStateLock);
+}
@@ -0,0 +1,66 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * État des actionneurs de l'enfant persisté en NVS (écritures regroupées)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Délai de calme après le dernier changement avant d'écrire en NVS */
+#define APP_ACTUATOR_SETTLE_MS 2000
+
+/** Report maximal d'une écriture quand les changements ne cessent pas */
+#define APP_ACTUATOR_MAX_DEFER_MS 10000
+
+/** État des sorties pilotées par les commandes du leader */
+typedef struct {
+    uint8_t pinLevels;  // Bit n: niveau de CONTROL_PIN_(n+1)
+    uint8_t ledColor;   // Dernière couleur LED commandée (0x42, 0x46, 0x47...)
+} app_actuator_state_t;
+
+/** Mesures de la persistance (depuis le démarrage) */
+typedef struct {
+    bool restored;
+    uint32_t changes;
+    uint32_t writes;
+    uint32_t unchanged;  // Lots revenus à l'état déjà écrit: aucune écriture
+    uint32_t failures;
+} app_actuator_stats_t;
+
+/**
+ * @brief Relit l'état enregistré et démarre la tâche d'écriture
+ *
+ * À appeler tôt dans app_main(), après nvs_flash_init() et avant OpenThread,
+ * pour rétablir les sorties sans attendre le rattachement.
+ *
+ * @param inOutState En entrée l'état par défaut, en sortie l'état à appliquer
+ * @return true si un état enregistré a été relu
+ */
+bool app_actuator_init(app_actuator_state_t *inOutState);
+
+/**
+ * @brief Signale le nouvel état des actionneurs
+ *
+ * Ne touche pas à la flash: l'écriture a lieu APP_ACTUATOR_SETTLE_MS après
+ * le dernier changement (au plus APP_ACTUATOR_MAX_DEFER_MS après le premier),
+ * et seulement si l'état diffère de celui déjà enregistré.
+ */
+void app_actuator_update(const app_actuator_state_t *state);
+
+/**
+ * @brief Copie les mesures de la persistance
+ */
+void app_actuator_get_stats(app_actuator_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,141 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Adresses IPv6 des nœuds Thread dérivées de leur RLOC16
+ */
+
+#include "app_addr.h"
+
+#include <string.h>
+
+#include "openthread/thread.h"
+
+#define IID_INLINE_LEN     8
+#define ADDRESS_INLINE_LEN 16
+
+// Les bits de RLOC16 au-delà de l'identifiant d'enfant désignent le routeur parent
+#define RLOC16_ROUTER_MASK 0xfc00
+
+static app_addr_selection_t sLastSelection;
+
+// IID dérivé d'une adresse courte (0000:00ff:fe00:xxxx)
+static bool is_short_address_iid(const otIp6Address *addr)
+{
+    static const uint8_t kShortIid[6] = {0x00, 0x00, 0x00, 0xff, 0xfe, 0x00};
+
+    return memcmp(&addr->mFields.m8[8], kShortIid, sizeof(kShortIid)) == 0;
+}
+
+void app_addr_build_rloc_locked(otInstance *instance, uint16_t rloc16, otIp6Address *outAddr)
+{
+    const otMeshLocalPrefix *prefix = otThreadGetMeshLocalPrefix(instance);
+
+    memset(outAddr, 0, sizeof(*outAddr));
+    memcpy(outAddr->mFields.m8, prefix->m8, sizeof(prefix->m8));
+    outAddr->mFields.m8[11] = 0xff;
+    outAddr->mFields.m8[12] = 0xfe;
+    outAddr->mFields.m8[14] = (uint8_t)(rloc16 >> 8);
+    outAddr->mFields.m8[15] = (uint8_t)(rloc16 & 0xff);
+}
+
+app_addr_form_t app_addr_form_locked(otInstance *instance, const otIp6Address *addr)
+{
+    const otMeshLocalPrefix *prefix = otThreadGetMeshLocalPrefix(instance);
+
+    if (addr->mFields.m8[0] == 0xfe && (addr->mFields.m8[1] & 0xc0) == 0x80) {
+        return APP_ADDR_FORM_LINK_LOCAL;
+    }
+    if (memcmp(addr->mFields.m8, prefix->m8, sizeof(prefix->m8)) != 0) {
+        return APP_ADDR_FORM_OTHER;
+    }
+
+    return is_short_address_iid(addr) ? APP_ADDR_FORM_RLOC : APP_ADDR_FORM_ML_EID;
+}
+
+uint8_t app_addr_inline_len_locked(otInstance *instance, const otIp6Address *addr)
+{
+    switch (app_addr_form_locked(instance, addr)) {
+    case APP_ADDR_FORM_RLOC:
+        return 0;
+    case APP_ADDR_FORM_LINK_LOCAL:
+        return is_short_address_iid(addr) ? 0 : IID_INLINE_LEN;
+    case APP_ADDR_FORM_ML_EID:
+        return IID_INLINE_LEN;
+    default:
+        return ADDRESS_INLINE_LEN;
+    }
+}
+
+bool app_addr_get_rloc16_locked(otInstance *instance, const otIp6Address *addr, uint16_t *outRloc16)
+{
+    if (app_addr_form_locked(instance, addr) != APP_ADDR_FORM_RLOC) {
+        return false;
+    }
+
+    *outRloc16 = (uint16_t)((addr->mFields.m8[14] << 8) | addr->mFields.m8[15]);
+    return true;
+}
+
+// Le nœud est-il un enfant de ce routeur, présent dans la table des enfants?
+static bool is_direct_child_locked(otInstance *instance, uint16_t rloc16)
+{
+    otChildInfo childInfo;
+    uint16_t ownRloc16 = otThreadGetRloc16(instance);
+
+    if ((rloc16 & RLOC16_ROUTER_MASK) != (ownRloc16 & RLOC16_ROUTER_MASK) || rloc16 == ownRloc16) {
+        return false;
+    }
+
+    for (uint16_t index = 0; otThreadGetChildInfoByIndex(instance, index, &childInfo) == OT_ERROR_NONE; index++) {
+        if (childInfo.mRloc16 == rloc16) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint8_t app_addr_select_locked(otInstance *instance, uint16_t rloc16, const otIp6Address *stableAddr,
+                               otIp6Address *outAddr)
+{
+    *outAddr = *stableAddr;
+
+    if (is_direct_child_locked(instance, rloc16)) {
+        otIp6Address rloc;
+        app_addr_build_rloc_locked(instance, rloc16, &rloc);
+        if (app_addr_inline_len_locked(instance, &rloc) < app_addr_inline_len_locked(instance, stableAddr)) {
+            *outAddr = rloc;
+        }
+    }
+
+    // La pile choisit une source de même forme: l'économie vaut pour les deux adresses
+    uint8_t stableLen = app_addr_inline_len_locked(instance, stableAddr);
+    uint8_t saved = 2 * (stableLen - app_addr_inline_len_locked(instance, outAddr));
+
+    sLastSelection.valid = true;
+    sLastSelection.rloc16 = rloc16;
+    sLastSelection.form = app_addr_form_locked(instance, outAddr);
+    sLastSelection.savedBytes = saved;
+    return saved;
+}
+
+void app_addr_get_last_selection(app_addr_selection_t *outSelection)
+{
+    *outSelection = sLastSelection;
+}
+
+const char *app_addr_form_name(app_addr_form_t form)
+{
+    switch (form) {
+    case APP_ADDR_FORM_RLOC:
+        return "rloc";
+    case APP_ADDR_FORM_LINK_LOCAL:
+        return "link-local";
+    case APP_ADDR_FORM_ML_EID:
+        return "ml-eid";
+    default:
+        return "other";
+    }
+}
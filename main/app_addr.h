@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Adresses IPv6 des nœuds Thread dérivées de leur RLOC16
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Forme d'une adresse, de la plus compressible à la moins compressible */
+typedef enum {
+    APP_ADDR_FORM_RLOC = 0,   // Mesh-local, IID dérivé de l'adresse courte
+    APP_ADDR_FORM_LINK_LOCAL, // fe80::, IID en ligne sauf s'il dérive de l'adresse courte
+    APP_ADDR_FORM_ML_EID,     // Mesh-local, IID aléatoire
+    APP_ADDR_FORM_OTHER,      // Préfixe hors contexte: adresse complète en ligne
+} app_addr_form_t;
+
+/** Résultat de la dernière sélection d'adresse vers un enfant */
+typedef struct {
+    bool valid;
+    uint16_t rloc16;
+    app_addr_form_t form;
+    uint8_t savedBytes;  // Octets d'en-tête IPv6 économisés par trame face à l'ML-EID
+} app_addr_selection_t;
+
+/**
+ * @brief Construit l'adresse RLOC d'un nœud (préfixe mesh-local + 0:ff:fe00:rloc16)
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param rloc16 RLOC16 du nœud
+ * @param outAddr Adresse construite
+ */
+void app_addr_build_rloc_locked(otInstance *instance, uint16_t rloc16, otIp6Address *outAddr);
+
+/**
+ * @brief Classe une adresse selon sa compression IPHC
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+app_addr_form_t app_addr_form_locked(otInstance *instance, const otIp6Address *addr);
+
+/**
+ * @brief Octets de l'adresse restant en ligne après compression IPHC
+ *
+ * Le préfixe est élidé pour le lien local et le contexte mesh-local 0;
+ * l'IID l'est s'il dérive de l'adresse MAC courte de la trame.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+uint8_t app_addr_inline_len_locked(otInstance *instance, const otIp6Address *addr);
+
+/**
+ * @brief Lit le RLOC16 d'une adresse de forme RLOC
+ *
+ * @return true si l'adresse est une RLOC de ce réseau
+ */
+bool app_addr_get_rloc16_locked(otInstance *instance, const otIp6Address *addr, uint16_t *outRloc16);
+
+/**
+ * @brief Choisit l'adresse la plus compressible pour joindre un nœud
+ *
+ * Un enfant direct de ce nœud est joint par sa RLOC, reconstruite depuis
+ * l'adresse courte de la trame; un pair à plusieurs sauts garde l'adresse
+ * stable fournie (ML-EID), sa RLOC pouvant changer avec son parent.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param rloc16 RLOC16 courant du nœud
+ * @param stableAddr Adresse stable du nœud (ML-EID)
+ * @param outAddr Adresse choisie
+ * @return Octets économisés par trame face à stableAddr
+ */
+uint8_t app_addr_select_locked(otInstance *instance, uint16_t rloc16, const otIp6Address *stableAddr,
+                               otIp6Address *outAddr);
+
+/**
+ * @brief Copie le résultat de la dernière sélection
+ */
+void app_addr_get_last_selection(app_addr_selection_t *outSelection);
+
+/**
+ * @brief Nom lisible d'une forme d'adresse
+ */
+const char *app_addr_form_name(app_addr_form_t form);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Débits des compteurs MAC/MLE et temps d'antenne par classe de trafic
+ */
+
+#include "app_airtime.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_pack.h"
+
+#include "openthread/link.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+#define TAG "app_airtime"
+
+// Modèle radio 802.15.4 à 2,4 GHz: 32 us par octet, préambule/SFD/PHR de 6 octets
+#define AIRTIME_US_PER_BYTE 32
+#define AIRTIME_PHY_HEADER_BYTES 6
+#define AIRTIME_ACK_US (192 + (AIRTIME_PHY_HEADER_BYTES + 5) * AIRTIME_US_PER_BYTE)  // Retournement + ACK
+#define AIRTIME_FRAME_MAX 127
+#define AIRTIME_FRAG_HEADERS_BYTES 5
+
+// Tailles types des trames dont les compteurs ne donnent pas la longueur
+#define AIRTIME_POLL_BYTES 21    // Data Request sécurisée
+#define AIRTIME_BEACON_BYTES 40
+#define AIRTIME_STACK_BYTES 64   // MLE, supervision, MPL: taille moyenne observée
+
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sWindowTimer = NULL;
+
+static otMacCounters sLastMac;
+static otMleCounters sLastMle;
+static int64_t sWindowStartUs = 0;
+
+// Fenêtre en cours (chemin d'envoi), puis dernière fenêtre close
+static uint32_t sAppFrames[APP_AIRTIME_CLASS_COUNT];
+static uint32_t sAppAirtimeUs[APP_AIRTIME_CLASS_COUNT];
+static app_airtime_window_t sWindow;
+
+static uint32_t frame_airtime_us(uint32_t frameBytes, bool acked)
+{
+    return (frameBytes + AIRTIME_PHY_HEADER_BYTES) * AIRTIME_US_PER_BYTE + (acked ? AIRTIME_ACK_US : 0);
+}
+
+static app_airtime_class_t class_of(uint8_t opcode)
+{
+    // 0x00 est l'impulsion verte de la LED, pas une broche
+    if (opcode >= 0x01 && opcode <= 0x05) {
+        return APP_AIRTIME_CLASS_GPIO;
+    }
+    if (opcode == 0x00 || opcode == 0x42 || opcode == 0x46 || opcode == 0x47) {
+        return APP_AIRTIME_CLASS_LED;
+    }
+    return APP_AIRTIME_CLASS_OTHER;
+}
+
+void app_airtime_note_commands_locked(const uint8_t *data, uint16_t len, uint16_t budget)
+{
+    uint16_t commands[APP_AIRTIME_CLASS_COUNT] = {0};
+    uint16_t total = 0;
+    uint16_t offset = 0;
+
+    while (offset < len) {
+        commands[class_of(data[offset])]++;
+        total++;
+        offset += app_pack_frame_len(&data[offset], len - offset);
+    }
+
+    // En-têtes hors budget sur chaque trame, plus ceux de fragmentation au-delà d'une trame
+    uint16_t frames = app_pack_frame_count(len, budget);
+    uint32_t frameBytes = len + (uint32_t)frames * (AIRTIME_FRAME_MAX - budget);
+    if (frames > 1) {
+        frameBytes += (uint32_t)frames * AIRTIME_FRAG_HEADERS_BYTES;
+    }
+    uint32_t airtimeUs = frames * frame_airtime_us(frameBytes / frames, true);
+
+    // Trames comptées une fois par datagramme: partagées entre classes au prorata des commandes,
+    // le reste de la division à la classe la plus représentée pour que la somme reste exacte
+    uint16_t framesLeft = frames;
+    int dominant = 0;
+    for (int i = 0; i < APP_AIRTIME_CLASS_COUNT; i++) {
+        if (commands[i] == 0) {
+            continue;
+        }
+        uint16_t share = (uint16_t)((uint32_t)frames * commands[i] / total);
+        sAppFrames[i] += share;
+        framesLeft -= share;
+        sAppAirtimeUs[i] += (uint32_t)((uint64_t)airtimeUs * commands[i] / total);
+        if (commands[i] > commands[dominant]) {
+            dominant = i;
+        }
+    }
+    sAppFrames[dominant] += framesLeft;
+}
+
+static uint16_t count_children_locked(void)
+{
+    otChildInfo childInfo;
+    uint16_t count = 0;
+
+    while (otThreadGetChildInfoByIndex(sInstance, count, &childInfo) == OT_ERROR_NONE) {
+        count++;
+    }
+    return count;
+}
+
+// Clôt la fenêtre: écarts des compteurs, temps d'antenne par classe et capacité restante
+static void close_window_locked(void)
+{
+    const otMacCounters *mac = otLinkGetCounters(sInstance);
+    const otMleCounters *mle = otThreadGetMleCounters(sInstance);
+    int64_t nowUs = esp_timer_get_time();
+    app_airtime_window_t window;
+
+    memset(&window, 0, sizeof(window));
+    window.windowS = (uint32_t)((nowUs - sWindowStartUs + 500000) / 1000000);
+
+    window.txFrames = mac->mTxTotal - sLastMac.mTxTotal;
+    window.rxFrames = mac->mRxTotal - sLastMac.mRxTotal;
+    window.retries = mac->mTxRetry - sLastMac.mTxRetry;
+    window.txFailures = (mac->mTxDirectMaxRetryExpiry - sLastMac.mTxDirectMaxRetryExpiry) +
+                        (mac->mTxIndirectMaxRetryExpiry - sLastMac.mTxIndirectMaxRetryExpiry);
+    window.ccaFailures = mac->mTxErrCca - sLastMac.mTxErrCca;
+    window.polls = mac->mTxDataPoll - sLastMac.mTxDataPoll;
+    window.beacons = (mac->mTxBeacon - sLastMac.mTxBeacon) + (mac->mTxBeaconRequest - sLastMac.mTxBeaconRequest);
+
+    window.attachAttempts = (uint16_t)(mle->mAttachAttempts - sLastMle.mAttachAttempts);
+    window.parentChanges = (uint16_t)(mle->mParentChanges - sLastMle.mParentChanges);
+    window.partitionChanges = (uint16_t)(mle->mPartitionIdChanges - sLastMle.mPartitionIdChanges);
+
+    uint32_t appFramesTotal = 0;
+    uint32_t appAirtimeTotal = 0;
+    for (int i = 0; i < APP_AIRTIME_CLASS_COUNT; i++) {
+        window.appFrames[i] = sAppFrames[i];
+        window.appAirtimeUs[i] = sAppAirtimeUs[i];
+        appFramesTotal += sAppFrames[i];
+        appAirtimeTotal += sAppAirtimeUs[i];
+    }
+
+    // Le reste des émissions: trafic de la pile (mTxTotal ne compte pas les répétitions)
+    uint32_t known = appFramesTotal + window.polls + window.beacons;
+    window.stackFrames = (window.txFrames > known) ? window.txFrames - known : 0;
+
+    uint32_t rxAcked = mac->mRxUnicast - sLastMac.mRxUnicast;
+    uint32_t rxOther = (window.rxFrames > rxAcked ? window.rxFrames - rxAcked : 0) +
+                       (mac->mRxAddressFiltered - sLastMac.mRxAddressFiltered) +
+                       (mac->mRxDestAddrFiltered - sLastMac.mRxDestAddrFiltered);
+
+    window.retryAirtimeUs = window.retries * frame_airtime_us(AIRTIME_STACK_BYTES, true);
+    window.pollAirtimeUs = window.polls * frame_airtime_us(AIRTIME_POLL_BYTES, true);
+    window.beaconAirtimeUs = window.beacons * frame_airtime_us(AIRTIME_BEACON_BYTES, false);
+    window.stackAirtimeUs = window.stackFrames * frame_airtime_us(AIRTIME_STACK_BYTES, true);
+    window.rxAirtimeUs = rxAcked * frame_airtime_us(AIRTIME_STACK_BYTES, true) +
+                         rxOther * frame_airtime_us(AIRTIME_STACK_BYTES, false);
+
+    uint64_t busyUs = (uint64_t)appAirtimeTotal + window.retryAirtimeUs + window.pollAirtimeUs +
+                      window.beaconAirtimeUs + window.stackAirtimeUs + window.rxAirtimeUs;
+    uint64_t windowUs = (uint64_t)(nowUs - sWindowStartUs);
+    window.utilisationPermille = (windowUs > 0) ? (uint16_t)(busyUs * 1000 / windowUs) : 0;
+    window.ccaFailurePermille = (uint16_t)((uint32_t)otLinkGetCcaFailureRate(sInstance) * 1000 / 0xffff);
+
+    // Capacité: appareils de plus au trafic applicatif moyen d'un enfant actuel, sous le plafond CSMA
+    window.children = count_children_locked();
+    window.extraDevices = -1;
+    if (window.children > 0 && appAirtimeTotal > 0) {
+        uint64_t perDeviceUs = appAirtimeTotal / window.children;
+        uint64_t ceilingUs = windowUs * APP_AIRTIME_CEILING_PERCENT / 100;
+        window.extraDevices = (ceilingUs > busyUs) ? (int32_t)((ceilingUs - busyUs) / perDeviceUs) : 0;
+    }
+
+    sWindow = window;
+    sLastMac = *mac;
+    sLastMle = *mle;
+    sWindowStartUs = nowUs;
+    memset(sAppFrames, 0, sizeof(sAppFrames));
+    memset(sAppAirtimeUs, 0, sizeof(sAppAirtimeUs));
+}
+
+static void window_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    close_window_locked();
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_AIRTIME, start);
+    esp_openthread_lock_release();
+}
+
+void app_airtime_init_locked(otInstance *instance)
+{
+    if (sWindowTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+    sLastMac = *otLinkGetCounters(instance);
+    sLastMle = *otThreadGetMleCounters(instance);
+    sWindowStartUs = esp_timer_get_time();
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = window_timer_cb,
+        .name = "airtime",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sWindowTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sWindowTimer, APP_AIRTIME_WINDOW_S * 1000000ULL));
+}
+
+void app_airtime_get_window_locked(app_airtime_window_t *outWindow)
+{
+    *outWindow = sWindow;
+}
+
+const char *app_airtime_class_name(app_airtime_class_t airtimeClass)
+{
+    static const char *const names[APP_AIRTIME_CLASS_COUNT] = {"gpio", "led", "other"};
+
+    return (airtimeClass < APP_AIRTIME_CLASS_COUNT) ? names[airtimeClass] : "?";
+}
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Débits des compteurs MAC/MLE et temps d'antenne par classe de trafic
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Durée d'une fenêtre de mesure */
+#define APP_AIRTIME_WINDOW_S 10
+
+/**
+ * Occupation au-delà de laquelle CSMA-CA s'effondre (collisions et backoffs
+ * en cascade): sert de plafond au calcul de la capacité restante.
+ */
+#define APP_AIRTIME_CEILING_PERCENT 25
+
+/** Classes de commandes de l'application, d'après leur opcode */
+typedef enum {
+    APP_AIRTIME_CLASS_GPIO = 0,  // 0x01..0x05
+    APP_AIRTIME_CLASS_LED,       // 0x00 (impulsion verte), 0x42, 0x46, 0x47
+    APP_AIRTIME_CLASS_OTHER,
+    APP_AIRTIME_CLASS_COUNT,
+} app_airtime_class_t;
+
+/**
+ * Dernière fenêtre mesurée. Les temps d'antenne sont des estimations en
+ * microsecondes: trame, en-tête PHY, et ACK pour l'unicast, à 250 kbit/s.
+ */
+typedef struct {
+    uint32_t windowS;
+    // Trames émises et reçues, d'après les compteurs MAC
+    uint32_t txFrames;
+    uint32_t rxFrames;
+    uint32_t retries;
+    uint32_t txFailures;  // Abandons après le dernier essai
+    uint32_t ccaFailures;
+    uint32_t polls;
+    uint32_t beacons;
+    uint32_t stackFrames;  // MLE, supervision, MPL, diagnostics: ni application, ni sondage, ni balise
+    // Événements MLE
+    uint32_t attachAttempts;
+    uint32_t parentChanges;
+    uint32_t partitionChanges;
+    // Temps d'antenne de la fenêtre
+    uint32_t appFrames[APP_AIRTIME_CLASS_COUNT];
+    uint32_t appAirtimeUs[APP_AIRTIME_CLASS_COUNT];
+    uint32_t retryAirtimeUs;
+    uint32_t pollAirtimeUs;
+    uint32_t beaconAirtimeUs;
+    uint32_t stackAirtimeUs;
+    uint32_t rxAirtimeUs;  // Trames entendues, y compris celles filtrées pour d'autres nœuds
+    uint16_t utilisationPermille;
+    uint16_t ccaFailurePermille;  // Taux d'échec CCA de la pile: canal occupé par d'autres émetteurs
+    // Capacité (leader et routeurs)
+    uint16_t children;
+    int32_t extraDevices;  // Appareils supplémentaires au trafic moyen actuel, -1 si inconnu
+} app_airtime_window_t;
+
+/**
+ * @brief Démarre l'échantillonnage des compteurs toutes les APP_AIRTIME_WINDOW_S secondes
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+void app_airtime_init_locked(otInstance *instance);
+
+/**
+ * @brief Comptabilise un datagramme de commandes émis (chemin d'envoi)
+ *
+ * Le temps d'antenne de la trame est réparti entre les classes des
+ * commandes qu'elle transporte.
+ *
+ * @param data Commandes du datagramme
+ * @param len Longueur en octets
+ * @param budget Charge utile d'une trame (app_pack_budget_locked)
+ */
+void app_airtime_note_commands_locked(const uint8_t *data, uint16_t len, uint16_t budget);
+
+/**
+ * @brief Copie la dernière fenêtre mesurée (verrou OpenThread tenu)
+ */
+void app_airtime_get_window_locked(app_airtime_window_t *outWindow);
+
+/**
+ * @brief Nom court d'une classe de commandes ("gpio", "led", "other")
+ */
+const char *app_airtime_class_name(app_airtime_class_t airtimeClass);
+
+#ifdef __cplusplus
+}
+#endif
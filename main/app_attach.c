@@ -0,0 +1,214 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Rattachement rapide d'un enfant au parent mémorisé après redémarrage
+ */
+
+#include "app_attach.h"
+
+#include <string.h>
+
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_openthread_types.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_settings.h"
+
+#include "openthread/thread.h"
+
+#define TAG "app_attach"
+
+#define FAST_REJOIN_KEY "fast_rejoin"
+#define PARENT_KEY      "parent_ext"
+
+static app_attach_stats_t sStats;
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sFallbackTimer = NULL;
+static bool sFallbackTriggered = false;
+static bool sEventHandlerRegistered = false;
+
+bool app_attach_is_fast_rejoin_enabled(void)
+{
+    uint8_t value;
+
+    // Activé par défaut tant qu'aucune valeur n'est enregistrée
+    if (app_settings_get_u8(FAST_REJOIN_KEY, &value) != ESP_OK) {
+        return true;
+    }
+
+    return value != 0;
+}
+
+esp_err_t app_attach_set_fast_rejoin(bool enabled)
+{
+    return app_settings_set_u8(FAST_REJOIN_KEY, enabled ? 1 : 0);
+}
+
+// Compare les paramètres qui définissent le réseau, pas les TLV ajoutés par le leader
+static bool dataset_matches_locked(otInstance *instance, const otOperationalDataset *expected)
+{
+    otOperationalDataset active;
+
+    if (!otDatasetIsCommissioned(instance) || otDatasetGetActive(instance, &active) != OT_ERROR_NONE) {
+        return false;
+    }
+
+    return active.mComponents.mIsNetworkKeyPresent &&
+           memcmp(active.mNetworkKey.m8, expected->mNetworkKey.m8, sizeof(active.mNetworkKey.m8)) == 0 &&
+           active.mComponents.mIsExtendedPanIdPresent &&
+           memcmp(active.mExtendedPanId.m8, expected->mExtendedPanId.m8, sizeof(active.mExtendedPanId.m8)) == 0 &&
+           active.mComponents.mIsPanIdPresent && active.mPanId == expected->mPanId &&
+           active.mComponents.mIsChannelPresent && active.mChannel == expected->mChannel;
+}
+
+// Repli: le parent mémorisé n'a pas répondu à temps, lancer l'attachement complet
+static void fallback_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        esp_timer_start_once(sFallbackTimer, APP_LOCK_WAIT_MS * 1000);
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    otDeviceRole role = otThreadGetDeviceRole(sInstance);
+    if (role == OT_DEVICE_ROLE_DETACHED) {
+        ESP_LOGW(TAG, "Stored parent silent after %d ms, starting full attach", APP_ATTACH_FAST_REJOIN_TIMEOUT_MS);
+        sFallbackTriggered = true;
+        otError error = otThreadBecomeChild(sInstance);
+        if (error != OT_ERROR_NONE) {
+            ESP_LOGE(TAG, "Failed to start full attach: %d", error);
+        }
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_ATTACH, start);
+    esp_openthread_lock_release();
+}
+
+static void record_child_attached(void)
+{
+    otRouterInfo parentInfo;
+
+    if (!esp_openthread_lock_acquire(portMAX_DELAY)) {
+        return;
+    }
+
+    sStats.bootToChildUs = esp_timer_get_time();
+    sStats.rloc16 = otThreadGetRloc16(sInstance);
+    sStats.parentKnown = (otThreadGetParentInfo(sInstance, &parentInfo) == OT_ERROR_NONE);
+    // Aucune tentative d'attachement: le Child Update vers le parent mémorisé a suffi
+    uint16_t attachAttempts = otThreadGetMleCounters(sInstance)->mAttachAttempts;
+    esp_openthread_lock_release();
+
+    if (sFallbackTriggered) {
+        sStats.path = APP_ATTACH_PATH_FALLBACK;
+    } else if (attachAttempts == 0) {
+        sStats.path = APP_ATTACH_PATH_REATTACH;
+    } else {
+        sStats.path = APP_ATTACH_PATH_FULL;
+    }
+
+    if (sStats.parentKnown) {
+        memcpy(sStats.parentExtAddr, parentInfo.mExtAddress.m8, sizeof(sStats.parentExtAddr));
+        sStats.parentMatchesStored = sStats.storedParentValid &&
+                                     memcmp(sStats.parentExtAddr, sStats.storedParentExtAddr,
+                                            sizeof(sStats.parentExtAddr)) == 0;
+
+        // N'écrire en flash que si le parent a changé
+        if (!sStats.parentMatchesStored) {
+            app_settings_set_blob(PARENT_KEY, sStats.parentExtAddr, sizeof(sStats.parentExtAddr));
+        }
+    }
+
+    ESP_LOGI(TAG, "Boot to child: %lld ms via %s (rloc16 0x%04x, parent %s)",
+             sStats.bootToChildUs / 1000, app_attach_path_to_string(sStats.path), sStats.rloc16,
+             sStats.parentMatchesStored ? "unchanged" : "new");
+}
+
+static void role_changed_handler(void *arg, esp_event_base_t base, int32_t event_id, void *event_data)
+{
+    (void)arg;
+    (void)base;
+    (void)event_id;
+    const esp_openthread_role_changed_event_t *event = (const esp_openthread_role_changed_event_t *)event_data;
+
+    // Seul le premier passage en enfant après le démarrage est mesuré
+    if (event->current_role != OT_DEVICE_ROLE_CHILD || sStats.path != APP_ATTACH_PATH_NONE) {
+        return;
+    }
+
+    if (sFallbackTimer != NULL) {
+        esp_timer_stop(sFallbackTimer);
+    }
+
+    record_child_attached();
+}
+
+void app_attach_begin_locked(otInstance *instance, const otOperationalDataset *dataset)
+{
+    size_t length = sizeof(sStats.storedParentExtAddr);
+
+    sInstance = instance;
+    memset(&sStats, 0, sizeof(sStats));
+    sStats.fastRejoinEnabled = app_attach_is_fast_rejoin_enabled();
+    sStats.storedParentValid = (app_settings_get_blob(PARENT_KEY, sStats.storedParentExtAddr, &length) == ESP_OK &&
+                                length == sizeof(sStats.storedParentExtAddr));
+
+    if (sStats.fastRejoinEnabled && dataset_matches_locked(instance, dataset)) {
+        // Conserver le dataset et les informations parent restaurés par OpenThread
+        sStats.datasetReused = true;
+        ESP_LOGI(TAG, "Fast rejoin: reusing stored active dataset");
+    } else {
+        otError error = otDatasetSetActive(instance, dataset);
+        if (error != OT_ERROR_NONE) {
+            ESP_LOGE(TAG, "Failed to set active dataset: %d", error);
+        }
+    }
+
+    if (!sEventHandlerRegistered) {
+        ESP_ERROR_CHECK(esp_event_handler_register(OPENTHREAD_EVENT, OPENTHREAD_EVENT_ROLE_CHANGED,
+                                                   role_changed_handler, NULL));
+        sEventHandlerRegistered = true;
+    }
+
+    // Sans parent mémorisé, OpenThread lance directement l'attachement complet
+    if (!sStats.fastRejoinEnabled || !sStats.datasetReused) {
+        return;
+    }
+
+    if (sFallbackTimer == NULL) {
+        const esp_timer_create_args_t timerArgs = {
+            .callback = fallback_timer_cb,
+            .name = "attach_fallback",
+        };
+        ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sFallbackTimer));
+    }
+
+    esp_timer_start_once(sFallbackTimer, APP_ATTACH_FAST_REJOIN_TIMEOUT_MS * 1000ULL);
+}
+
+void app_attach_get_stats(app_attach_stats_t *outStats)
+{
+    *outStats = sStats;
+}
+
+const char *app_attach_path_to_string(app_attach_path_t path)
+{
+    switch (path) {
+    case APP_ATTACH_PATH_REATTACH:
+        return "reattach";
+    case APP_ATTACH_PATH_FULL:
+        return "full-attach";
+    case APP_ATTACH_PATH_FALLBACK:
+        return "fallback";
+    default:
+        return "none";
+    }
+}
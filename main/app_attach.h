@@ -0,0 +1,85 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Rattachement rapide d'un enfant au parent mémorisé après redémarrage
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/dataset.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Délai laissé au rattachement direct (Child Update vers le parent mémorisé)
+ * avant de basculer sur un attachement complet. Un parent présent répond en
+ * quelques dizaines de millisecondes; sans ce délai OpenThread insiste ~4 s.
+ */
+#define APP_ATTACH_FAST_REJOIN_TIMEOUT_MS 1500
+
+/** Chemin par lequel l'enfant a obtenu son rôle */
+typedef enum {
+    APP_ATTACH_PATH_NONE = 0,   // Pas encore enfant depuis le démarrage
+    APP_ATTACH_PATH_REATTACH,   // Child Update accepté par le parent mémorisé
+    APP_ATTACH_PATH_FULL,       // Attachement complet lancé par OpenThread
+    APP_ATTACH_PATH_FALLBACK,   // Attachement complet forcé après le délai rapide
+} app_attach_path_t;
+
+/** Statistiques du dernier rattachement, pour la commande « relay attach » */
+typedef struct {
+    bool fastRejoinEnabled;
+    bool datasetReused;
+    app_attach_path_t path;
+    int64_t bootToChildUs;
+    uint16_t rloc16;
+    bool parentKnown;
+    bool parentMatchesStored;
+    uint8_t parentExtAddr[8];
+    uint8_t storedParentExtAddr[8];
+    bool storedParentValid;
+} app_attach_stats_t;
+
+/**
+ * @brief Prépare le démarrage d'un enfant avant otThreadSetEnabled()
+ *
+ * En mode rapide, conserve le dataset actif déjà enregistré s'il correspond
+ * à celui attendu (le réécrire force OpenThread à oublier son parent), puis
+ * arme le délai de repli vers l'attachement complet.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param dataset Dataset attendu pour ce réseau
+ */
+void app_attach_begin_locked(otInstance *instance, const otOperationalDataset *dataset);
+
+/**
+ * @brief Active ou désactive le mode de rattachement rapide (persisté en NVS)
+ */
+esp_err_t app_attach_set_fast_rejoin(bool enabled);
+
+/**
+ * @brief Indique si le mode de rattachement rapide est actif
+ */
+bool app_attach_is_fast_rejoin_enabled(void);
+
+/**
+ * @brief Copie les statistiques du dernier rattachement
+ */
+void app_attach_get_stats(app_attach_stats_t *outStats);
+
+/**
+ * @brief Retourne le nom court d'un chemin de rattachement
+ */
+const char *app_attach_path_to_string(app_attach_path_t path);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,144 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Chronométrage des callbacks qui occupent la tâche OpenThread
+ */
+
+#include "app_cbwatch.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_cpu.h"
+#include "esp_log.h"
+#include "esp_rom_sys.h"
+#include "sdkconfig.h"
+
+#define TAG "app_cbwatch"
+
+static const char *const sNames[APP_CBWATCH_COUNT] = {
+    [APP_CBWATCH_UDP_COMMAND] = "udp cmd",
+    [APP_CBWATCH_UDP_PROBE] = "udp probe",
+    [APP_CBWATCH_UDP_FAILOVER] = "udp failover",
+    [APP_CBWATCH_UDP_TUNNEL] = "udp tunnel",
+    [APP_CBWATCH_UDP_REGISTRY] = "udp registry",
+    [APP_CBWATCH_DNS] = "dns",
+    [APP_CBWATCH_NETDIAG] = "netdiag",
+    [APP_CBWATCH_SNIFFER] = "sniffer",
+    [APP_CBWATCH_CLI] = "cli relay",
+    [APP_CBWATCH_TICK_AIRTIME] = "tick airtime",
+    [APP_CBWATCH_TICK_ATTACH] = "tick attach",
+    [APP_CBWATCH_TICK_COALESCE] = "tick coalesce",
+    [APP_CBWATCH_TICK_COEX] = "tick coex",
+    [APP_CBWATCH_TICK_DISCOVERY] = "tick discovery",
+    [APP_CBWATCH_TICK_FAILOVER] = "tick failover",
+    [APP_CBWATCH_TICK_NETDIAG] = "tick netdiag",
+    [APP_CBWATCH_TICK_REGISTRY] = "tick registry",
+    [APP_CBWATCH_TICK_RETRY] = "tick retry",
+    [APP_CBWATCH_TICK_SCHED] = "tick sched",
+    [APP_CBWATCH_TICK_SUPERVISION] = "tick supervision",
+    [APP_CBWATCH_TICK_TXPOWER] = "tick txpower",
+};
+
+/** Callback de réception réel d'un socket ouvert par app_cbwatch_udp_open_locked() */
+typedef struct {
+    otUdpReceive handler;
+    void *context;
+} watched_udp_t;
+
+static app_cbwatch_stats_t sStats[APP_CBWATCH_COUNT];
+static watched_udp_t sUdpHandlers[APP_CBWATCH_COUNT];
+static uint32_t sBudgetUs = CONFIG_APP_CBWATCH_BUDGET_US;
+
+static int bucket_of(uint32_t us)
+{
+    int bucket = 0;
+    uint32_t limit = APP_CBWATCH_FIRST_BUCKET_US;
+
+    while (bucket < APP_CBWATCH_BUCKETS - 1 && us >= limit) {
+        limit <<= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+uint32_t app_cbwatch_begin(void)
+{
+    return esp_cpu_get_cycle_count();
+}
+
+void app_cbwatch_end_locked(app_cbwatch_id_t id, uint32_t startCycles)
+{
+    // Différence sur 32 bits: juste tant que le callback dure moins d'un tour du compteur (~26 s à 160 MHz)
+    uint32_t cycles = esp_cpu_get_cycle_count() - startCycles;
+    uint32_t us = cycles / esp_rom_get_cpu_ticks_per_us();
+    app_cbwatch_stats_t *stats = &sStats[id];
+
+    stats->runs++;
+    stats->totalUs += us;
+    stats->histogram[bucket_of(us)]++;
+    if (us > stats->maxUs) {
+        stats->maxUs = us;
+    }
+
+    if (us <= sBudgetUs) {
+        return;
+    }
+
+    stats->overruns++;
+    ESP_LOGW(TAG, "%s took %lu us (budget %lu us)", sNames[id], (unsigned long)us, (unsigned long)sBudgetUs);
+#if CONFIG_APP_CBWATCH_TRAP
+    // Arrêt au premier dépassement: le backtrace désigne l'appelant du callback fautif
+    ESP_LOGE(TAG, "Callback budget exceeded, aborting");
+    abort();
+#endif
+}
+
+static void watched_udp_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    app_cbwatch_id_t id = (app_cbwatch_id_t)(uintptr_t)aContext;
+    uint32_t start = app_cbwatch_begin();
+
+    sUdpHandlers[id].handler(sUdpHandlers[id].context, aMessage, aMessageInfo);
+    app_cbwatch_end_locked(id, start);
+}
+
+otError app_cbwatch_udp_open_locked(otInstance *instance, otUdpSocket *socket, otUdpReceive handler, void *context,
+                                    app_cbwatch_id_t id)
+{
+    sUdpHandlers[id].handler = handler;
+    sUdpHandlers[id].context = context;
+    return otUdpOpen(instance, socket, watched_udp_receive, (void *)(uintptr_t)id);
+}
+
+uint32_t app_cbwatch_get_budget_us(void)
+{
+    return sBudgetUs;
+}
+
+void app_cbwatch_set_budget_us(uint32_t budgetUs)
+{
+    sBudgetUs = budgetUs;
+}
+
+void app_cbwatch_get_stats_locked(app_cbwatch_id_t id, app_cbwatch_stats_t *outStats)
+{
+    *outStats = sStats[id];
+}
+
+void app_cbwatch_reset_locked(void)
+{
+    memset(sStats, 0, sizeof(sStats));
+}
+
+const char *app_cbwatch_name(app_cbwatch_id_t id)
+{
+    return (id < APP_CBWATCH_COUNT) ? sNames[id] : "?";
+}
+
+uint32_t app_cbwatch_bucket_limit_us(int bucket)
+{
+    return (bucket < APP_CBWATCH_BUCKETS - 1) ? (uint32_t)APP_CBWATCH_FIRST_BUCKET_US << bucket : 0;
+}
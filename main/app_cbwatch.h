@@ -0,0 +1,134 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Chronométrage des callbacks qui occupent la tâche OpenThread
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/udp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Classes de l'histogramme: < 16 us, < 32 us, ... < 16 ms, puis 16 ms et plus */
+#define APP_CBWATCH_BUCKETS 12
+
+/** Borne haute de la première classe de l'histogramme */
+#define APP_CBWATCH_FIRST_BUCKET_US 16
+
+/** Budget maximal accepté: au-delà, plus aucun callback ne serait signalé */
+#define APP_CBWATCH_MAX_BUDGET_US 1000000
+
+/**
+ * @brief Callbacks chronométrés
+ *
+ * Les réceptions UDP, les réponses DNS et de diagnostic, les trames
+ * capturées et les commandes « relay » s'exécutent sur la tâche OpenThread;
+ * les ticks esp_timer tiennent son verrou et la bloquent tout autant.
+ */
+typedef enum {
+    APP_CBWATCH_UDP_COMMAND = 0,
+    APP_CBWATCH_UDP_PROBE,
+    APP_CBWATCH_UDP_FAILOVER,
+    APP_CBWATCH_UDP_TUNNEL,
+    APP_CBWATCH_UDP_REGISTRY,
+    APP_CBWATCH_DNS,
+    APP_CBWATCH_NETDIAG,
+    APP_CBWATCH_SNIFFER,
+    APP_CBWATCH_CLI,
+    APP_CBWATCH_TICK_AIRTIME,
+    APP_CBWATCH_TICK_ATTACH,
+    APP_CBWATCH_TICK_COALESCE,
+    APP_CBWATCH_TICK_COEX,
+    APP_CBWATCH_TICK_DISCOVERY,
+    APP_CBWATCH_TICK_FAILOVER,
+    APP_CBWATCH_TICK_NETDIAG,
+    APP_CBWATCH_TICK_REGISTRY,
+    APP_CBWATCH_TICK_RETRY,
+    APP_CBWATCH_TICK_SCHED,
+    APP_CBWATCH_TICK_SUPERVISION,
+    APP_CBWATCH_TICK_TXPOWER,
+    APP_CBWATCH_COUNT,
+} app_cbwatch_id_t;
+
+/** Mesures d'un callback (depuis le démarrage ou la dernière remise à zéro) */
+typedef struct {
+    uint32_t runs;
+    uint32_t overruns;
+    uint32_t maxUs;
+    uint64_t totalUs;
+    uint32_t histogram[APP_CBWATCH_BUCKETS];
+} app_cbwatch_stats_t;
+
+/**
+ * @brief Relève le compteur de cycles au début d'un callback
+ *
+ * @return Valeur à passer à app_cbwatch_end_locked()
+ */
+uint32_t app_cbwatch_begin(void);
+
+/**
+ * @brief Comptabilise la durée d'un callback (verrou OpenThread tenu)
+ *
+ * Un dépassement du budget est journalisé avec sa durée; avec
+ * CONFIG_APP_CBWATCH_TRAP, il arrête le nœud (panic et backtrace).
+ *
+ * @param id Callback mesuré
+ * @param startCycles Valeur rendue par app_cbwatch_begin()
+ */
+void app_cbwatch_end_locked(app_cbwatch_id_t id, uint32_t startCycles);
+
+/**
+ * @brief Ouvre un socket UDP dont le callback de réception est chronométré
+ *
+ * Remplace otUdpOpen(): handler est appelé avec context, entre
+ * app_cbwatch_begin() et app_cbwatch_end_locked(id). Un seul socket par id.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @return Erreur de otUdpOpen()
+ */
+otError app_cbwatch_udp_open_locked(otInstance *instance, otUdpSocket *socket, otUdpReceive handler, void *context,
+                                    app_cbwatch_id_t id);
+
+/**
+ * @brief Retourne le budget courant en microsecondes
+ */
+uint32_t app_cbwatch_get_budget_us(void);
+
+/**
+ * @brief Change le budget (CONFIG_APP_CBWATCH_BUDGET_US au démarrage)
+ *
+ * @param budgetUs De 1 à APP_CBWATCH_MAX_BUDGET_US
+ */
+void app_cbwatch_set_budget_us(uint32_t budgetUs);
+
+/**
+ * @brief Copie les mesures d'un callback (verrou OpenThread tenu)
+ */
+void app_cbwatch_get_stats_locked(app_cbwatch_id_t id, app_cbwatch_stats_t *outStats);
+
+/**
+ * @brief Remet toutes les mesures à zéro (verrou OpenThread tenu)
+ */
+void app_cbwatch_reset_locked(void);
+
+/**
+ * @brief Nom court d'un callback ("udp cmd", "tick sched"...)
+ */
+const char *app_cbwatch_name(app_cbwatch_id_t id);
+
+/**
+ * @brief Borne haute d'une classe de l'histogramme en microsecondes (0 pour la dernière)
+ */
+uint32_t app_cbwatch_bucket_limit_us(int bucket);
+
+#ifdef __cplusplus
+}
+#endif
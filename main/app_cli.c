@@ -0,0 +1,921 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Commandes CLI de l'application (« relay <sous-commande> »)
+ */
+
+#include "app_cli.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "app_actuator.h"
+#include "app_addr.h"
+#include "app_airtime.h"
+#include "app_attach.h"
+#include "app_cbwatch.h"
+#include "app_coalesce.h"
+#include "app_coex.h"
+#include "app_discovery.h"
+#include "app_failover.h"
+#include "app_ingress.h"
+#include "app_load.h"
+#include "app_netdiag.h"
+#include "app_pack.h"
+#include "app_probe.h"
+#include "app_registry.h"
+#include "app_retry.h"
+#include "app_role.h"
+#include "app_sched.h"
+#include "app_sniffer.h"
+#include "app_supervision.h"
+#include "app_tunnel.h"
+#include "app_txpower.h"
+
+#include "openthread/cli.h"
+#include "openthread/thread.h"
+
+#define TAG "app_cli"
+#define COMMAND_PORT 12345
+
+typedef otError (*app_cli_handler_t)(otInstance *instance, uint8_t argc, char *argv[]);
+
+typedef struct {
+    const char *name;
+    app_cli_handler_t handler;
+    const char *usage;
+} app_cli_subcommand_t;
+
+// relay actuator
+static otError cli_actuator(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_actuator_stats_t stats;
+
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_actuator_get_stats(&stats);
+    otCliOutputFormat("restored at boot: %s\r\n", stats.restored ? "yes" : "no");
+    otCliOutputFormat("changes: %lu, nvs writes: %lu, unchanged batches: %lu, failures: %lu\r\n",
+                      (unsigned long)stats.changes, (unsigned long)stats.writes, (unsigned long)stats.unchanged,
+                      (unsigned long)stats.failures);
+    return OT_ERROR_NONE;
+}
+
+// relay airtime
+static otError cli_airtime(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_airtime_window_t window;
+    (void)instance;
+    (void)argv;
+
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_airtime_get_window_locked(&window);
+    if (window.windowS == 0) {
+        otCliOutputFormat("no window yet (%u s)\r\n", APP_AIRTIME_WINDOW_S);
+        return OT_ERROR_NONE;
+    }
+
+    otCliOutputFormat("last %lu s: tx %lu, rx %lu, retries %lu, tx failures %lu, cca failures %lu\r\n",
+                      (unsigned long)window.windowS, (unsigned long)window.txFrames, (unsigned long)window.rxFrames,
+                      (unsigned long)window.retries, (unsigned long)window.txFailures,
+                      (unsigned long)window.ccaFailures);
+    otCliOutputFormat("mle: %lu attach attempts, %lu parent changes, %lu partition changes\r\n",
+                      (unsigned long)window.attachAttempts, (unsigned long)window.parentChanges,
+                      (unsigned long)window.partitionChanges);
+    for (int i = 0; i < APP_AIRTIME_CLASS_COUNT; i++) {
+        otCliOutputFormat("app %s: %lu frames, %lu us\r\n", app_airtime_class_name((app_airtime_class_t)i),
+                          (unsigned long)window.appFrames[i], (unsigned long)window.appAirtimeUs[i]);
+    }
+    otCliOutputFormat("retries: %lu us, polls: %lu (%lu us), beacons: %lu (%lu us), stack: %lu (%lu us)\r\n",
+                      (unsigned long)window.retryAirtimeUs, (unsigned long)window.polls,
+                      (unsigned long)window.pollAirtimeUs, (unsigned long)window.beacons,
+                      (unsigned long)window.beaconAirtimeUs, (unsigned long)window.stackFrames,
+                      (unsigned long)window.stackAirtimeUs);
+    otCliOutputFormat("rx: %lu us, channel %u/1000 busy, cca failure rate %u/1000\r\n",
+                      (unsigned long)window.rxAirtimeUs, window.utilisationPermille, window.ccaFailurePermille);
+    if (window.extraDevices >= 0) {
+        otCliOutputFormat("%u children, room for %ld more at the current rate (ceiling %u%%)\r\n", window.children,
+                          (long)window.extraDevices, APP_AIRTIME_CEILING_PERCENT);
+    } else {
+        otCliOutputFormat("%u children, headroom unknown (no children or no application traffic)\r\n", window.children);
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay role [reed|fed|med|sed]
+static otError cli_role(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_role_policy_t policy;
+
+    if (argc == 0) {
+        otCliOutputFormat("%s\r\n", app_role_policy_to_string(app_role_policy_load()));
+        return OT_ERROR_NONE;
+    }
+
+    if (!app_role_policy_from_string(argv[0], &policy)) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    if (app_role_policy_save(policy) != ESP_OK) {
+        return OT_ERROR_FAILED;
+    }
+
+    // Le leader reste un FTD: la politique sera appliquée au prochain démarrage en enfant
+    if (app_node_role_get() != APP_NODE_ROLE_END_DEVICE) {
+        return OT_ERROR_NONE;
+    }
+
+    return app_role_policy_apply_locked(instance, policy);
+}
+
+// relay cbwatch [reset | budget <us>]
+static otError cli_cbwatch(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_cbwatch_stats_t stats;
+    char *end;
+
+    if (argc == 1 && strcmp(argv[0], "reset") == 0) {
+        app_cbwatch_reset_locked();
+        return OT_ERROR_NONE;
+    }
+    if (argc == 2 && strcmp(argv[0], "budget") == 0) {
+        unsigned long budgetUs = strtoul(argv[1], &end, 0);
+        if (*end != '\0' || budgetUs == 0 || budgetUs > APP_CBWATCH_MAX_BUDGET_US) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        app_cbwatch_set_budget_us((uint32_t)budgetUs);
+        return OT_ERROR_NONE;
+    }
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    otCliOutputFormat("budget %lu us\r\n", (unsigned long)app_cbwatch_get_budget_us());
+    otCliOutputFormat("| Callback         |  Runs | Over | Max us | Avg us |");
+    for (int bucket = 0; bucket < APP_CBWATCH_BUCKETS; bucket++) {
+        uint32_t limitUs = app_cbwatch_bucket_limit_us(bucket);
+        if (limitUs == 0) {
+            otCliOutputFormat("  more |");
+        } else if (limitUs < 1000) {
+            otCliOutputFormat(" <%3luu |", (unsigned long)limitUs);
+        } else {
+            otCliOutputFormat(" <%3lum |", (unsigned long)(limitUs / 1000));
+        }
+    }
+    otCliOutputFormat("\r\n");
+
+    for (int id = 0; id < APP_CBWATCH_COUNT; id++) {
+        app_cbwatch_get_stats_locked((app_cbwatch_id_t)id, &stats);
+        if (stats.runs == 0) {
+            continue;
+        }
+        otCliOutputFormat("| %-16s | %5lu | %4lu | %6lu | %6lu |", app_cbwatch_name((app_cbwatch_id_t)id),
+                          (unsigned long)stats.runs, (unsigned long)stats.overruns, (unsigned long)stats.maxUs,
+                          (unsigned long)(stats.totalUs / stats.runs));
+        for (int bucket = 0; bucket < APP_CBWATCH_BUCKETS; bucket++) {
+            otCliOutputFormat(" %5lu |", (unsigned long)stats.histogram[bucket]);
+        }
+        otCliOutputFormat("\r\n");
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay coex [off|control]
+static otError cli_coex(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_coex_mode_t mode;
+    app_coex_stats_t stats;
+
+    if (argc > 1) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    if (argc == 1) {
+        if (!app_coex_mode_from_string(argv[0], &mode)) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        return (app_coex_mode_set(mode) == ESP_OK) ? OT_ERROR_NONE : OT_ERROR_FAILED;
+    }
+
+    app_coex_get_stats(&stats);
+    otCliOutputFormat("mode: %s\r\n", app_coex_mode_to_string(app_coex_mode_get()));
+    otCliOutputFormat("tx attempts: %lu\r\n", (unsigned long)stats.txAttempts);
+    otCliOutputFormat("grants: %lu\r\n", (unsigned long)stats.grants);
+    otCliOutputFormat("denials: %lu (last period %u%%)\r\n", (unsigned long)stats.denials, stats.denialPercent);
+    otCliOutputFormat("cca failures: %lu\r\n", (unsigned long)stats.ccaFailures);
+    otCliOutputFormat("control windows: %lu\r\n", (unsigned long)stats.controlWindows);
+    otCliOutputFormat("bulk deferred: %lu\r\n", (unsigned long)stats.bulkDeferred);
+    return OT_ERROR_NONE;
+}
+
+// relay retry [off|adaptive]
+static otError cli_retry(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_retry_mode_t mode;
+    app_retry_status_t status;
+    app_retry_link_t link;
+    (void)instance;
+
+    if (argc > 1) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    if (argc == 1) {
+        if (!app_retry_mode_from_string(argv[0], &mode)) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        return (app_retry_mode_set_locked(mode) == ESP_OK) ? OT_ERROR_NONE : OT_ERROR_FAILED;
+    }
+
+    app_retry_get_status_locked(&status);
+    otCliOutputFormat("mode: %s\r\n", app_retry_mode_to_string(app_retry_mode_get()));
+    otCliOutputFormat("direct retries: %u (stack %u), indirect retries: %u (stack %u), %lu changes\r\n",
+                      status.direct, status.defaultDirect, status.indirect, status.defaultIndirect,
+                      (unsigned long)status.changes);
+    otCliOutputFormat("links: %u, marginal %u, poor %u\r\n", status.links, status.marginalLinks, status.poorLinks);
+    for (uint16_t index = 0; app_retry_get_link_locked(index, &link); index++) {
+        otCliOutputFormat("0x%04x %s %s: frame errors %u/1000, message errors %u/1000, needs %u retries\r\n",
+                          link.rloc16, link.indirect ? "indirect" : "direct", app_retry_link_class_name(link.linkClass),
+                          link.frameErrorPermille, link.messageErrorPermille, link.neededRetries);
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay txpower [off|adaptive]
+static otError cli_txpower(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_txpower_mode_t mode;
+    app_txpower_status_t status;
+    (void)instance;
+
+    if (argc > 1) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    if (argc == 1) {
+        if (!app_txpower_mode_from_string(argv[0], &mode)) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        esp_err_t err = app_txpower_mode_set_locked(mode);
+        if (err == ESP_ERR_INVALID_STATE) {
+            return OT_ERROR_INVALID_STATE;
+        }
+        return (err == ESP_OK) ? OT_ERROR_NONE : OT_ERROR_FAILED;
+    }
+
+    app_txpower_get_status_locked(&status);
+    otCliOutputFormat("mode: %s\r\n", app_txpower_mode_to_string(app_txpower_mode_get()));
+    otCliOutputFormat("power: %d dBm (configured %d, floor %d), %lu steps down, %lu steps up\r\n", status.powerDbm,
+                      status.maxDbm, APP_TXPOWER_MIN_DBM, (unsigned long)status.stepsDown,
+                      (unsigned long)status.stepsUp);
+    otCliOutputFormat("links: %u, worst margin %d dB (target %d), errors %u/1000\r\n", status.links,
+                      status.worstMarginDb, APP_TXPOWER_TARGET_MARGIN_DB, status.errorPermille);
+    otCliOutputFormat("last %u s: %lu attempts, %lu frames delivered, %lu/%lu commands delivered, %lu uJ\r\n",
+                      APP_TXPOWER_PERIOD_S, (unsigned long)status.txAttempts, (unsigned long)status.deliveredFrames,
+                      (unsigned long)status.deliveredCommands, (unsigned long)status.commands,
+                      (unsigned long)status.energyUj);
+    if (status.totalDeliveredFrames > 0) {
+        otCliOutputFormat("since mode change: %lu uJ per delivered frame",
+                          (unsigned long)(status.totalEnergyUj / status.totalDeliveredFrames));
+        if (status.totalDeliveredCommands > 0) {
+            otCliOutputFormat(", %lu uJ per delivered command",
+                              (unsigned long)(status.totalEnergyUj / status.totalDeliveredCommands));
+        }
+        otCliOutputFormat("\r\n");
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay failover
+static otError cli_failover(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_failover_status_t status;
+
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_failover_get_status(&status);
+    otCliOutputFormat("host link: %s\r\n", app_failover_state_to_string(status.state));
+    otCliOutputFormat("seq: %lu\r\n", (unsigned long)status.seq);
+    if (status.lastHeartbeatAgeMs >= 0) {
+        otCliOutputFormat("last peer heartbeat: %lld ms ago\r\n", status.lastHeartbeatAgeMs);
+    }
+    otCliOutputFormat("takeovers: %lu\r\n", (unsigned long)status.takeovers);
+    if (status.takeovers > 0) {
+        otCliOutputFormat("last failover: %lu ms, replayed chunks: %lu\r\n", (unsigned long)status.lastFailoverMs,
+                          (unsigned long)status.replayedChunks);
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay ingress
+static otError cli_ingress(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_ingress_counters_t counters;
+
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    // Les liens hôte ne tournent que sur le leader et le nœud de secours
+    if (app_node_role_get() == APP_NODE_ROLE_END_DEVICE) {
+        return OT_ERROR_INVALID_STATE;
+    }
+
+    otCliOutputFormat("| Link  | Rx bytes | Rx frames | Dispatched | Dropped | Max depth |\r\n");
+    for (int channel = 0; channel < APP_INGRESS_CHANNEL_COUNT; channel++) {
+        app_ingress_get_counters((app_ingress_channel_t)channel, &counters);
+        otCliOutputFormat("| %-5s | %8lu | %9lu | %10lu | %7lu | %9lu |\r\n",
+                          app_ingress_channel_name((app_ingress_channel_t)channel), (unsigned long)counters.rxBytes,
+                          (unsigned long)counters.rxFrames, (unsigned long)counters.dispatched,
+                          (unsigned long)counters.dropped, (unsigned long)counters.maxQueueDepth);
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay discover
+static otError cli_discover(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_discovery_stats_t stats;
+    app_discovery_service_t service;
+    (void)instance;
+    (void)argv;
+
+    if (argc > 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_discovery_get_stats_locked(&stats);
+    if (!stats.supported) {
+        otCliOutputFormat("discovery disabled (SRP or DNS client off)\r\n");
+        return OT_ERROR_NONE;
+    }
+
+    otCliOutputFormat("services: %u cached, %lu browses, %lu resolves, %lu failures, %lu expired\r\n", stats.cached,
+                      (unsigned long)stats.browses, (unsigned long)stats.resolves, (unsigned long)stats.failures,
+                      (unsigned long)stats.expired);
+    for (uint16_t index = 0; app_discovery_get_by_index_locked(index, &service); index++) {
+        char addrStr[OT_IP6_ADDRESS_STRING_SIZE];
+        otIp6AddressToString(&service.address, addrStr, sizeof(addrStr));
+        otCliOutputFormat("%s id %u [%s]:%u ttl %lu s pins %s caps %s\r\n", service.instance, service.id, addrStr,
+                          service.port, (unsigned long)service.ttlLeftS, service.pins, service.caps);
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay load [burst [count] [payload]]
+static otError cli_load(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_load_usage_t usage;
+    unsigned long values[2] = {APP_PROBE_DEFAULT_BURST, 0};
+    char *end;
+
+    if (argc > 0) {
+        if (strcmp(argv[0], "burst") != 0 || argc > 3) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        for (uint8_t i = 1; i < argc; i++) {
+            values[i - 1] = strtoul(argv[i], &end, 0);
+            if (*end != '\0') {
+                return OT_ERROR_INVALID_ARGS;
+            }
+        }
+        if (values[0] == 0 || values[0] > UINT16_MAX || values[1] > APP_PROBE_MAX_PAYLOAD) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+
+        otError error = app_probe_burst_start(instance, (uint16_t)values[0], (uint16_t)values[1]);
+        if (error == OT_ERROR_NONE) {
+            otCliOutputFormat("burst started, results in log\r\n");
+        }
+        return error;
+    }
+
+    app_load_get_usage_locked(instance, &usage);
+    otCliOutputFormat("profile: %s\r\n", usage.profile);
+    otCliOutputFormat("task queue: %u, netif queue: %u\r\n", usage.taskQueueSize, usage.netifQueueSize);
+    otCliOutputFormat("message buffers: %u total, %u free, %u max used\r\n", usage.totalBuffers,
+                      usage.freeBuffers, usage.maxUsedBuffers);
+    otCliOutputFormat("ram: %lu B pool, %lu B heap at start\r\n", (unsigned long)usage.poolBytes,
+                      (unsigned long)usage.startHeapBytes);
+    otCliOutputFormat("ip6 failures: tx %lu, rx %lu\r\n", (unsigned long)usage.ip6TxFailures,
+                      (unsigned long)usage.ip6RxFailures);
+    return OT_ERROR_NONE;
+}
+
+// relay netdiag
+static otError cli_netdiag(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_netdiag_stats_t stats;
+    app_netdiag_node_t node;
+    (void)instance;
+    (void)argv;
+
+    if (argc > 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_netdiag_get_stats_locked(&stats);
+    otCliOutputFormat("routers: %u, %lu queries, %lu responses, %lu failures, last sweep %lu ms\r\n", stats.routers,
+                      (unsigned long)stats.queries, (unsigned long)stats.responses, (unsigned long)stats.failures,
+                      (unsigned long)stats.lastSweepMs);
+    otCliOutputFormat("airtime: %lu ms, %u/1000 of the channel (limit %u/1000)\r\n", (unsigned long)stats.airtimeMs,
+                      stats.airtimePermille, APP_NETDIAG_AIRTIME_PERMILLE);
+    otCliOutputFormat("stream: %s, %lu records, %lu bytes, %lu drops\r\n", stats.subscribed ? "on" : "off",
+                      (unsigned long)stats.records, (unsigned long)stats.streamBytes, (unsigned long)stats.streamDrops);
+
+    for (uint16_t index = 0; app_netdiag_get_by_index_locked(index, &node); index++) {
+        otCliOutputFormat("0x%04x age %lu s, %u children, tx %lu rx %lu, errors in %lu out %lu, neighbors:",
+                          node.rloc16, (unsigned long)node.ageS, node.childCount, (unsigned long)node.macCounters[6],
+                          (unsigned long)node.macCounters[3], (unsigned long)node.macCounters[1],
+                          (unsigned long)node.macCounters[2]);
+        for (int i = 0; i < node.routeCount; i++) {
+            if (node.routes[i].linkQualityIn > 0 || node.routes[i].linkQualityOut > 0) {
+                otCliOutputFormat(" %u(lq %u/%u)", node.routes[i].routerId, node.routes[i].linkQualityIn,
+                                  node.routes[i].linkQualityOut);
+            }
+        }
+        otCliOutputFormat("\r\n");
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay pack
+static otError cli_pack(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_pack_stats_t stats;
+    app_addr_selection_t selection;
+    app_coalesce_stats_t coalesce;
+    (void)argv;
+
+    if (argc > 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    // Budgets par forme d'adresse, sur le port des commandes
+    const otIp6Address *rloc = otThreadGetRloc(instance);
+    const otIp6Address *mleid = otThreadGetMeshLocalEid(instance);
+    otCliOutputFormat("budget rloc: %u direct, %u multi-hop\r\n",
+                      app_pack_budget_locked(instance, rloc, COMMAND_PORT, COMMAND_PORT, false),
+                      app_pack_budget_locked(instance, rloc, COMMAND_PORT, COMMAND_PORT, true));
+    otCliOutputFormat("budget ml-eid: %u direct, %u multi-hop\r\n",
+                      app_pack_budget_locked(instance, mleid, COMMAND_PORT, COMMAND_PORT, false),
+                      app_pack_budget_locked(instance, mleid, COMMAND_PORT, COMMAND_PORT, true));
+
+    app_addr_get_last_selection(&selection);
+    if (selection.valid) {
+        otCliOutputFormat("child 0x%04x: %s address, %u header bytes saved per frame\r\n", selection.rloc16,
+                          app_addr_form_name(selection.form), selection.savedBytes);
+    }
+
+    app_pack_get_stats(&stats);
+    otCliOutputFormat("sent: %lu datagrams, %lu commands, %lu bytes, last budget %u\r\n",
+                      (unsigned long)stats.datagrams, (unsigned long)stats.frames, (unsigned long)stats.bytes,
+                      stats.lastBudget);
+    otCliOutputFormat("oversize (fragmented): %lu\r\n", (unsigned long)stats.oversize);
+
+    app_coalesce_get_stats_locked(&coalesce);
+    otCliOutputFormat("queue: %lu commands, %lu superseded, %lu datagrams (%lu held, %lu sleepy), %u pending\r\n",
+                      (unsigned long)coalesce.submitted, (unsigned long)coalesce.superseded,
+                      (unsigned long)coalesce.flushes, (unsigned long)coalesce.heldFlushes,
+                      (unsigned long)coalesce.sleepyFlushes, coalesce.pendingDests);
+    otCliOutputFormat("queue max depth %u, max hold %lu ms\r\n", coalesce.maxDepth,
+                      (unsigned long)coalesce.maxHoldMs);
+    otCliOutputFormat("queue send retries %lu, dropped %lu\r\n", (unsigned long)coalesce.retries,
+                      (unsigned long)coalesce.dropped);
+    return OT_ERROR_NONE;
+}
+
+// relay node [leader|child|standby|sniffer|auto]
+static otError cli_node(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_node_role_t role;
+
+    if (argc == 0) {
+        otCliOutputFormat("%s (%s)\r\n", app_node_role_to_string(app_node_role_get()),
+                          (app_node_role_get_source() == APP_NODE_ROLE_SOURCE_NVS) ? "nvs" : "strap");
+        return OT_ERROR_NONE;
+    }
+
+    if (strcmp(argv[0], "auto") == 0) {
+        if (app_node_role_clear() != ESP_OK) {
+            return OT_ERROR_FAILED;
+        }
+    } else if (!app_node_role_from_string(argv[0], &role)) {
+        return OT_ERROR_INVALID_ARGS;
+    } else if (app_node_role_save(role) != ESP_OK) {
+        return OT_ERROR_FAILED;
+    }
+
+    otCliOutputFormat("node role saved, reboot to apply\r\n");
+    return OT_ERROR_NONE;
+}
+
+// relay sniffer [channel <11-26>]
+static otError cli_sniffer(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_sniffer_stats_t stats;
+    (void)instance;
+
+    if (argc == 2 && strcmp(argv[0], "channel") == 0) {
+        long channel = strtol(argv[1], NULL, 10);
+        if (channel < APP_SNIFFER_CHANNEL_MIN || channel > APP_SNIFFER_CHANNEL_MAX) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        return (app_sniffer_set_channel_locked((uint8_t)channel) == ESP_OK) ? OT_ERROR_NONE : OT_ERROR_FAILED;
+    }
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_sniffer_get_stats_locked(&stats);
+    if (!stats.running) {
+        otCliOutputFormat("not running (relay node sniffer, then reboot)\r\n");
+        return OT_ERROR_NONE;
+    }
+    otCliOutputFormat("channel %u, %lu frames (%lu own tx), %lu bytes, %lu drops, %lu sections\r\n", stats.channel,
+                      (unsigned long)stats.frames, (unsigned long)stats.txFrames, (unsigned long)stats.bytes,
+                      (unsigned long)stats.drops, (unsigned long)stats.sections);
+    return OT_ERROR_NONE;
+}
+
+// relay registry
+static otError cli_registry(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_registry_stats_t stats;
+    app_registry_entry_t entry;
+    uint32_t nowS = (uint32_t)(esp_timer_get_time() / 1000000);
+    (void)instance;
+    (void)argv;
+
+    if (argc > 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_registry_get_stats_locked(&stats);
+    otCliOutputFormat("own id: %u\r\n", stats.ownId);
+    if (app_failover_is_started() && !app_failover_is_active()) {
+        otCliOutputFormat("synced from active node: %u ids\r\n", stats.syncedIds);
+    }
+    otCliOutputFormat("devices: %u/%u, announces %lu, lookups %lu, misses %lu, max probe %u\r\n", stats.devices,
+                      APP_REGISTRY_MAX_DEVICES, (unsigned long)stats.announces, (unsigned long)stats.lookups,
+                      (unsigned long)stats.misses, stats.maxProbe);
+    if (stats.devices == 0) {
+        return OT_ERROR_NONE;
+    }
+
+    otCliOutputFormat("|  ID | EUI-64           | RLOC16 | Age (s) |\r\n");
+    otCliOutputFormat("+-----+------------------+--------+---------+\r\n");
+    for (uint16_t index = 0; app_registry_get_by_index_locked(index, &entry); index++) {
+        if (!entry.located) {
+            otCliOutputFormat("| %3u | %02x%02x%02x%02x%02x%02x%02x%02x |      - |       - |\r\n", entry.id,
+                              entry.eui64[0], entry.eui64[1], entry.eui64[2], entry.eui64[3], entry.eui64[4],
+                              entry.eui64[5], entry.eui64[6], entry.eui64[7]);
+            continue;
+        }
+        otCliOutputFormat("| %3u | %02x%02x%02x%02x%02x%02x%02x%02x | 0x%04x | %7lu |\r\n", entry.id, entry.eui64[0],
+                          entry.eui64[1], entry.eui64[2], entry.eui64[3], entry.eui64[4], entry.eui64[5],
+                          entry.eui64[6], entry.eui64[7], entry.rloc16, (unsigned long)(nowS - entry.lastSeenS));
+    }
+    return OT_ERROR_NONE;
+}
+
+static void output_ext_addr(const char *label, const uint8_t *extAddr)
+{
+    otCliOutputFormat("%s: %02x%02x%02x%02x%02x%02x%02x%02x\r\n", label, extAddr[0], extAddr[1], extAddr[2],
+                      extAddr[3], extAddr[4], extAddr[5], extAddr[6], extAddr[7]);
+}
+
+// relay attach [fast on|off]
+static otError cli_attach(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_attach_stats_t stats;
+
+    if (argc == 2 && strcmp(argv[0], "fast") == 0) {
+        bool enabled;
+        if (strcmp(argv[1], "on") == 0) {
+            enabled = true;
+        } else if (strcmp(argv[1], "off") == 0) {
+            enabled = false;
+        } else {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        return (app_attach_set_fast_rejoin(enabled) == ESP_OK) ? OT_ERROR_NONE : OT_ERROR_FAILED;
+    }
+
+    if (argc != 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_attach_get_stats(&stats);
+    otCliOutputFormat("fast rejoin: %s (applies at boot)\r\n", app_attach_is_fast_rejoin_enabled() ? "on" : "off");
+    otCliOutputFormat("dataset reused: %s\r\n", stats.datasetReused ? "yes" : "no");
+    otCliOutputFormat("path: %s\r\n", app_attach_path_to_string(stats.path));
+    if (stats.path == APP_ATTACH_PATH_NONE) {
+        return OT_ERROR_NONE;
+    }
+
+    otCliOutputFormat("boot to child: %lld ms\r\n", stats.bootToChildUs / 1000);
+    otCliOutputFormat("rloc16: 0x%04x\r\n", stats.rloc16);
+    if (stats.parentKnown) {
+        output_ext_addr("parent", stats.parentExtAddr);
+    }
+    if (stats.storedParentValid) {
+        output_ext_addr("stored parent", stats.storedParentExtAddr);
+    }
+    otCliOutputFormat("parent unchanged: %s\r\n", stats.parentMatchesStored ? "yes" : "no");
+    return OT_ERROR_NONE;
+}
+
+// relay bench [rounds] [payload]
+static otError cli_bench(otInstance *instance, uint8_t argc, char *argv[])
+{
+    uint16_t rounds = APP_PROBE_DEFAULT_ROUNDS;
+    uint16_t payloadLen = 0;
+    char *end;
+
+    if (argc > 2) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    if (argc > 0) {
+        unsigned long value = strtoul(argv[0], &end, 0);
+        if (*end != '\0' || value == 0 || value > UINT16_MAX) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        rounds = (uint16_t)value;
+    }
+
+    if (argc > 1) {
+        unsigned long value = strtoul(argv[1], &end, 0);
+        if (*end != '\0' || value > APP_PROBE_MAX_PAYLOAD) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        payloadLen = (uint16_t)value;
+    }
+
+    otError error = app_probe_bench_start(instance, rounds, payloadLen);
+    if (error == OT_ERROR_NONE) {
+        otCliOutputFormat("latency bench started, results in log\r\n");
+    }
+    return error;
+}
+
+// relay tunnel [open <rloc16> [link] [loopback] | close | bench <bytes>]
+static otError cli_tunnel(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_tunnel_stats_t stats;
+    char *end;
+
+    if (argc == 0) {
+        app_tunnel_get_stats_locked(&stats);
+        otCliOutputFormat("tunnel: %s\r\n", stats.open ? "open" : "closed");
+        if (!stats.open) {
+            return OT_ERROR_NONE;
+        }
+        otCliOutputFormat("peer: 0x%04x%s\r\n", stats.peerRloc16, stats.loopback ? " (loopback)" : "");
+        otCliOutputFormat("bytes: %lu sent, %lu received\r\n", (unsigned long)stats.bytesSent,
+                          (unsigned long)stats.bytesReceived);
+        otCliOutputFormat("chunks: %lu sent, %lu retransmitted, %lu credit stalls\r\n",
+                          (unsigned long)stats.chunksSent, (unsigned long)stats.retransmits,
+                          (unsigned long)stats.creditStalls);
+        if (stats.rttSamples > 0) {
+            otCliOutputFormat("chunk rtt min/avg/max: %lld/%lld/%lld us, srtt %lld us\r\n", stats.rttMinUs,
+                              stats.rttTotalUs / stats.rttSamples, stats.rttMaxUs, stats.srttUs);
+        }
+        otCliOutputFormat("rto: %lld ms\r\n", stats.rtoUs / 1000);
+        return OT_ERROR_NONE;
+    }
+
+    if (strcmp(argv[0], "close") == 0 && argc == 1) {
+        app_tunnel_close_locked();
+        return OT_ERROR_NONE;
+    }
+
+    if (strcmp(argv[0], "bench") == 0 && argc == 2) {
+        unsigned long bytes = strtoul(argv[1], &end, 0);
+        if (*end != '\0' || bytes == 0) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        otError error = app_tunnel_bench_start(instance, (uint32_t)bytes);
+        if (error == OT_ERROR_NONE) {
+            otCliOutputFormat("tunnel bench started, results in log\r\n");
+        }
+        return error;
+    }
+
+    if (strcmp(argv[0], "open") != 0 || argc < 2 || argc > 4 || app_node_role_get() == APP_NODE_ROLE_END_DEVICE) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    unsigned long rloc16 = strtoul(argv[1], &end, 16);
+    if (*end != '\0' || rloc16 > UINT16_MAX) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_ingress_channel_t channel = APP_INGRESS_CHANNEL_UART0;
+    bool loopback = false;
+    for (uint8_t i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "loopback") == 0) {
+            loopback = true;
+            continue;
+        }
+
+        int found = -1;
+        for (int c = 0; c < APP_INGRESS_CHANNEL_COUNT; c++) {
+            if (strcmp(argv[i], app_ingress_channel_name((app_ingress_channel_t)c)) == 0) {
+                found = c;
+            }
+        }
+        if (found < 0) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        channel = (app_ingress_channel_t)found;
+    }
+
+    return app_tunnel_open_locked(instance, (uint16_t)rloc16, channel, loopback);
+}
+
+// Trame hôte écrite en hexadécimal, sans séparateur (« d0000242 »)
+static bool parse_hex_frame(const char *text, uint8_t *frame, uint8_t maxLen, uint8_t *outLen)
+{
+    size_t textLen = strlen(text);
+
+    if (textLen == 0 || (textLen % 2) != 0 || textLen / 2 > maxLen) {
+        return false;
+    }
+
+    for (size_t i = 0; i < textLen / 2; i++) {
+        char pair[3] = {text[2 * i], text[2 * i + 1], '\0'};
+        char *end;
+        frame[i] = (uint8_t)strtoul(pair, &end, 16);
+        if (*end != '\0') {
+            return false;
+        }
+    }
+
+    *outLen = (uint8_t)(textLen / 2);
+    return true;
+}
+
+// relay sched [every|in <seconds> <hex frame> | del <id>]
+static otError cli_sched(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_sched_stats_t stats;
+    app_sched_entry_t entry;
+    (void)instance;
+
+    if (argc == 2 && strcmp(argv[0], "del") == 0) {
+        char *end;
+        unsigned long id = strtoul(argv[1], &end, 0);
+        if (*end != '\0' || id > UINT16_MAX) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        return (app_sched_remove_locked((uint16_t)id) == ESP_OK) ? OT_ERROR_NONE : OT_ERROR_NOT_FOUND;
+    }
+
+    if (argc == 3 && (strcmp(argv[0], "every") == 0 || strcmp(argv[0], "in") == 0)) {
+        uint8_t frame[APP_SCHED_FRAME_MAX];
+        uint8_t len;
+        uint16_t id;
+        char *end;
+        unsigned long seconds = strtoul(argv[1], &end, 0);
+        if (*end != '\0' || seconds > APP_SCHED_MAX_PERIOD_S || !parse_hex_frame(argv[2], frame, sizeof(frame), &len)) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+
+        esp_err_t err = app_sched_add_locked(strcmp(argv[0], "every") == 0, seconds, frame, len, &id);
+        if (err == ESP_ERR_INVALID_ARG) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        if (err != ESP_OK) {
+            return (err == ESP_ERR_NO_MEM) ? OT_ERROR_NO_BUFS : OT_ERROR_FAILED;
+        }
+        otCliOutputFormat("schedule %u added\r\n", id);
+        return OT_ERROR_NONE;
+    }
+
+    if (argc > 0) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    app_sched_get_stats_locked(&stats);
+    otCliOutputFormat("schedules: %u/%u, %lu fires, %lu failures, max ready %u, max late %lu ms\r\n", stats.count,
+                      APP_SCHED_MAX, (unsigned long)stats.fires, (unsigned long)stats.failures, stats.maxReady,
+                      (unsigned long)stats.maxLateMs);
+    for (uint16_t id = 0; app_sched_next_locked(&id, &entry); id++) {
+        otCliOutputFormat("%3u %-5s %6lu s next %6lu s frame ", entry.id, entry.periodic ? "every" : "in",
+                          (unsigned long)entry.intervalS, (unsigned long)entry.nextInS);
+        for (uint8_t i = 0; i < entry.len; i++) {
+            otCliOutputFormat("%02x", entry.frame[i]);
+        }
+        otCliOutputFormat("\r\n");
+    }
+    return OT_ERROR_NONE;
+}
+
+// relay supervision [fast|default|lowpower]
+static otError cli_supervision(otInstance *instance, uint8_t argc, char *argv[])
+{
+    app_supervision_profile_t profile;
+    app_supervision_stats_t stats;
+
+    if (argc > 0) {
+        if (!app_supervision_profile_from_string(argv[0], &profile)) {
+            return OT_ERROR_INVALID_ARGS;
+        }
+        if (app_supervision_profile_save(profile) != ESP_OK) {
+            return OT_ERROR_FAILED;
+        }
+        app_supervision_apply_locked(instance, profile);
+        return OT_ERROR_NONE;
+    }
+
+    const app_supervision_params_t *params = app_supervision_get_params(app_supervision_profile_load());
+    otCliOutputFormat("profile: %s\r\n", params->name);
+    otCliOutputFormat("child timeout: %lu s, supervision interval: %u s, check timeout: %u s\r\n",
+                      (unsigned long)params->childTimeoutS, params->supervisionIntervalS, params->checkTimeoutS);
+    otCliOutputFormat("keep-alive airtime per child: %lu ms/h (rx-on), %lu ms/h (sed)\r\n",
+                      (unsigned long)app_supervision_estimate_airtime_ms_per_hour(params, 0),
+                      (unsigned long)app_supervision_estimate_airtime_ms_per_hour(params, APP_ROLE_SED_POLL_PERIOD_MS));
+
+    app_supervision_get_stats(&stats);
+    otCliOutputFormat("children lost: %lu, moved: %lu\r\n", (unsigned long)stats.childrenLost,
+                      (unsigned long)stats.childrenMoved);
+    if (stats.childrenLost > 0) {
+        otCliOutputFormat("detection time last/avg/max: %lu/%lu/%lu ms\r\n", (unsigned long)stats.lastDetectionMs,
+                          (unsigned long)(stats.totalDetectionMs / stats.childrenLost),
+                          (unsigned long)stats.maxDetectionMs);
+    }
+    return OT_ERROR_NONE;
+}
+
+static const app_cli_subcommand_t sSubcommands[] = {
+    {"actuator", cli_actuator, "actuator"},
+    {"airtime", cli_airtime, "airtime"},
+    {"attach", cli_attach, "attach [fast on|off]"},
+    {"bench", cli_bench, "bench [rounds] [payload]"},
+    {"cbwatch", cli_cbwatch, "cbwatch [reset | budget <us>]"},
+    {"coex", cli_coex, "coex [off|control]"},
+    {"discover", cli_discover, "discover"},
+    {"failover", cli_failover, "failover"},
+    {"ingress", cli_ingress, "ingress"},
+    {"load", cli_load, "load [burst [count] [payload]]"},
+    {"netdiag", cli_netdiag, "netdiag"},
+    {"node", cli_node, "node [leader|child|standby|sniffer|auto]"},
+    {"pack", cli_pack, "pack"},
+    {"registry", cli_registry, "registry"},
+    {"retry", cli_retry, "retry [off|adaptive]"},
+    {"role", cli_role, "role [reed|fed|med|sed]"},
+    {"sched", cli_sched, "sched [every|in <seconds> <hex frame> | del <id>]"},
+    {"sniffer", cli_sniffer, "sniffer [channel <11-26>]"},
+    {"supervision", cli_supervision, "supervision [fast|default|lowpower]"},
+    {"tunnel", cli_tunnel, "tunnel [open <rloc16> [link] [loopback] | close | bench <bytes>]"},
+    {"txpower", cli_txpower, "txpower [off|adaptive]"},
+};
+
+static otError cli_relay(void *aContext, uint8_t aArgsLength, char *aArgs[])
+{
+    otInstance *instance = (otInstance *)aContext;
+
+    if (aArgsLength == 0) {
+        for (size_t i = 0; i < sizeof(sSubcommands) / sizeof(sSubcommands[0]); i++) {
+            otCliOutputFormat("relay %s\r\n", sSubcommands[i].usage);
+        }
+        return OT_ERROR_NONE;
+    }
+
+    for (size_t i = 0; i < sizeof(sSubcommands) / sizeof(sSubcommands[0]); i++) {
+        if (strcmp(aArgs[0], sSubcommands[i].name) == 0) {
+            // Les commandes s'exécutent sur la tâche OpenThread: chronométrées comme les callbacks
+            uint32_t start = app_cbwatch_begin();
+            otError error = sSubcommands[i].handler(instance, aArgsLength - 1, &aArgs[1]);
+            app_cbwatch_end_locked(APP_CBWATCH_CLI, start);
+            return error;
+        }
+    }
+
+    return OT_ERROR_INVALID_COMMAND;
+}
+
+static const otCliCommand sCommands[] = {
+    {"relay", cli_relay},
+};
+
+void app_cli_init(otInstance *instance)
+{
+    otError error = otCliSetUserCommands(sCommands, sizeof(sCommands) / sizeof(sCommands[0]), instance);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to register relay CLI commands: %d", error);
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Commandes CLI de l'application (« relay <sous-commande> »)
+ */
+
+#pragma once
+
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Enregistre la commande « relay » auprès du CLI OpenThread
+ *
+ * Les sous-commandes s'exécutent sur la tâche OpenThread, verrou tenu.
+ *
+ * @param instance Instance OpenThread passée en contexte aux sous-commandes
+ */
+void app_cli_init(otInstance *instance);
+
+#ifdef __cplusplus
+}
+#endif
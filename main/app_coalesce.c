@@ -0,0 +1,326 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * File d'envoi applicative: les commandes en attente vers un même actionneur
+ * sont remplacées par la plus récente (« dernier écrivain gagnant »)
+ */
+
+#include "app_coalesce.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_addr.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+
+#include "openthread/message.h"
+#include "openthread/thread_ftd.h"
+
+#define TAG "app_coalesce"
+
+// Un actionneur par broche de contrôle (0x01..0x05: paires haut/bas) et un pour la LED.
+// 0x00 (impulsion verte de 3 s) est un événement, pas un état: jamais remplacé.
+#define ACTUATOR_PIN_COUNT 3
+#define ACTUATOR_LED       ACTUATOR_PIN_COUNT
+#define ACTUATOR_NONE      0xff
+
+typedef struct {
+    bool used;
+    bool multiHop;
+    bool sleepy;
+    uint16_t rloc16;
+    otIp6Address dst;
+    uint8_t count;
+    uint8_t failures; // Envois refusés d'affilée pour la file courante
+    uint8_t commands[APP_COALESCE_QUEUE_LEN];
+    int64_t firstQueuedUs;
+} coalesce_dest_t;
+
+static otInstance *sInstance = NULL;
+static app_coalesce_send_fn_t sSend = NULL;
+static esp_timer_handle_t sCheckTimer = NULL;
+static coalesce_dest_t sDests[APP_COALESCE_MAX_DESTS];
+static app_coalesce_stats_t sStats;
+
+static uint8_t command_actuator(uint8_t opcode)
+{
+    if (opcode >= 0x01 && opcode < 2 * ACTUATOR_PIN_COUNT) {
+        return opcode / 2;
+    }
+    if (opcode == 0x42 || opcode == 0x46 || opcode == 0x47) {
+        return ACTUATOR_LED;
+    }
+
+    return ACTUATOR_NONE;
+}
+
+static bool find_child_locked(uint16_t rloc16, otChildInfo *outInfo)
+{
+    for (uint16_t index = 0; otThreadGetChildInfoByIndex(sInstance, index, outInfo) == OT_ERROR_NONE; index++) {
+        if (outInfo->mRloc16 == rloc16) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Messages à émission directe encore dans la file 6LoWPAN
+ *
+ * Les messages indirects attendent le sondage de leur enfant endormi: ils
+ * ne retardent pas les envois vers les nœuds toujours à l'écoute.
+ */
+static uint16_t direct_backlog_locked(void)
+{
+    otBufferInfo bufferInfo;
+    otChildInfo childInfo;
+    uint16_t indirect = 0;
+
+    otMessageGetBufferInfo(sInstance, &bufferInfo);
+    for (uint16_t index = 0; otThreadGetChildInfoByIndex(sInstance, index, &childInfo) == OT_ERROR_NONE; index++) {
+        indirect += childInfo.mQueuedMessageCnt;
+    }
+
+    return (bufferInfo.m6loSendQueue.mNumMessages > indirect) ? bufferInfo.m6loSendQueue.mNumMessages - indirect : 0;
+}
+
+static coalesce_dest_t *find_dest(const otIp6Address *dst)
+{
+    coalesce_dest_t *freeDest = NULL;
+
+    for (int i = 0; i < APP_COALESCE_MAX_DESTS; i++) {
+        if (sDests[i].used && memcmp(&sDests[i].dst, dst, sizeof(*dst)) == 0) {
+            return &sDests[i];
+        }
+        if (!sDests[i].used && freeDest == NULL) {
+            freeDest = &sDests[i];
+        }
+    }
+
+    if (freeDest != NULL) {
+        memset(freeDest, 0, sizeof(*freeDest));
+        freeDest->used = true;
+        freeDest->dst = *dst;
+    }
+    return freeDest;
+}
+
+/**
+ * @brief Envoie la file d'une destination
+ *
+ * Envoi refusé (pool de messages épuisé, file radio pleine): la file reste en
+ * place, les commandes suivantes continuent d'y remplacer les anciennes, et la
+ * vérification suivante réessaie. Abandon après APP_COALESCE_MAX_RETRIES refus.
+ *
+ * @return false si les commandes sont abandonnées
+ */
+static bool send_queue_locked(coalesce_dest_t *dest, bool held)
+{
+    int64_t heldUs = esp_timer_get_time() - dest->firstQueuedUs;
+
+    if (!sSend(sInstance, &dest->dst, dest->multiHop, dest->commands, dest->count)) {
+        if (++dest->failures < APP_COALESCE_MAX_RETRIES) {
+            sStats.retries++;
+            return true;
+        }
+        ESP_LOGW(TAG, "%u queued commands dropped after %u refused sends", dest->count, dest->failures);
+        sStats.dropped += dest->count;
+        dest->count = 0;
+        dest->failures = 0;
+        return false;
+    }
+
+    sStats.flushes++;
+    if (held) {
+        sStats.heldFlushes++;
+        sStats.sleepyFlushes += dest->sleepy ? 1 : 0;
+        if (heldUs / 1000 > sStats.maxHoldMs) {
+            sStats.maxHoldMs = (uint32_t)(heldUs / 1000);
+        }
+    }
+    dest->count = 0;
+    dest->failures = 0;
+    return true;
+}
+
+/**
+ * @brief Envoie la file d'une destination si la radio peut la prendre
+ *
+ * Enfant endormi: plus rien en file indirecte pour lui. Autre nœud: plus de
+ * message direct en attente, ou file retenue depuis APP_COALESCE_MAX_HOLD_MS.
+ */
+static bool try_flush_locked(coalesce_dest_t *dest, uint16_t directBacklog, bool held)
+{
+    bool ready;
+    bool ok = true;
+
+    if (dest->sleepy) {
+        otChildInfo childInfo;
+        if (!find_child_locked(dest->rloc16, &childInfo)) {
+            ESP_LOGW(TAG, "Child 0x%04x left, %u pending commands dropped", dest->rloc16, dest->count);
+            dest->used = false;
+            return false;
+        }
+        ready = (childInfo.mQueuedMessageCnt == 0);
+    } else {
+        int64_t heldUs = esp_timer_get_time() - dest->firstQueuedUs;
+        ready = (directBacklog == 0) || (heldUs >= APP_COALESCE_MAX_HOLD_MS * 1000LL);
+    }
+
+    if (ready) {
+        ok = send_queue_locked(dest, held);
+        // File gardée après un refus: la destination reste suivie et le timer tourne
+        dest->used = (dest->count > 0);
+    }
+    return ok;
+}
+
+static bool any_pending(void)
+{
+    for (int i = 0; i < APP_COALESCE_MAX_DESTS; i++) {
+        if (sDests[i].used) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Le timer ne tourne que tant qu'une file attend: aucun réveil ni verrou au repos
+static void update_check_timer_locked(void)
+{
+    bool pending = any_pending();
+
+    if (pending && !esp_timer_is_active(sCheckTimer)) {
+        esp_timer_start_periodic(sCheckTimer, APP_COALESCE_CHECK_MS * 1000ULL);
+    } else if (!pending && esp_timer_is_active(sCheckTimer)) {
+        esp_timer_stop(sCheckTimer);
+    }
+}
+
+static void check_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!any_pending()) {
+        return;
+    }
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    uint16_t directBacklog = direct_backlog_locked();
+    for (int i = 0; i < APP_COALESCE_MAX_DESTS; i++) {
+        if (sDests[i].used) {
+            try_flush_locked(&sDests[i], directBacklog, true);
+        }
+    }
+    update_check_timer_locked();
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_COALESCE, start);
+    esp_openthread_lock_release();
+}
+
+void app_coalesce_init(otInstance *instance, app_coalesce_send_fn_t send)
+{
+    if (sCheckTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+    sSend = send;
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = check_timer_cb,
+        .name = "coalesce_check",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sCheckTimer));
+}
+
+// Retire la commande en attente pour le même actionneur, puis ajoute la nouvelle en queue
+static void enqueue(coalesce_dest_t *dest, uint8_t command)
+{
+    uint8_t actuator = command_actuator(command);
+
+    if (actuator != ACTUATOR_NONE) {
+        for (uint8_t i = 0; i < dest->count; i++) {
+            if (command_actuator(dest->commands[i]) == actuator) {
+                memmove(&dest->commands[i], &dest->commands[i + 1], dest->count - i - 1);
+                dest->count--;
+                sStats.superseded++;
+                break;
+            }
+        }
+    }
+
+    if (dest->count == 0) {
+        dest->firstQueuedUs = esp_timer_get_time();
+    }
+    dest->commands[dest->count++] = command;
+    if (dest->count > sStats.maxDepth) {
+        sStats.maxDepth = dest->count;
+    }
+}
+
+bool app_coalesce_submit_locked(otInstance *instance, const otIp6Address *dst, bool multiHop, const uint8_t *data,
+                                uint16_t len)
+{
+    otChildInfo childInfo;
+    uint16_t rloc16 = 0;
+
+    if (sSend == NULL) {
+        return false;
+    }
+
+    coalesce_dest_t *dest = find_dest(dst);
+    if (dest == NULL) {
+        ESP_LOGW(TAG, "No send queue free, commands sent as they are");
+        return sSend(instance, dst, multiHop, data, len);
+    }
+
+    dest->multiHop = multiHop;
+    dest->sleepy = app_addr_get_rloc16_locked(instance, dst, &rloc16) && find_child_locked(rloc16, &childInfo) &&
+                   !childInfo.mRxOnWhenIdle;
+    dest->rloc16 = rloc16;
+
+    bool ok = true;
+    for (uint16_t i = 0; i < len; i++) {
+        // File pleine de commandes sans actionneur connu: elle part telle quelle.
+        // Envoi refusé: plus de place pour attendre la vérification suivante
+        if (dest->count == APP_COALESCE_QUEUE_LEN) {
+            ok = send_queue_locked(dest, false) && ok;
+            if (dest->count == APP_COALESCE_QUEUE_LEN) {
+                ESP_LOGW(TAG, "Queue full and send refused, %u commands dropped", dest->count);
+                sStats.dropped += dest->count;
+                dest->count = 0;
+                dest->failures = 0;
+                ok = false;
+            }
+        }
+        enqueue(dest, data[i]);
+        sStats.submitted++;
+    }
+
+    ok = try_flush_locked(dest, direct_backlog_locked(), false) && ok;
+    update_check_timer_locked();
+    return ok;
+}
+
+void app_coalesce_get_stats_locked(app_coalesce_stats_t *outStats)
+{
+    *outStats = sStats;
+    outStats->pendingDests = 0;
+
+    for (int i = 0; i < APP_COALESCE_MAX_DESTS; i++) {
+        if (sDests[i].used) {
+            outStats->pendingDests++;
+        }
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * File d'envoi applicative: les commandes en attente vers un même actionneur
+ * sont remplacées par la plus récente (« dernier écrivain gagnant »)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Destinations suivies en même temps */
+#define APP_COALESCE_MAX_DESTS 8
+
+/** Commandes en attente par destination au plus */
+#define APP_COALESCE_QUEUE_LEN 16
+
+/** Période de vérification des files d'envoi, tant qu'une file attend */
+#define APP_COALESCE_CHECK_MS 20
+
+/** Attente maximale vers un nœud toujours à l'écoute, même si la radio n'a pas vidé sa file */
+#define APP_COALESCE_MAX_HOLD_MS 200
+
+/** Envois refusés d'affilée pour une file avant de l'abandonner (un essai par vérification) */
+#define APP_COALESCE_MAX_RETRIES 10
+
+/**
+ * @brief Envoi immédiat des commandes regroupées (verrou OpenThread tenu)
+ *
+ * @return true si les commandes sont parties
+ */
+typedef bool (*app_coalesce_send_fn_t)(otInstance *instance, const otIp6Address *dst, bool multiHop,
+                                       const uint8_t *data, uint16_t len);
+
+/** Mesures du regroupement */
+typedef struct {
+    uint32_t submitted;      // Commandes confiées à la file
+    uint32_t superseded;     // Commandes remplacées par une plus récente avant envoi
+    uint32_t flushes;        // Datagrammes envoyés depuis la file
+    uint32_t heldFlushes;    // Dont après une attente (radio occupée ou enfant endormi)
+    uint32_t sleepyFlushes;  // Dont vers un enfant endormi, après son sondage
+    uint32_t retries;        // Envois refusés, file gardée pour la vérification suivante
+    uint32_t dropped;        // Commandes abandonnées après APP_COALESCE_MAX_RETRIES refus
+    uint16_t pendingDests;
+    uint16_t maxDepth;       // Plus longue file observée
+    uint32_t maxHoldMs;      // Plus longue attente d'une commande dans la file
+} app_coalesce_stats_t;
+
+/**
+ * @brief Démarre la vérification périodique des files d'envoi
+ *
+ * @param instance Instance OpenThread
+ * @param send Envoi immédiat, sans regroupement
+ */
+void app_coalesce_init(otInstance *instance, app_coalesce_send_fn_t send);
+
+/**
+ * @brief Confie des commandes à la file d'envoi d'une destination
+ *
+ * Une commande pour une broche ou pour la LED retire de la file la commande
+ * encore en attente pour le même actionneur et se place en queue: l'ordre
+ * entre actionneurs différents est conservé. La file part en un datagramme
+ * quand la radio a vidé ses messages directs; vers un enfant endormi, quand
+ * la file indirecte du parent pour cet enfant est vide (au plus une trame
+ * par sondage). Un envoi refusé garde la file, renvoyée à la vérification
+ * suivante, au plus APP_COALESCE_MAX_RETRIES fois.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param dst Adresse de la destination
+ * @param multiHop true si la destination n'est pas un voisin direct
+ * @param data Commandes
+ * @param len Longueur des commandes en octets
+ * @return false si des commandes sont abandonnées ou si aucune file n'est libre
+ */
+bool app_coalesce_submit_locked(otInstance *instance, const otIp6Address *dst, bool multiHop, const uint8_t *data,
+                                uint16_t len);
+
+/**
+ * @brief Copie les mesures du regroupement (verrou OpenThread tenu)
+ */
+void app_coalesce_get_stats_locked(app_coalesce_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,243 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Coexistence Wi-Fi/802.15.4: statistiques et priorité des commandes
+ */
+
+#include "app_coex.h"
+
+#include <strings.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_settings.h"
+
+#include "openthread/link.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define APP_COEX_SUPPORTED (CONFIG_ESP_COEX_SW_COEXIST_ENABLE || CONFIG_ESP_COEX_EXTERNAL_COEXIST_ENABLE)
+
+#if APP_COEX_SUPPORTED
+#include "esp_ieee802154.h"
+#endif
+
+#define TAG "app_coex"
+
+#define COEX_MODE_KEY "coex_mode"
+
+static const char *const sModeNames[APP_COEX_MODE_COUNT] = {
+    [APP_COEX_MODE_OFF] = "off",
+    [APP_COEX_MODE_CONTROL] = "control",
+};
+
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sSampleTimer = NULL;
+static esp_timer_handle_t sControlTimer = NULL;
+static app_coex_mode_t sMode = APP_COEX_MODE_OFF;
+static volatile int64_t sControlUntilUs = 0;
+static SemaphoreHandle_t sPriorityMutex = NULL; // Échéance de fenêtre et priorité radio, modifiées ensemble
+static portMUX_TYPE sStatsLock = portMUX_INITIALIZER_UNLOCKED;
+static app_coex_stats_t sStats;
+static otMacCounters sLastCounters;
+
+#if APP_COEX_SUPPORTED
+static esp_ieee802154_coex_config_t sDefaultConfig;
+
+static void set_txrx_priority(ieee802154_coex_event_t txrx)
+{
+    esp_ieee802154_coex_config_t config = sDefaultConfig;
+
+    config.txrx = txrx;
+    esp_ieee802154_set_coex_config(config);
+}
+#endif
+
+// Applique la priorité de repos du mode courant
+static void apply_base_priority(void)
+{
+#if APP_COEX_SUPPORTED
+    if (sMode == APP_COEX_MODE_CONTROL) {
+        set_txrx_priority(IEEE802154_LOW);
+    } else {
+        esp_ieee802154_set_coex_config(sDefaultConfig);
+    }
+#endif
+}
+
+// Fin de la fenêtre de priorité haute ouverte par une commande.
+// Une commande arrivée entre le déclenchement et la prise du mutex a déjà reporté
+// l'échéance et remis la priorité haute: ne rien abaisser dans ce cas
+static void control_timer_cb(void *arg)
+{
+    (void)arg;
+
+    xSemaphoreTake(sPriorityMutex, portMAX_DELAY);
+    if (esp_timer_get_time() >= sControlUntilUs) {
+        apply_base_priority();
+    }
+    xSemaphoreGive(sPriorityMutex);
+}
+
+// Échantillonne les compteurs MAC et calcule le taux de refus de la période
+static void sample_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+    otMacCounters counters = *otLinkGetCounters(sInstance);
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_COEX, start);
+    esp_openthread_lock_release();
+
+    uint32_t attempts = (counters.mTxTotal - sLastCounters.mTxTotal) + (counters.mTxRetry - sLastCounters.mTxRetry);
+    uint32_t denials = counters.mTxErrAbort - sLastCounters.mTxErrAbort;
+    uint32_t ccaFailures = (counters.mTxErrCca - sLastCounters.mTxErrCca) +
+                           (counters.mTxErrBusyChannel - sLastCounters.mTxErrBusyChannel);
+    sLastCounters = counters;
+
+    portENTER_CRITICAL(&sStatsLock);
+    sStats.txAttempts += attempts;
+    sStats.denials += denials;
+    sStats.grants += (attempts > denials) ? (attempts - denials) : 0;
+    sStats.ccaFailures += ccaFailures;
+    sStats.denialPercent = (attempts > 0) ? (uint8_t)((denials * 100) / attempts) : 0;
+    portEXIT_CRITICAL(&sStatsLock);
+}
+
+void app_coex_init(otInstance *instance)
+{
+    uint8_t value;
+
+    if (sSampleTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+    sPriorityMutex = xSemaphoreCreateMutex();
+    if (app_settings_get_u8(COEX_MODE_KEY, &value) == ESP_OK && value < APP_COEX_MODE_COUNT) {
+        sMode = (app_coex_mode_t)value;
+    }
+
+#if APP_COEX_SUPPORTED
+    sDefaultConfig = esp_ieee802154_get_coex_config();
+#else
+    if (sMode != APP_COEX_MODE_OFF) {
+        ESP_LOGW(TAG, "Coexistence not enabled in this build, priorities left unchanged");
+    }
+#endif
+    apply_base_priority();
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    sLastCounters = *otLinkGetCounters(instance);
+    esp_openthread_lock_release();
+
+    const esp_timer_create_args_t controlArgs = {
+        .callback = control_timer_cb,
+        .name = "coex_control",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&controlArgs, &sControlTimer));
+
+    const esp_timer_create_args_t sampleArgs = {
+        .callback = sample_timer_cb,
+        .name = "coex_sample",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&sampleArgs, &sSampleTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sSampleTimer, APP_COEX_SAMPLE_PERIOD_MS * 1000ULL));
+
+    ESP_LOGI(TAG, "Coexistence mode: %s", sModeNames[sMode]);
+}
+
+app_coex_mode_t app_coex_mode_get(void)
+{
+    return sMode;
+}
+
+esp_err_t app_coex_mode_set(app_coex_mode_t mode)
+{
+    if (mode >= APP_COEX_MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sPriorityMutex != NULL) {
+        xSemaphoreTake(sPriorityMutex, portMAX_DELAY);
+    }
+    sMode = mode;
+    apply_base_priority();
+    if (sPriorityMutex != NULL) {
+        xSemaphoreGive(sPriorityMutex);
+    }
+    return app_settings_set_u8(COEX_MODE_KEY, (uint8_t)mode);
+}
+
+const char *app_coex_mode_to_string(app_coex_mode_t mode)
+{
+    return (mode < APP_COEX_MODE_COUNT) ? sModeNames[mode] : "unknown";
+}
+
+bool app_coex_mode_from_string(const char *name, app_coex_mode_t *outMode)
+{
+    for (int i = 0; i < APP_COEX_MODE_COUNT; i++) {
+        if (strcasecmp(name, sModeNames[i]) == 0) {
+            *outMode = (app_coex_mode_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void app_coex_control_begin(void)
+{
+    if (sMode != APP_COEX_MODE_CONTROL || sControlTimer == NULL) {
+        return;
+    }
+
+    // Échéance et priorité haute posées ensemble: control_timer_cb voit l'une et l'autre
+    xSemaphoreTake(sPriorityMutex, portMAX_DELAY);
+    sControlUntilUs = esp_timer_get_time() + APP_COEX_CONTROL_WINDOW_MS * 1000LL;
+#if APP_COEX_SUPPORTED
+    set_txrx_priority(IEEE802154_HIGH);
+#endif
+
+    // Une nouvelle commande prolonge la fenêtre en cours
+    esp_timer_stop(sControlTimer);
+    esp_timer_start_once(sControlTimer, APP_COEX_CONTROL_WINDOW_MS * 1000ULL);
+    xSemaphoreGive(sPriorityMutex);
+
+    portENTER_CRITICAL(&sStatsLock);
+    sStats.controlWindows++;
+    portEXIT_CRITICAL(&sStatsLock);
+}
+
+bool app_coex_bulk_allowed(void)
+{
+    if (sMode != APP_COEX_MODE_CONTROL) {
+        return true;
+    }
+
+    bool allowed = (esp_timer_get_time() >= sControlUntilUs) && (sStats.denialPercent < APP_COEX_DEFER_DENIAL_PERCENT);
+    if (!allowed) {
+        portENTER_CRITICAL(&sStatsLock);
+        sStats.bulkDeferred++;
+        portEXIT_CRITICAL(&sStatsLock);
+    }
+
+    return allowed;
+}
+
+void app_coex_get_stats(app_coex_stats_t *outStats)
+{
+    portENTER_CRITICAL(&sStatsLock);
+    *outStats = sStats;
+    portEXIT_CRITICAL(&sStatsLock);
+}
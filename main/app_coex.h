@@ -0,0 +1,107 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Coexistence Wi-Fi/802.15.4: statistiques et priorité des commandes
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Durée pendant laquelle la radio garde la priorité haute après une commande */
+#define APP_COEX_CONTROL_WINDOW_MS 100
+
+/** Période d'échantillonnage des compteurs MAC */
+#define APP_COEX_SAMPLE_PERIOD_MS 1000
+
+/** Taux de refus (en %) au-delà duquel le trafic de masse est différé */
+#define APP_COEX_DEFER_DENIAL_PERCENT 20
+
+/**
+ * @brief Modes de coexistence
+ *
+ * - OFF:     priorités par défaut du pilote 802.15.4
+ * - CONTROL: priorité basse par défaut, haute pendant l'envoi d'une commande;
+ *            le trafic de masse est différé pendant une commande ou si la
+ *            radio est trop souvent refusée
+ */
+typedef enum {
+    APP_COEX_MODE_OFF = 0,
+    APP_COEX_MODE_CONTROL,
+    APP_COEX_MODE_COUNT,
+} app_coex_mode_t;
+
+/** Statistiques cumulées depuis le démarrage */
+typedef struct {
+    uint32_t txAttempts;     // Trames MAC émises, retransmissions comprises
+    uint32_t grants;         // Tentatives ayant obtenu l'antenne
+    uint32_t denials;        // Émissions abandonnées (refus de l'arbitre)
+    uint32_t ccaFailures;    // Canal occupé au CCA
+    uint32_t controlWindows; // Passages en priorité haute pour une commande
+    uint32_t bulkDeferred;   // Envois de masse différés
+    uint8_t denialPercent;   // Taux de refus de la dernière période
+} app_coex_stats_t;
+
+/**
+ * @brief Applique le mode enregistré et démarre l'échantillonnage des compteurs
+ *
+ * @param instance Instance OpenThread
+ */
+void app_coex_init(otInstance *instance);
+
+/**
+ * @brief Retourne le mode courant
+ */
+app_coex_mode_t app_coex_mode_get(void);
+
+/**
+ * @brief Change le mode, l'applique et l'enregistre en NVS
+ */
+esp_err_t app_coex_mode_set(app_coex_mode_t mode);
+
+/**
+ * @brief Retourne le nom d'un mode ("off", "control")
+ */
+const char *app_coex_mode_to_string(app_coex_mode_t mode);
+
+/**
+ * @brief Convertit un nom de mode
+ *
+ * @return true si le nom est reconnu, false sinon
+ */
+bool app_coex_mode_from_string(const char *name, app_coex_mode_t *outMode);
+
+/**
+ * @brief Signale l'envoi d'une commande: priorité haute pendant APP_COEX_CONTROL_WINDOW_MS
+ *
+ * Sans effet en mode OFF ou sans coexistence compilée.
+ */
+void app_coex_control_begin(void);
+
+/**
+ * @brief Indique si un envoi de masse peut partir maintenant
+ *
+ * Toujours vrai en mode OFF. Un refus est compté comme envoi différé:
+ * l'appelant réessaie plus tard. Consulté par les requêtes remplies et les
+ * rafales du banc, les nouveaux fragments du tunnel et les relevés de topologie.
+ */
+bool app_coex_bulk_allowed(void);
+
+/**
+ * @brief Copie les statistiques
+ */
+void app_coex_get_stats(app_coex_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
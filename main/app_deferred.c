@@ -0,0 +1,63 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Écriture NVS différée et regroupée, depuis une tâche de basse priorité
+ */
+
+#include "app_deferred.h"
+
+#include "esp_timer.h"
+
+/**
+ * @brief Tâche d'écriture: attend que les changements se calment puis écrit une fois
+ *
+ * Chaque écriture NVS ajoute une entrée dans la page courante et finit par
+ * coûter un effacement de secteur; une rafale de changements ne produit donc
+ * qu'une écriture. Jamais depuis la tâche OpenThread ni la tâche esp_timer:
+ * une écriture peut durer le temps d'un effacement.
+ *
+ * @param pvParameters Tâche d'écriture décrite
+ */
+static void deferred_writer_task(void *pvParameters)
+{
+    app_deferred_writer_t *writer = (app_deferred_writer_t *)pvParameters;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        // Anti-rebond borné: un changement répété en continu ne repousse pas l'écriture indéfiniment
+        int64_t firstUs = esp_timer_get_time();
+        while (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(writer->settleMs)) > 0) {
+            if (esp_timer_get_time() - firstUs >= (int64_t)writer->maxDeferMs * 1000) {
+                break;
+            }
+        }
+
+        writer->write(writer->context);
+    }
+}
+
+bool app_deferred_start(app_deferred_writer_t *writer, const char *name, uint32_t settleMs, uint32_t maxDeferMs,
+                        app_deferred_write_fn_t write, void *context)
+{
+    writer->settleMs = settleMs;
+    writer->maxDeferMs = maxDeferMs;
+    writer->write = write;
+    writer->context = context;
+
+    if (xTaskCreate(deferred_writer_task, name, APP_DEFERRED_STACK_SIZE, writer, APP_DEFERRED_TASK_PRIORITY,
+                    &writer->task) != pdPASS) {
+        writer->task = NULL;
+        return false;
+    }
+    return true;
+}
+
+void app_deferred_notify(app_deferred_writer_t *writer)
+{
+    if (writer->task != NULL) {
+        xTaskNotifyGive(writer->task);
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Écriture NVS différée et regroupée, depuis une tâche de basse priorité
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Priorité des tâches d'écriture: sous toutes les tâches de l'application */
+#define APP_DEFERRED_TASK_PRIORITY 1
+
+/** Pile des tâches d'écriture (appels NVS compris) */
+#define APP_DEFERRED_STACK_SIZE 3072
+
+/**
+ * @brief Écriture regroupée, appelée depuis la tâche d'écriture
+ *
+ * Aucun verrou tenu: la fonction copie elle-même l'état à écrire sous le
+ * verrou qui le protège, puis écrit hors de ce verrou.
+ *
+ * @param context Contexte donné à app_deferred_start
+ */
+typedef void (*app_deferred_write_fn_t)(void *context);
+
+/** Tâche d'écriture différée; état privé, rempli par app_deferred_start */
+typedef struct {
+    TaskHandle_t task;
+    uint32_t settleMs;
+    uint32_t maxDeferMs;
+    app_deferred_write_fn_t write;
+    void *context;
+} app_deferred_writer_t;
+
+/**
+ * @brief Crée la tâche d'écriture
+ *
+ * Après une notification, la tâche attend settleMs sans nouvelle
+ * notification, au plus maxDeferMs après la première, puis appelle write
+ * une seule fois pour toute la rafale.
+ *
+ * @param writer Tâche à créer (mémoire statique de l'appelant)
+ * @param name Nom de la tâche
+ * @param settleMs Délai de calme après la dernière notification
+ * @param maxDeferMs Report maximal quand les notifications ne cessent pas
+ * @param write Écriture regroupée
+ * @param context Contexte passé à write
+ * @return false si la tâche n'a pas pu être créée (app_deferred_notify est alors sans effet)
+ */
+bool app_deferred_start(app_deferred_writer_t *writer, const char *name, uint32_t settleMs, uint32_t maxDeferMs,
+                        app_deferred_write_fn_t write, void *context);
+
+/**
+ * @brief Signale un changement à écrire; ne bloque pas et ne touche pas à la flash
+ *
+ * Utilisable depuis n'importe quelle tâche, verrou OpenThread tenu ou non.
+ */
+void app_deferred_notify(app_deferred_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,411 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Découverte des appareils par SRP/DNS-SD (service « _relay._udp »)
+ */
+
+#include "app_discovery.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_registry.h"
+
+#include "openthread/link.h"
+#include "openthread/thread.h"
+
+#define APP_DISCOVERY_SUPPORTED (CONFIG_OPENTHREAD_SRP_CLIENT && CONFIG_OPENTHREAD_DNS_CLIENT)
+
+#if APP_DISCOVERY_SUPPORTED
+#include "openthread/dns.h"
+#include "openthread/dns_client.h"
+#include "openthread/srp_client.h"
+#endif
+
+#define TAG "app_discovery"
+
+#define DISCOVERY_DOMAIN       ".default.service.arpa."
+#define DISCOVERY_TICK_MS      5000
+#define DISCOVERY_MIN_TTL_S    30
+
+#if CONFIG_APP_TUNNEL_CHILD_UART_ENABLE
+#define DISCOVERY_CAPS "gpio,led,tunnel"
+#else
+#define DISCOVERY_CAPS "gpio,led"
+#endif
+
+typedef enum {
+    ENTRY_FREE = 0,
+    ENTRY_RESOLVING,
+    ENTRY_CACHED,
+} entry_state_t;
+
+typedef struct {
+    entry_state_t state;
+    app_discovery_service_t service;
+    int64_t expiryUs;
+    int64_t refreshUs;  // Nouvelle résolution à 80 % du TTL
+} cache_entry_t;
+
+static otInstance *sInstance = NULL;
+static app_discovery_stats_t sStats;
+
+#if APP_DISCOVERY_SUPPORTED
+
+static cache_entry_t sCache[APP_DISCOVERY_MAX_SERVICES];
+static esp_timer_handle_t sTickTimer = NULL;
+static bool sBrowsing = false;
+static int64_t sNextBrowseUs = 0;
+static uint8_t sOwnEui64[8];
+
+// Enregistrement SRP: chaînes et entrées TXT gardées pour la durée de vie du client
+static char sHostName[24];
+static char sEuiText[17];
+static char sPinsText[16];
+static otDnsTxtEntry sTxtEntries[3];
+static otSrpClientService sService;
+
+static char sServiceName[sizeof(APP_DISCOVERY_SERVICE) + sizeof(DISCOVERY_DOMAIN)];
+
+static bool parse_eui64(const uint8_t *text, uint16_t len, uint8_t *outEui64)
+{
+    if (len != 16) {
+        return false;
+    }
+
+    for (int i = 0; i < 8; i++) {
+        unsigned int byte;
+        char pair[3] = {(char)text[2 * i], (char)text[2 * i + 1], '\0'};
+        if (sscanf(pair, "%2x", &byte) != 1) {
+            return false;
+        }
+        outEui64[i] = (uint8_t)byte;
+    }
+
+    return true;
+}
+
+static void copy_txt_value(char *dest, size_t size, const otDnsTxtEntry *entry)
+{
+    size_t len = (entry->mValueLength < size - 1) ? entry->mValueLength : size - 1;
+
+    memcpy(dest, entry->mValue, len);
+    dest[len] = '\0';
+}
+
+static void parse_txt(app_discovery_service_t *service, const uint8_t *txtData, uint16_t txtLen)
+{
+    otDnsTxtEntryIterator iterator;
+    otDnsTxtEntry entry;
+
+    otDnsInitTxtEntryIterator(&iterator, txtData, txtLen);
+    while (otDnsGetNextTxtEntry(&iterator, &entry) == OT_ERROR_NONE) {
+        if (entry.mKey == NULL || entry.mValue == NULL) {
+            continue;
+        }
+        if (strcmp(entry.mKey, "eui") == 0) {
+            service->hasEui64 = parse_eui64(entry.mValue, entry.mValueLength, service->eui64);
+        } else if (strcmp(entry.mKey, "pins") == 0) {
+            copy_txt_value(service->pins, sizeof(service->pins), &entry);
+        } else if (strcmp(entry.mKey, "caps") == 0) {
+            copy_txt_value(service->caps, sizeof(service->caps), &entry);
+        }
+    }
+}
+
+static cache_entry_t *find_entry(const char *instanceLabel)
+{
+    for (int i = 0; i < APP_DISCOVERY_MAX_SERVICES; i++) {
+        if (sCache[i].state != ENTRY_FREE && strcmp(sCache[i].service.instance, instanceLabel) == 0) {
+            return &sCache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static cache_entry_t *alloc_entry(const char *instanceLabel)
+{
+    for (int i = 0; i < APP_DISCOVERY_MAX_SERVICES; i++) {
+        if (sCache[i].state == ENTRY_FREE) {
+            memset(&sCache[i], 0, sizeof(sCache[i]));
+            strncpy(sCache[i].service.instance, instanceLabel, sizeof(sCache[i].service.instance) - 1);
+            return &sCache[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Résultat d'une résolution: adresse, port et TXT gardés jusqu'au plus court des TTL
+static void resolve_done_locked(otError aError, const otDnsServiceResponse *aResponse, void *aContext)
+{
+    cache_entry_t *entry = (cache_entry_t *)aContext;
+    otDnsServiceInfo info;
+    uint8_t txtData[128];
+
+    if (entry->state == ENTRY_FREE) {
+        return;
+    }
+
+    memset(&info, 0, sizeof(info));
+    info.mTxtData = txtData;
+    info.mTxtDataSize = sizeof(txtData);
+
+    if (aError != OT_ERROR_NONE || otDnsServiceResponseGetServiceInfo(aResponse, &info) != OT_ERROR_NONE) {
+        sStats.failures++;
+        ESP_LOGW(TAG, "Failed to resolve %s: %d", entry->service.instance, aError);
+        // Entrée encore valide: nouvel essai au prochain parcours
+        entry->state = (entry->expiryUs > esp_timer_get_time()) ? ENTRY_CACHED : ENTRY_FREE;
+        return;
+    }
+
+    uint32_t ttlS = info.mTtl;
+    ttlS = (info.mHostAddressTtl < ttlS) ? info.mHostAddressTtl : ttlS;
+    ttlS = (info.mTxtDataTtl < ttlS) ? info.mTxtDataTtl : ttlS;
+    ttlS = (ttlS < DISCOVERY_MIN_TTL_S) ? DISCOVERY_MIN_TTL_S : ttlS;
+
+    int64_t nowUs = esp_timer_get_time();
+    app_discovery_service_t *service = &entry->service;
+    service->address = info.mHostAddress;
+    service->port = info.mPort;
+    parse_txt(service, txtData, info.mTxtDataSize);
+    entry->expiryUs = nowUs + ttlS * 1000000LL;
+    entry->refreshUs = nowUs + ttlS * 800000LL;
+    entry->state = ENTRY_CACHED;
+
+    /*
+     * Même table d'ID que les annonces: une trame adressée atteint l'appareil
+     * découvert par l'adresse de l'hôte SRP, jusqu'à ce que son annonce la
+     * remplace par le ML-EID.
+     */
+    if (service->hasEui64 && memcmp(service->eui64, sOwnEui64, sizeof(sOwnEui64)) != 0) {
+        service->id = app_registry_learn_locked(service->eui64, &service->address);
+    }
+
+    char addrStr[OT_IP6_ADDRESS_STRING_SIZE];
+    otIp6AddressToString(&service->address, addrStr, sizeof(addrStr));
+    ESP_LOGI(TAG, "Resolved %s: [%s]:%u, ttl %lu s, pins %s, caps %s", service->instance, addrStr, service->port,
+             (unsigned long)ttlS, service->pins, service->caps);
+}
+
+// Réponses DNS: livrées sur la tâche OpenThread, chronométrées comme les réceptions UDP
+static void handle_resolve(otError aError, const otDnsServiceResponse *aResponse, void *aContext)
+{
+    uint32_t start = app_cbwatch_begin();
+    resolve_done_locked(aError, aResponse, aContext);
+    app_cbwatch_end_locked(APP_CBWATCH_DNS, start);
+}
+
+static void resolve_locked(cache_entry_t *entry)
+{
+    otError error = otDnsClientResolveService(sInstance, entry->service.instance, sServiceName, handle_resolve, entry,
+                                              NULL);
+    if (error != OT_ERROR_NONE) {
+        sStats.failures++;
+        return;
+    }
+
+    sStats.resolves++;
+    entry->state = ENTRY_RESOLVING;
+}
+
+// Résultat d'un parcours: chaque instance absente du cache ou proche de l'expiration est résolue
+static void browse_done_locked(otError aError, const otDnsBrowseResponse *aResponse, void *aContext)
+{
+    (void)aContext;
+    char label[OT_DNS_MAX_LABEL_SIZE];
+    int64_t nowUs = esp_timer_get_time();
+
+    sBrowsing = false;
+    if (aError != OT_ERROR_NONE) {
+        sStats.failures++;
+        ESP_LOGW(TAG, "Browse of %s failed: %d", APP_DISCOVERY_SERVICE, aError);
+        return;
+    }
+
+    for (uint16_t index = 0;
+         otDnsBrowseResponseGetServiceInstance(aResponse, index, label, sizeof(label)) == OT_ERROR_NONE; index++) {
+        cache_entry_t *entry = find_entry(label);
+
+        if (entry == NULL) {
+            entry = alloc_entry(label);
+            if (entry == NULL) {
+                ESP_LOGW(TAG, "Service cache full, %s ignored", label);
+                break;
+            }
+        } else if (entry->state != ENTRY_CACHED || nowUs < entry->refreshUs) {
+            continue;
+        }
+
+        // Une entrée neuve reste libre si la requête n'a pas pu partir
+        resolve_locked(entry);
+    }
+}
+
+static void handle_browse(otError aError, const otDnsBrowseResponse *aResponse, void *aContext)
+{
+    uint32_t start = app_cbwatch_begin();
+    browse_done_locked(aError, aResponse, aContext);
+    app_cbwatch_end_locked(APP_CBWATCH_DNS, start);
+}
+
+// Leader: parcours périodique, nouvelle résolution à 80 % du TTL, retrait des entrées expirées
+static void discovery_tick_cb(void *arg)
+{
+    (void)arg;
+    int64_t nowUs = esp_timer_get_time();
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    if (otThreadGetDeviceRole(sInstance) != OT_DEVICE_ROLE_LEADER) {
+        app_cbwatch_end_locked(APP_CBWATCH_TICK_DISCOVERY, start);
+        esp_openthread_lock_release();
+        return;
+    }
+
+    for (int i = 0; i < APP_DISCOVERY_MAX_SERVICES; i++) {
+        cache_entry_t *entry = &sCache[i];
+        if (entry->state != ENTRY_CACHED) {
+            continue;
+        }
+        if (nowUs >= entry->expiryUs) {
+            ESP_LOGI(TAG, "Service %s expired", entry->service.instance);
+            entry->state = ENTRY_FREE;
+            sStats.expired++;
+        } else if (nowUs >= entry->refreshUs) {
+            resolve_locked(entry);
+        }
+    }
+
+    if (!sBrowsing && nowUs >= sNextBrowseUs) {
+        if (otDnsClientBrowse(sInstance, sServiceName, handle_browse, NULL, NULL) == OT_ERROR_NONE) {
+            sBrowsing = true;
+            sStats.browses++;
+        } else {
+            sStats.failures++;
+        }
+        sNextBrowseUs = nowUs + APP_DISCOVERY_BROWSE_PERIOD_S * 1000000LL;
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_DISCOVERY, start);
+    esp_openthread_lock_release();
+}
+
+// Enregistre l'instance « relay-<EUI-64> » avec ses broches et capacités en TXT
+static void register_service_locked(uint16_t commandPort, const char *pins)
+{
+    otExtAddress eui64;
+
+    otLinkGetFactoryAssignedIeeeEui64(sInstance, &eui64);
+    memcpy(sOwnEui64, eui64.m8, sizeof(sOwnEui64));
+    for (int i = 0; i < 8; i++) {
+        snprintf(&sEuiText[2 * i], 3, "%02x", eui64.m8[i]);
+    }
+    snprintf(sHostName, sizeof(sHostName), "relay-%s", sEuiText);
+    strncpy(sPinsText, pins, sizeof(sPinsText) - 1);
+
+    sTxtEntries[0] = (otDnsTxtEntry){"eui", (const uint8_t *)sEuiText, (uint16_t)strlen(sEuiText)};
+    sTxtEntries[1] = (otDnsTxtEntry){"pins", (const uint8_t *)sPinsText, (uint16_t)strlen(sPinsText)};
+    sTxtEntries[2] = (otDnsTxtEntry){"caps", (const uint8_t *)DISCOVERY_CAPS, sizeof(DISCOVERY_CAPS) - 1};
+
+    memset(&sService, 0, sizeof(sService));
+    sService.mName = APP_DISCOVERY_SERVICE;
+    sService.mInstanceName = sHostName;
+    sService.mTxtEntries = sTxtEntries;
+    sService.mNumTxtEntries = sizeof(sTxtEntries) / sizeof(sTxtEntries[0]);
+    sService.mPort = commandPort;
+
+    otError error = otSrpClientSetHostName(sInstance, sHostName);
+    if (error == OT_ERROR_NONE) {
+        error = otSrpClientEnableAutoHostAddress(sInstance);
+    }
+    if (error == OT_ERROR_NONE) {
+        error = otSrpClientAddService(sInstance, &sService);
+    }
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to register SRP service: %d", error);
+        return;
+    }
+
+    // Le client démarre dès qu'un serveur SRP apparaît dans les données réseau
+    otSrpClientEnableAutoStartMode(sInstance, NULL, NULL);
+    ESP_LOGI(TAG, "SRP service %s.%s registered on port %u", sHostName, APP_DISCOVERY_SERVICE, commandPort);
+}
+
+#endif // APP_DISCOVERY_SUPPORTED
+
+void app_discovery_init_locked(otInstance *instance, uint16_t commandPort, const char *pins)
+{
+    if (sInstance != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+
+#if APP_DISCOVERY_SUPPORTED
+    sStats.supported = true;
+    snprintf(sServiceName, sizeof(sServiceName), "%s%s", APP_DISCOVERY_SERVICE, DISCOVERY_DOMAIN);
+    register_service_locked(commandPort, pins);
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = discovery_tick_cb,
+        .name = "discovery_tick",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sTickTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sTickTimer, DISCOVERY_TICK_MS * 1000ULL));
+#else
+    (void)commandPort;
+    (void)pins;
+    ESP_LOGW(TAG, "SRP or DNS client disabled, service discovery off");
+#endif
+}
+
+bool app_discovery_get_by_index_locked(uint16_t index, app_discovery_service_t *outService)
+{
+#if APP_DISCOVERY_SUPPORTED
+    int64_t nowUs = esp_timer_get_time();
+
+    for (int i = 0; i < APP_DISCOVERY_MAX_SERVICES; i++) {
+        if (sCache[i].state == ENTRY_FREE || sCache[i].expiryUs == 0) {
+            continue;
+        }
+        if (index-- == 0) {
+            int64_t leftUs = sCache[i].expiryUs - nowUs;
+            *outService = sCache[i].service;
+            outService->ttlLeftS = (leftUs > 0) ? (uint32_t)(leftUs / 1000000) : 0;
+            return true;
+        }
+    }
+#else
+    (void)index;
+    (void)outService;
+#endif
+
+    return false;
+}
+
+void app_discovery_get_stats_locked(app_discovery_stats_t *outStats)
+{
+    *outStats = sStats;
+    outStats->cached = 0;
+
+#if APP_DISCOVERY_SUPPORTED
+    for (int i = 0; i < APP_DISCOVERY_MAX_SERVICES; i++) {
+        if (sCache[i].state != ENTRY_FREE && sCache[i].expiryUs > 0) {
+            outStats->cached++;
+        }
+    }
+#endif
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Découverte des appareils par SRP/DNS-SD (service « _relay._udp »)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Type de service enregistré par chaque appareil */
+#define APP_DISCOVERY_SERVICE "_relay._udp"
+
+/** Services gardés en cache sur le leader */
+#define APP_DISCOVERY_MAX_SERVICES 32
+
+/** Période de parcours du type de service par le leader */
+#define APP_DISCOVERY_BROWSE_PERIOD_S 60
+
+/** Service résolu, tel que gardé en cache */
+typedef struct {
+    char instance[64];
+    otIp6Address address;
+    uint16_t port;
+    bool hasEui64;
+    uint8_t eui64[8];
+    char pins[16];      // TXT « pins »: broches de contrôle
+    char caps[24];      // TXT « caps »: capacités (gpio, led, tunnel)
+    uint32_t ttlLeftS;  // Avant expiration de l'entrée
+    uint16_t id;        // ID logique dans le registre, 0 sans EUI-64
+} app_discovery_service_t;
+
+/** Mesures de la découverte */
+typedef struct {
+    bool supported;
+    uint32_t browses;
+    uint32_t resolves;
+    uint32_t failures;
+    uint32_t expired;
+    uint16_t cached;
+} app_discovery_stats_t;
+
+/**
+ * @brief Enregistre ce nœud auprès du serveur SRP et démarre le cache du leader
+ *
+ * Chaque nœud publie une instance de APP_DISCOVERY_SERVICE décrivant ses
+ * broches et capacités. Le leader parcourt le type de service, résout chaque
+ * instance, garde le résultat jusqu'à l'expiration de son TTL et l'ajoute au
+ * registre des ID logiques.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param commandPort Port UDP des commandes publié dans l'enregistrement
+ * @param pins Broches de contrôle publiées dans le TXT (« 7,8,9 »)
+ */
+void app_discovery_init_locked(otInstance *instance, uint16_t commandPort, const char *pins);
+
+/**
+ * @brief Lit le service rangé à un indice du cache (verrou OpenThread tenu)
+ *
+ * @return false au-delà du dernier service
+ */
+bool app_discovery_get_by_index_locked(uint16_t index, app_discovery_service_t *outService);
+
+/**
+ * @brief Copie les mesures de la découverte (verrou OpenThread tenu)
+ */
+void app_discovery_get_stats_locked(app_discovery_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
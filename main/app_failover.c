@@ -0,0 +1,458 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bascule du lien hôte entre le nœud principal et un nœud de secours
+ *
+ * Les deux nœuds sont câblés sur la même ligne TX de l'hôte et reçoivent donc
+ * les mêmes octets. Seul le nœud actif les relaie et émet un heartbeat portant
+ * son numéro de séquence; le secours le recopie et conserve les derniers blocs
+ * reçus. Sans heartbeat pendant APP_FAILOVER_TIMEOUT_MS, le secours devient
+ * actif et rejoue les blocs arrivés depuis le dernier heartbeat.
+ *
+ * Le rejeu n'est pas exact: un bloc déjà relayé par l'ancien nœud actif
+ * juste avant sa panne repart une seconde fois. Une commande d'état (niveau
+ * de broche, couleur) répétée ne change rien, mais 0x00 relance l'impulsion
+ * verte. Les liens hôte tunnelés par le nœud actif (annoncés dans le
+ * heartbeat) ne sont ni retenus ni rejoués: leurs octets ne sont pas des
+ * commandes.
+ */
+
+#include "app_failover.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_tunnel.h"
+
+#include "openthread/ip6.h"
+#include "openthread/thread.h"
+#include "openthread/udp.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#define TAG "app_failover"
+
+#define FAILOVER_MSG_HEARTBEAT 0x01
+#define FAILOVER_MSG_LEN       11  // Type, priorité, époque (4), séquence (4), liens hôte tunnelés
+#define FAILOVER_TICK_MS       250
+
+typedef struct {
+    int64_t rxTimeUs;
+    uint16_t len;
+    uint8_t data[APP_FAILOVER_HOLD_CHUNK_BYTES];
+} held_chunk_t;
+
+static otInstance *sInstance = NULL;
+static otUdpSocket sSocket;
+static esp_timer_handle_t sTickTimer = NULL;
+static SemaphoreHandle_t sMutex = NULL;
+static app_failover_forward_fn_t sForward = NULL;
+
+static bool sStarted = false;
+static app_failover_state_t sState = APP_FAILOVER_STATE_LISTENING;
+static app_failover_priority_t sPriority = APP_FAILOVER_PRIORITY_PRIMARY;
+static uint32_t sEpoch = 0;
+static uint32_t sSeq = 0;
+static int64_t sStartUs = 0;
+static int64_t sLastHeartbeatRxUs = 0;
+static int64_t sLastHeartbeatTxUs = 0;
+static int64_t sRouterSinceUs = 0;  // Routeur ou leader depuis: heartbeats audibles, 0 sinon
+static uint32_t sTakeovers = 0;
+static uint32_t sLastFailoverMs = 0;
+static uint32_t sReplayedChunks = 0;
+static uint8_t sPeerTunnelMask = 0;  // Bit n: lien hôte n tunnelé par le nœud actif
+static otIp6Address sPeerAddr;       // Source du dernier heartbeat reçu
+
+static held_chunk_t sHeld[APP_FAILOVER_HOLD_CHUNKS];
+static uint8_t sHeldNext = 0;
+
+// Blocs à rejouer après la prise du lien, tâche esp_timer seulement
+static held_chunk_t sReplay[APP_FAILOVER_HOLD_CHUNKS];
+static int sReplayCount = 0;
+static int sReplayDone = 0;
+
+static void put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = (uint8_t)(value >> 24);
+    buf[1] = (uint8_t)(value >> 16);
+    buf[2] = (uint8_t)(value >> 8);
+    buf[3] = (uint8_t)value;
+}
+
+static uint32_t get_u32(const uint8_t *buf)
+{
+    return ((uint32_t)buf[0] << 24) | ((uint32_t)buf[1] << 16) | ((uint32_t)buf[2] << 8) | buf[3];
+}
+
+// Le pair l'emporte s'il a une priorité supérieure, ou à égalité une époque supérieure
+static bool peer_wins(app_failover_priority_t peerPriority, uint32_t peerEpoch)
+{
+    return (peerPriority > sPriority) || (peerPriority == sPriority && peerEpoch > sEpoch);
+}
+
+static void handle_failover_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    (void)aContext;
+    uint8_t data[FAILOVER_MSG_LEN];
+
+    if (otMessageGetLength(aMessage) != FAILOVER_MSG_LEN ||
+        otMessageRead(aMessage, 0, data, sizeof(data)) != sizeof(data) || data[0] != FAILOVER_MSG_HEARTBEAT) {
+        return;
+    }
+
+    app_failover_priority_t peerPriority = (app_failover_priority_t)data[1];
+    uint32_t peerEpoch = get_u32(&data[2]);
+    uint32_t peerSeq = get_u32(&data[6]);
+    uint8_t peerTunnelMask = data[10];
+
+    if (peerEpoch == sEpoch) {
+        return;
+    }
+
+    xSemaphoreTake(sMutex, portMAX_DELAY);
+    sLastHeartbeatRxUs = esp_timer_get_time();
+    sPeerAddr = aMessageInfo->mPeerAddr;
+
+    if (sState == APP_FAILOVER_STATE_ACTIVE) {
+        // Deux nœuds actifs (partition réparée, principal revenu): un seul garde le lien
+        if (peer_wins(peerPriority, peerEpoch)) {
+            ESP_LOGW(TAG, "Another node holds the host link, yielding");
+            sState = APP_FAILOVER_STATE_STANDBY;
+            sSeq = peerSeq;
+            sPeerTunnelMask = peerTunnelMask;
+        }
+    } else {
+        sState = APP_FAILOVER_STATE_STANDBY;
+        sSeq = peerSeq;
+        sPeerTunnelMask = peerTunnelMask;
+    }
+
+    xSemaphoreGive(sMutex);
+}
+
+static void send_heartbeat(void)
+{
+    uint8_t data[FAILOVER_MSG_LEN];
+    otIp6Address realmLocalAllRouters;
+
+    data[0] = FAILOVER_MSG_HEARTBEAT;
+    data[1] = (uint8_t)sPriority;
+    put_u32(&data[2], sEpoch);
+    put_u32(&data[6], sSeq);
+    data[10] = 0;
+    for (int channel = 0; channel < APP_INGRESS_CHANNEL_COUNT; channel++) {
+        if (app_tunnel_is_bound((app_ingress_channel_t)channel)) {
+            data[10] |= (uint8_t)(1u << channel);
+        }
+    }
+    // Routeurs seulement: les MED/SED ne sont ni réveillés ni servis en indirect par leur parent
+    otIp6AddressFromString("ff03::2", &realmLocalAllRouters);
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    otMessage *message = otUdpNewMessage(sInstance, NULL);
+    if (message == NULL) {
+        app_cbwatch_end_locked(APP_CBWATCH_TICK_FAILOVER, start);
+        esp_openthread_lock_release();
+        return;
+    }
+
+    otMessageInfo messageInfo;
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = realmLocalAllRouters;
+    messageInfo.mPeerPort = APP_FAILOVER_PORT;
+
+    if (otMessageAppend(message, data, sizeof(data)) != OT_ERROR_NONE ||
+        otUdpSend(sInstance, &sSocket, message, &messageInfo) != OT_ERROR_NONE) {
+        otMessageFree(message);
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_FAILOVER, start);
+    esp_openthread_lock_release();
+}
+
+/**
+ * @brief Prise du lien hôte: passage actif et sélection des blocs à rejouer
+ *
+ * Appelée mutex tenu. Les blocs reçus depuis une période de heartbeat avant
+ * le dernier heartbeat ont pu ne pas être relayés par l'ancien nœud actif;
+ * certains l'ont été et partiront deux fois.
+ *
+ * @return Nombre de blocs copiés dans replay
+ */
+static int take_over_locked(int64_t nowUs, held_chunk_t *replay)
+{
+    int64_t sinceUs = (sLastHeartbeatRxUs > 0) ? sLastHeartbeatRxUs - APP_FAILOVER_HEARTBEAT_MS * 1000LL : 0;
+    int count = 0;
+
+    sState = APP_FAILOVER_STATE_ACTIVE;
+    if (sLastHeartbeatRxUs > 0) {
+        sTakeovers++;
+        sLastFailoverMs = (uint32_t)((nowUs - sLastHeartbeatRxUs) / 1000);
+        ESP_LOGW(TAG, "Host link taken over %lu ms after last heartbeat (seq %lu)",
+                 (unsigned long)sLastFailoverMs, (unsigned long)sSeq);
+    } else {
+        ESP_LOGI(TAG, "No active node heard, holding the host link");
+    }
+
+    // Parcours du plus ancien au plus récent pour conserver l'ordre de l'hôte
+    for (int i = 0; i < APP_FAILOVER_HOLD_CHUNKS; i++) {
+        held_chunk_t *chunk = &sHeld[(sHeldNext + i) % APP_FAILOVER_HOLD_CHUNKS];
+        if (chunk->len > 0 && chunk->rxTimeUs >= sinceUs) {
+            replay[count++] = *chunk;
+        }
+        chunk->len = 0;
+    }
+    sPeerTunnelMask = 0;
+
+    return count;
+}
+
+/**
+ * @brief Rejoue les blocs en attente, verrou OpenThread attendu au plus APP_LOCK_WAIT_MS
+ *
+ * Verrou occupé: les blocs restants partent au tick suivant, dans l'ordre.
+ */
+static void replay_pending(void)
+{
+    if (sReplayDone >= sReplayCount || sForward == NULL) {
+        return;
+    }
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    for (; sReplayDone < sReplayCount; sReplayDone++) {
+        if (sForward(sReplay[sReplayDone].data, sReplay[sReplayDone].len)) {
+            app_failover_note_forwarded();
+        }
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_FAILOVER, start);
+    esp_openthread_lock_release();
+}
+
+static void failover_tick_cb(void *arg)
+{
+    (void)arg;
+    int replayCount = -1;
+    bool heartbeatDue = false;
+    int64_t nowUs = esp_timer_get_time();
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    otDeviceRole role = otThreadGetDeviceRole(sInstance);
+    esp_openthread_lock_release();
+
+    xSemaphoreTake(sMutex, portMAX_DELAY);
+
+    /*
+     * Les heartbeats vont aux routeurs: un nœud encore enfant ne les entend
+     * pas et ne peut pas relayer. Il ne prend pas le lien, et le silence
+     * n'est compté qu'à partir de son passage en routeur.
+     */
+    if (role != OT_DEVICE_ROLE_ROUTER && role != OT_DEVICE_ROLE_LEADER) {
+        sRouterSinceUs = 0;
+    } else if (sRouterSinceUs == 0) {
+        sRouterSinceUs = nowUs;
+    }
+    int64_t heardUs = (sLastHeartbeatRxUs > sRouterSinceUs) ? sLastHeartbeatRxUs : sRouterSinceUs;
+
+    switch (sState) {
+    case APP_FAILOVER_STATE_LISTENING: {
+        // Le secours écoute plus longtemps pour laisser la main au principal au démarrage
+        int64_t windowUs = APP_FAILOVER_TIMEOUT_MS * 1000LL * ((sPriority == APP_FAILOVER_PRIORITY_PRIMARY) ? 1 : 2);
+        int64_t sinceUs = (sStartUs > sRouterSinceUs) ? sStartUs : sRouterSinceUs;
+        if (sRouterSinceUs != 0 && nowUs - sinceUs >= windowUs) {
+            replayCount = take_over_locked(nowUs, sReplay);
+            heartbeatDue = true;
+        }
+        break;
+    }
+    case APP_FAILOVER_STATE_STANDBY:
+        if (sRouterSinceUs != 0 && nowUs - heardUs >= APP_FAILOVER_TIMEOUT_MS * 1000LL) {
+            replayCount = take_over_locked(nowUs, sReplay);
+            heartbeatDue = true;
+        }
+        break;
+    case APP_FAILOVER_STATE_ACTIVE:
+        heartbeatDue = (nowUs - sLastHeartbeatTxUs >= APP_FAILOVER_HEARTBEAT_MS * 1000LL);
+        break;
+    }
+
+    if (heartbeatDue) {
+        sLastHeartbeatTxUs = nowUs;
+    }
+    if (replayCount >= 0) {
+        sReplayedChunks += replayCount;
+    }
+
+    xSemaphoreGive(sMutex);
+
+    if (replayCount >= 0) {
+        sReplayCount = replayCount;
+        sReplayDone = 0;
+    }
+    if (heartbeatDue) {
+        send_heartbeat();
+    }
+    replay_pending();
+}
+
+void app_failover_start(otInstance *instance, app_failover_priority_t priority, app_failover_forward_fn_t forward)
+{
+    if (sStarted) {
+        return;
+    }
+
+    sInstance = instance;
+    sPriority = priority;
+    sForward = forward;
+    sEpoch = esp_random();
+    sStartUs = esp_timer_get_time();
+    sMutex = xSemaphoreCreateMutex();
+    if (sMutex == NULL) {
+        ESP_LOGE(TAG, "Failed to create failover mutex");
+        return;
+    }
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    otError error =
+        app_cbwatch_udp_open_locked(instance, &sSocket, handle_failover_receive, NULL, APP_CBWATCH_UDP_FAILOVER);
+    if (error == OT_ERROR_NONE) {
+        otSockAddr sockaddr;
+        memset(&sockaddr, 0, sizeof(sockaddr));
+        sockaddr.mPort = APP_FAILOVER_PORT;
+        error = otUdpBind(instance, &sSocket, &sockaddr, OT_NETIF_THREAD_INTERNAL);
+        if (error != OT_ERROR_NONE) {
+            otUdpClose(instance, &sSocket);
+        }
+    }
+    esp_openthread_lock_release();
+
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to open failover UDP socket: %d", error);
+        return;
+    }
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = failover_tick_cb,
+        .name = "failover",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sTickTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sTickTimer, FAILOVER_TICK_MS * 1000ULL));
+
+    sStarted = true;
+    ESP_LOGI(TAG, "Host link failover started as %s", (priority == APP_FAILOVER_PRIORITY_PRIMARY) ? "primary" : "standby");
+}
+
+bool app_failover_is_active(void)
+{
+    return !sStarted || sState == APP_FAILOVER_STATE_ACTIVE;
+}
+
+bool app_failover_is_started(void)
+{
+    return sStarted;
+}
+
+bool app_failover_get_active_peer(otIp6Address *outAddr)
+{
+    bool known;
+
+    if (!sStarted) {
+        return false;
+    }
+
+    xSemaphoreTake(sMutex, portMAX_DELAY);
+    known = (sState == APP_FAILOVER_STATE_STANDBY &&
+             esp_timer_get_time() - sLastHeartbeatRxUs < APP_FAILOVER_TIMEOUT_MS * 1000LL);
+    if (known) {
+        *outAddr = sPeerAddr;
+    }
+    xSemaphoreGive(sMutex);
+    return known;
+}
+
+void app_failover_hold(app_ingress_channel_t channel, const uint8_t *data, int len)
+{
+    if (!sStarted || len <= 0) {
+        return;
+    }
+
+    // Ne garder que la fin d'un bloc trop long: l'état le plus récent y figure
+    if (len > APP_FAILOVER_HOLD_CHUNK_BYTES) {
+        data += len - APP_FAILOVER_HOLD_CHUNK_BYTES;
+        len = APP_FAILOVER_HOLD_CHUNK_BYTES;
+    }
+
+    xSemaphoreTake(sMutex, portMAX_DELAY);
+    if (sPeerTunnelMask & (1u << channel)) {
+        xSemaphoreGive(sMutex);
+        return;
+    }
+    held_chunk_t *chunk = &sHeld[sHeldNext];
+    chunk->rxTimeUs = esp_timer_get_time();
+    chunk->len = (uint16_t)len;
+    memcpy(chunk->data, data, len);
+    sHeldNext = (sHeldNext + 1) % APP_FAILOVER_HOLD_CHUNKS;
+    xSemaphoreGive(sMutex);
+}
+
+void app_failover_note_forwarded(void)
+{
+    if (!sStarted) {
+        return;
+    }
+
+    xSemaphoreTake(sMutex, portMAX_DELAY);
+    sSeq++;
+    xSemaphoreGive(sMutex);
+}
+
+void app_failover_get_status(app_failover_status_t *outStatus)
+{
+    memset(outStatus, 0, sizeof(*outStatus));
+    if (!sStarted) {
+        outStatus->state = APP_FAILOVER_STATE_ACTIVE;
+        outStatus->lastHeartbeatAgeMs = -1;
+        return;
+    }
+
+    xSemaphoreTake(sMutex, portMAX_DELAY);
+    outStatus->state = sState;
+    outStatus->priority = sPriority;
+    outStatus->seq = sSeq;
+    outStatus->takeovers = sTakeovers;
+    outStatus->lastFailoverMs = sLastFailoverMs;
+    outStatus->replayedChunks = sReplayedChunks;
+    outStatus->lastHeartbeatAgeMs = (sLastHeartbeatRxUs > 0) ? (esp_timer_get_time() - sLastHeartbeatRxUs) / 1000 : -1;
+    xSemaphoreGive(sMutex);
+}
+
+const char *app_failover_state_to_string(app_failover_state_t state)
+{
+    switch (state) {
+    case APP_FAILOVER_STATE_LISTENING:
+        return "listening";
+    case APP_FAILOVER_STATE_STANDBY:
+        return "standby";
+    case APP_FAILOVER_STATE_ACTIVE:
+        return "active";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Bascule du lien hôte entre le nœud principal et un nœud de secours
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_ingress.h"
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Port UDP des heartbeats, distinct des commandes et de la sonde */
+#define APP_FAILOVER_PORT 12347
+
+/** Période des heartbeats du nœud actif */
+#define APP_FAILOVER_HEARTBEAT_MS 1000
+
+/** Silence au-delà duquel le secours prend le lien hôte (3 heartbeats manqués) */
+#define APP_FAILOVER_TIMEOUT_MS 3000
+
+/** Nombre de blocs UART conservés par le secours pour rejouer après bascule */
+#define APP_FAILOVER_HOLD_CHUNKS 8
+
+/** Octets conservés par bloc (la fin du bloc, donc l'état le plus récent) */
+#define APP_FAILOVER_HOLD_CHUNK_BYTES 128
+
+/** Priorité du nœud: le principal l'emporte si les deux sont actifs */
+typedef enum {
+    APP_FAILOVER_PRIORITY_STANDBY = 1,
+    APP_FAILOVER_PRIORITY_PRIMARY = 2,
+} app_failover_priority_t;
+
+typedef enum {
+    APP_FAILOVER_STATE_LISTENING = 0,   // Démarrage: écoute d'un nœud déjà actif
+    APP_FAILOVER_STATE_STANDBY,         // Un autre nœud tient le lien hôte
+    APP_FAILOVER_STATE_ACTIVE,          // Ce nœud relaie les commandes de l'hôte
+} app_failover_state_t;
+
+/**
+ * @brief Fonction d'envoi des trames hôte, appelée pour rejouer après une bascule
+ *
+ * Appelée depuis la tâche esp_timer, verrou OpenThread tenu (attendu au plus
+ * 50 ms, sinon le rejeu reprend au tick suivant).
+ */
+typedef bool (*app_failover_forward_fn_t)(const uint8_t *data, uint16_t len);
+
+typedef struct {
+    app_failover_state_t state;
+    app_failover_priority_t priority;
+    uint32_t seq;
+    uint32_t takeovers;
+    uint32_t lastFailoverMs;
+    uint32_t replayedChunks;
+    int64_t lastHeartbeatAgeMs;     // -1 si aucun heartbeat reçu
+} app_failover_status_t;
+
+/**
+ * @brief Démarre la gestion du lien hôte redondant
+ *
+ * @param instance Instance OpenThread
+ * @param priority Priorité du nœud (principal ou secours)
+ * @param forward Fonction d'envoi utilisée pour rejouer les trames retenues
+ */
+void app_failover_start(otInstance *instance, app_failover_priority_t priority, app_failover_forward_fn_t forward);
+
+/**
+ * @brief Indique si ce nœud doit relayer les trames de l'hôte
+ *
+ * Toujours vrai si app_failover_start() n'a pas été appelée.
+ */
+bool app_failover_is_active(void);
+
+/**
+ * @brief Indique si ce nœud est câblé sur le lien hôte (principal ou secours)
+ */
+bool app_failover_is_started(void);
+
+/**
+ * @brief Adresse du nœud actif, vue par le secours dans ses heartbeats
+ *
+ * @param outAddr Adresse source du dernier heartbeat
+ * @return false si ce nœud n'est pas en secours ou si le nœud actif se tait
+ */
+bool app_failover_get_active_peer(otIp6Address *outAddr);
+
+/**
+ * @brief Conserve un bloc reçu de l'hôte pendant que l'autre nœud est actif
+ *
+ * Rien n'est conservé pour un lien que le nœud actif a ouvert en tunnel.
+ *
+ * @param channel Lien hôte d'origine
+ */
+void app_failover_hold(app_ingress_channel_t channel, const uint8_t *data, int len);
+
+/**
+ * @brief Signale qu'une trame hôte a été relayée (numéro de séquence annoncé)
+ */
+void app_failover_note_forwarded(void);
+
+/**
+ * @brief Copie l'état courant de la bascule
+ */
+void app_failover_get_status(app_failover_status_t *outStatus);
+
+/**
+ * @brief Retourne le nom court d'un état ("listening", "standby", "active")
+ */
+const char *app_failover_state_to_string(app_failover_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
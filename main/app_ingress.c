@@ -0,0 +1,301 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Liens hôte multiples (UART0/UART1/USB Serial/JTAG) fusionnés vers l'envoi
+ */
+
+#include "app_ingress.h"
+
+#include <string.h>
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#include "driver/uart.h"
+#if CONFIG_APP_HOST_USB_SERIAL_JTAG_ENABLE
+#include "driver/usb_serial_jtag.h"
+#endif
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#define TAG "app_ingress"
+
+#define UART0_TX_PIN    16
+#define UART0_RX_PIN    17
+#define UART_BAUD_RATE  115200
+#define UART_RX_BUF_SIZE 2048
+
+#define READ_TIMEOUT_MS     2000
+#define USB_WRITE_TIMEOUT_MS 20
+
+typedef struct {
+    uint16_t len;
+    uint8_t data[APP_INGRESS_FRAME_MAX];
+} ingress_frame_t;
+
+/** Opérations d'un lien hôte: ajouter un canal revient à fournir ces fonctions */
+typedef struct {
+    const char *name;
+    esp_err_t (*init)(void);
+    int (*read)(uint8_t *buf, uint32_t size, TickType_t timeout);
+    void (*write)(const uint8_t *buf, uint16_t len);
+    uint8_t weight;
+} ingress_channel_ops_t;
+
+typedef struct {
+    bool active;  // Pilote, file et tâche de lecture en place: un lien en échec est ignoré
+    QueueHandle_t queue;
+    uint32_t deficit;
+    app_ingress_counters_t counters;
+} ingress_channel_state_t;
+
+static esp_err_t uart_channel_install(uart_port_t port, int txPin, int rxPin)
+{
+    uart_config_t uart_config = {
+        .baud_rate = UART_BAUD_RATE,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t err = uart_driver_install(port, UART_RX_BUF_SIZE, 0, 0, NULL, 0);
+    if (err == ESP_OK) {
+        err = uart_param_config(port, &uart_config);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_pin(port, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    }
+    return err;
+}
+
+static esp_err_t uart0_init(void)
+{
+    return uart_channel_install(UART_NUM_0, UART0_TX_PIN, UART0_RX_PIN);
+}
+
+static int uart0_read(uint8_t *buf, uint32_t size, TickType_t timeout)
+{
+    return uart_read_bytes(UART_NUM_0, buf, size, timeout);
+}
+
+static void uart0_write(const uint8_t *buf, uint16_t len)
+{
+    uart_write_bytes(UART_NUM_0, (const char *)buf, len);
+}
+
+#if CONFIG_APP_HOST_UART1_ENABLE
+static esp_err_t uart1_init(void)
+{
+    return uart_channel_install(UART_NUM_1, CONFIG_APP_HOST_UART1_TX_PIN, CONFIG_APP_HOST_UART1_RX_PIN);
+}
+
+static int uart1_read(uint8_t *buf, uint32_t size, TickType_t timeout)
+{
+    return uart_read_bytes(UART_NUM_1, buf, size, timeout);
+}
+
+static void uart1_write(const uint8_t *buf, uint16_t len)
+{
+    uart_write_bytes(UART_NUM_1, (const char *)buf, len);
+}
+#endif
+
+#if CONFIG_APP_HOST_USB_SERIAL_JTAG_ENABLE
+static esp_err_t usb_init(void)
+{
+    usb_serial_jtag_driver_config_t usb_config = USB_SERIAL_JTAG_DRIVER_CONFIG_DEFAULT();
+    return usb_serial_jtag_driver_install(&usb_config);
+}
+
+static int usb_read(uint8_t *buf, uint32_t size, TickType_t timeout)
+{
+    return usb_serial_jtag_read_bytes(buf, size, timeout);
+}
+
+static void usb_write(const uint8_t *buf, uint16_t len)
+{
+    usb_serial_jtag_write_bytes(buf, len, pdMS_TO_TICKS(USB_WRITE_TIMEOUT_MS));
+}
+#endif
+
+static const ingress_channel_ops_t sChannelOps[APP_INGRESS_CHANNEL_COUNT] = {
+    [APP_INGRESS_CHANNEL_UART0] = {"uart0", uart0_init, uart0_read, uart0_write, CONFIG_APP_HOST_UART0_WEIGHT},
+#if CONFIG_APP_HOST_UART1_ENABLE
+    [APP_INGRESS_CHANNEL_UART1] = {"uart1", uart1_init, uart1_read, uart1_write, CONFIG_APP_HOST_UART1_WEIGHT},
+#endif
+#if CONFIG_APP_HOST_USB_SERIAL_JTAG_ENABLE
+    [APP_INGRESS_CHANNEL_USB_SERIAL_JTAG] = {"usb", usb_init, usb_read, usb_write, CONFIG_APP_HOST_USB_SERIAL_JTAG_WEIGHT},
+#endif
+};
+
+static ingress_channel_state_t sChannels[APP_INGRESS_CHANNEL_COUNT];
+static portMUX_TYPE sCountersLock = portMUX_INITIALIZER_UNLOCKED;
+static TaskHandle_t sDispatchTask = NULL;
+static app_ingress_sink_fn_t sSink = NULL;
+
+/**
+ * @brief Tâche de lecture d'un canal: découpe le flux en trames et les met en file
+ *
+ * @param pvParameters Index du canal
+ */
+static void ingress_read_task(void *pvParameters)
+{
+    app_ingress_channel_t channel = (app_ingress_channel_t)(uintptr_t)pvParameters;
+    const ingress_channel_ops_t *ops = &sChannelOps[channel];
+    ingress_channel_state_t *state = &sChannels[channel];
+    ingress_frame_t frame;
+
+    while (1) {
+        int len = ops->read(frame.data, sizeof(frame.data), pdMS_TO_TICKS(READ_TIMEOUT_MS));
+        if (len <= 0) {
+            ESP_LOGD(TAG, "%s: waiting for data...", ops->name);
+            continue;
+        }
+
+        frame.len = (uint16_t)len;
+        bool queued = (xQueueSend(state->queue, &frame, 0) == pdTRUE);
+        uint32_t depth = uxQueueMessagesWaiting(state->queue);
+
+        portENTER_CRITICAL(&sCountersLock);
+        state->counters.rxBytes += len;
+        state->counters.rxFrames++;
+        if (!queued) {
+            state->counters.dropped++;
+        }
+        if (depth > state->counters.maxQueueDepth) {
+            state->counters.maxQueueDepth = depth;
+        }
+        portEXIT_CRITICAL(&sCountersLock);
+
+        if (queued) {
+            xTaskNotifyGive(sDispatchTask);
+        } else {
+            ESP_LOGW(TAG, "%s: queue full, frame dropped", ops->name);
+        }
+    }
+}
+
+/**
+ * @brief Tâche de répartition: round-robin à déficit pondéré entre les canaux
+ *
+ * À chaque tour, un canal non vide reçoit weight * APP_INGRESS_QUANTUM_BYTES
+ * octets de crédit et remet ses trames tant que le crédit couvre la suivante.
+ * Un canal vidé perd son crédit restant pour ne pas le cumuler.
+ *
+ * @param pvParameters Paramètres de la tâche (non utilisés)
+ */
+static void ingress_dispatch_task(void *pvParameters)
+{
+    (void)pvParameters;
+    ingress_frame_t frame;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        bool pending = true;
+        while (pending) {
+            pending = false;
+
+            for (int channel = 0; channel < APP_INGRESS_CHANNEL_COUNT; channel++) {
+                ingress_channel_state_t *state = &sChannels[channel];
+
+                if (!state->active) {
+                    continue;
+                }
+                if (uxQueueMessagesWaiting(state->queue) == 0) {
+                    state->deficit = 0;
+                    continue;
+                }
+
+                state->deficit += sChannelOps[channel].weight * APP_INGRESS_QUANTUM_BYTES;
+                while (xQueuePeek(state->queue, &frame, 0) == pdTRUE && frame.len <= state->deficit) {
+                    xQueueReceive(state->queue, &frame, 0);
+                    state->deficit -= frame.len;
+                    sSink((app_ingress_channel_t)channel, frame.data, frame.len);
+
+                    portENTER_CRITICAL(&sCountersLock);
+                    state->counters.dispatched++;
+                    portEXIT_CRITICAL(&sCountersLock);
+                }
+
+                if (uxQueueMessagesWaiting(state->queue) > 0) {
+                    pending = true;
+                } else {
+                    state->deficit = 0;
+                }
+            }
+        }
+    }
+}
+
+void app_ingress_start(app_ingress_sink_fn_t sink)
+{
+    sSink = sink;
+
+    if (xTaskCreate(ingress_dispatch_task, "ingress_dispatch", 4096, NULL, 5, &sDispatchTask) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create dispatch task");
+        return;
+    }
+
+    for (int channel = 0; channel < APP_INGRESS_CHANNEL_COUNT; channel++) {
+        const ingress_channel_ops_t *ops = &sChannelOps[channel];
+
+        esp_err_t err = ops->init();
+        if (err != ESP_OK) {
+            ESP_LOGE(TAG, "Failed to init %s: %s", ops->name, esp_err_to_name(err));
+            continue;
+        }
+
+        sChannels[channel].queue = xQueueCreate(APP_INGRESS_QUEUE_LEN, sizeof(ingress_frame_t));
+        if (sChannels[channel].queue == NULL) {
+            ESP_LOGE(TAG, "Failed to create %s queue", ops->name);
+            continue;
+        }
+
+        // Pile de 3 Ko: une trame locale et les appels au pilote
+        sChannels[channel].active = true;
+        if (xTaskCreate(ingress_read_task, ops->name, 3072, (void *)(uintptr_t)channel, 5, NULL) != pdPASS) {
+            ESP_LOGE(TAG, "Failed to create %s read task", ops->name);
+            sChannels[channel].active = false;
+            vQueueDelete(sChannels[channel].queue);
+            sChannels[channel].queue = NULL;
+            continue;
+        }
+
+        ESP_LOGI(TAG, "Host link %s ready (weight %u)", ops->name, ops->weight);
+    }
+}
+
+void app_ingress_write(app_ingress_channel_t channel, const uint8_t *data, uint16_t len)
+{
+    if (channel < APP_INGRESS_CHANNEL_COUNT && sChannels[channel].active) {
+        sChannelOps[channel].write(data, len);
+    }
+}
+
+const char *app_ingress_channel_name(app_ingress_channel_t channel)
+{
+    if (channel >= APP_INGRESS_CHANNEL_COUNT) {
+        return "unknown";
+    }
+
+    return sChannelOps[channel].name;
+}
+
+void app_ingress_get_counters(app_ingress_channel_t channel, app_ingress_counters_t *outCounters)
+{
+    memset(outCounters, 0, sizeof(*outCounters));
+    if (channel >= APP_INGRESS_CHANNEL_COUNT) {
+        return;
+    }
+
+    portENTER_CRITICAL(&sCountersLock);
+    *outCounters = sChannels[channel].counters;
+    portEXIT_CRITICAL(&sCountersLock);
+}
@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Liens hôte multiples (UART0/UART1/USB Serial/JTAG) fusionnés vers l'envoi
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sdkconfig.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Taille maximale d'une trame hôte dans la file d'un canal */
+#define APP_INGRESS_FRAME_MAX 128
+
+/** Profondeur de la file de chaque canal */
+#define APP_INGRESS_QUEUE_LEN 8
+
+/** Octets accordés par tour de round-robin et par unité de poids */
+#define APP_INGRESS_QUANTUM_BYTES APP_INGRESS_FRAME_MAX
+
+/** Canaux d'entrée compilés selon la configuration */
+typedef enum {
+    APP_INGRESS_CHANNEL_UART0 = 0,
+#if CONFIG_APP_HOST_UART1_ENABLE
+    APP_INGRESS_CHANNEL_UART1,
+#endif
+#if CONFIG_APP_HOST_USB_SERIAL_JTAG_ENABLE
+    APP_INGRESS_CHANNEL_USB_SERIAL_JTAG,
+#endif
+    APP_INGRESS_CHANNEL_COUNT,
+} app_ingress_channel_t;
+
+/** Compteurs d'un canal */
+typedef struct {
+    uint32_t rxBytes;
+    uint32_t rxFrames;
+    uint32_t dropped;       // Trames perdues: file du canal pleine
+    uint32_t dispatched;    // Trames remises au chemin d'envoi
+    uint32_t maxQueueDepth;
+} app_ingress_counters_t;
+
+/**
+ * @brief Traitement d'une trame hôte, appelé depuis la tâche de répartition
+ *
+ * @param channel Canal d'origine (pour répondre sur le même lien)
+ * @param data Trame reçue
+ * @param len Longueur en octets
+ */
+typedef void (*app_ingress_sink_fn_t)(app_ingress_channel_t channel, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Initialise les canaux configurés et démarre lecture et répartition
+ *
+ * Chaque canal a sa tâche de lecture et sa file. Une tâche unique répartit
+ * les trames vers sink selon un round-robin à déficit pondéré: un canal
+ * chargé ne peut pas affamer les autres. Un canal dont le pilote, la file
+ * ou la tâche n'a pas pu être créé reste inactif: les autres fonctionnent.
+ *
+ * @param sink Traitement des trames fusionnées
+ */
+void app_ingress_start(app_ingress_sink_fn_t sink);
+
+/**
+ * @brief Écrit une réponse sur le lien hôte d'un canal (sans effet sur un canal inactif)
+ */
+void app_ingress_write(app_ingress_channel_t channel, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Retourne le nom d'un canal ("uart0", "uart1", "usb")
+ */
+const char *app_ingress_channel_name(app_ingress_channel_t channel);
+
+/**
+ * @brief Copie les compteurs d'un canal
+ */
+void app_ingress_get_counters(app_ingress_channel_t channel, app_ingress_counters_t *outCounters);
+
+#ifdef __cplusplus
+}
+#endif
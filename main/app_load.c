@@ -0,0 +1,56 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Profils de charge: tailles des files et du pool de messages OpenThread
+ */
+
+#include "app_load.h"
+
+#include <string.h>
+
+#include "sdkconfig.h"
+
+#include "openthread/message.h"
+#include "openthread/thread.h"
+
+static uint32_t sStartHeapBytes = 0;
+
+const char *app_load_profile_name(void)
+{
+#if CONFIG_APP_LOAD_PROFILE_ROUTER
+    return "router";
+#elif CONFIG_APP_LOAD_PROFILE_SLEEPY
+    return "sleepy";
+#elif CONFIG_APP_LOAD_PROFILE_OTA
+    return "ota";
+#else
+    return "default";
+#endif
+}
+
+void app_load_set_start_heap(uint32_t bytes)
+{
+    sStartHeapBytes = bytes;
+}
+
+void app_load_get_usage_locked(otInstance *instance, app_load_usage_t *outUsage)
+{
+    otBufferInfo bufferInfo;
+    const otIpCounters *ipCounters = otThreadGetIp6Counters(instance);
+
+    otMessageGetBufferInfo(instance, &bufferInfo);
+
+    memset(outUsage, 0, sizeof(*outUsage));
+    outUsage->profile = app_load_profile_name();
+    outUsage->taskQueueSize = CONFIG_APP_OT_TASK_QUEUE_SIZE;
+    outUsage->netifQueueSize = CONFIG_APP_OT_NETIF_QUEUE_SIZE;
+    outUsage->totalBuffers = bufferInfo.mTotalBuffers;
+    outUsage->freeBuffers = bufferInfo.mFreeBuffers;
+    outUsage->maxUsedBuffers = bufferInfo.mMaxUsedBuffers;
+    outUsage->poolBytes = (uint32_t)bufferInfo.mTotalBuffers * APP_LOAD_MESSAGE_BUFFER_SIZE;
+    outUsage->startHeapBytes = sStartHeapBytes;
+    outUsage->ip6TxFailures = ipCounters->mTxFailure;
+    outUsage->ip6RxFailures = ipCounters->mRxFailure;
+}
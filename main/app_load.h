@@ -0,0 +1,57 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Profils de charge: tailles des files et du pool de messages OpenThread
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Taille d'un tampon de message OpenThread (32 pointeurs sur une cible 32 bits) */
+#define APP_LOAD_MESSAGE_BUFFER_SIZE 128
+
+/** Dimensionnement et occupation mesurée du profil compilé */
+typedef struct {
+    const char *profile;
+    uint16_t taskQueueSize;
+    uint16_t netifQueueSize;
+    uint16_t totalBuffers;
+    uint16_t freeBuffers;
+    uint16_t maxUsedBuffers;
+    uint32_t poolBytes;      // RAM statique du pool de messages
+    uint32_t startHeapBytes; // Tas consommé par esp_openthread_start (files comprises)
+    uint32_t ip6TxFailures;
+    uint32_t ip6RxFailures;
+} app_load_usage_t;
+
+/**
+ * @brief Retourne le nom du profil de charge compilé
+ *        ("default", "router", "sleepy", "ota")
+ */
+const char *app_load_profile_name(void);
+
+/**
+ * @brief Enregistre le tas consommé par le démarrage d'OpenThread
+ */
+void app_load_set_start_heap(uint32_t bytes);
+
+/**
+ * @brief Relève le dimensionnement et l'occupation du pool de messages
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param outUsage Mesures
+ */
+void app_load_get_usage_locked(otInstance *instance, app_load_usage_t *outUsage);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Attente du verrou OpenThread hors de la tâche OpenThread
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Attente maximale du verrou OpenThread depuis une temporisation esp_timer
+ *
+ * La tâche esp_timer est partagée par toutes les temporisations: un passage
+ * qui n'obtient pas le verrou dans ce délai est sauté, le suivant rattrape.
+ */
+#define APP_LOCK_WAIT_MS 50
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,539 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Relevé de la topologie par diagnostics réseau et flux de deltas vers l'hôte
+ */
+
+#include "app_netdiag.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_coex.h"
+#include "app_lock.h"
+#include "app_pack.h"
+
+#include "openthread/message.h"
+#include "openthread/netdiag.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/message_buffer.h"
+#include "freertos/task.h"
+
+#define TAG "app_netdiag"
+
+#define NETDIAG_TICK_MS 250
+#define NETDIAG_RESPONSE_TIMEOUT_MS 30000  // Filet: la pile rappelle déjà en cas d'échec CoAP
+#define NETDIAG_RETRY_MS 1000
+
+// Port TMF (CoAP de gestion Thread) et en-tête CoAP d'une réponse Diagnostic Get
+#define NETDIAG_TMF_PORT 61631
+#define NETDIAG_COAP_OVERHEAD 12
+
+// Trame pleine à 250 kbit/s, ACK, délais inter-trames et backoff CSMA moyen
+#define NETDIAG_FRAME_AIRTIME_US 5000
+
+#define NETDIAG_STREAM_SIZE 2048
+#define NETDIAG_PAYLOAD_MAX (APP_NETDIAG_MAX_ROUTERS * 4)
+#define NETDIAG_RECORD_MAX  (APP_NETDIAG_RECORD_HEADER_LEN + NETDIAG_PAYLOAD_MAX)
+
+// Chaque message du tampon est précédé de sa longueur
+#define NETDIAG_MESSAGE_OVERHEAD sizeof(size_t)
+
+typedef struct {
+    bool used;
+    uint8_t routerId;
+    int64_t updatedUs;
+    app_netdiag_node_t node;
+} tracked_router_t;
+
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sTickTimer = NULL;
+static MessageBufferHandle_t sStream = NULL;
+static TaskHandle_t sWriterTask = NULL;
+
+static tracked_router_t sRouters[APP_NETDIAG_MAX_ROUTERS];
+static app_netdiag_stats_t sStats;
+
+static bool sAwaiting = false;
+static uint8_t sAwaitingId = 0;
+static int64_t sDeadlineUs = 0;
+static uint8_t sQueryHops = 0;
+static uint16_t sQueryBudget = 0;
+static uint8_t sCursor = 0;
+static int64_t sSweepStartUs = 0;
+static int64_t sNextQueryUs = 0;
+static int64_t sStartUs = 0;
+static uint64_t sAirtimeUs = 0;
+
+static bool sSubscribed = false;
+static bool sResyncPending = false;
+static app_ingress_channel_t sChannel = APP_INGRESS_CHANNEL_UART0;
+static uint8_t sSeq = 0;
+
+/*
+ * Tâche d'écriture: le lien série peut bloquer, jamais la tâche OpenThread.
+ * Un enregistrement part en une seule écriture: un écho ou une réponse
+ * d'état sur le même lien ne peut pas s'intercaler au milieu.
+ */
+static void netdiag_writer_task(void *pvParameters)
+{
+    (void)pvParameters;
+    uint8_t record[NETDIAG_RECORD_MAX];
+
+    while (1) {
+        size_t len = xMessageBufferReceive(sStream, record, sizeof(record), portMAX_DELAY);
+        if (len > 0) {
+            app_ingress_write(sChannel, record, (uint16_t)len);
+        }
+    }
+}
+
+// Enregistrement entier ou rien: un enregistrement tronqué désynchroniserait l'hôte
+static void emit_locked(app_netdiag_record_t type, uint16_t rloc16, const uint8_t *payload, uint8_t len)
+{
+    uint8_t record[NETDIAG_RECORD_MAX];
+    size_t total = APP_NETDIAG_RECORD_HEADER_LEN + len;
+
+    if (!sSubscribed) {
+        return;
+    }
+
+    if (xMessageBufferSpacesAvailable(sStream) < total + NETDIAG_MESSAGE_OVERHEAD) {
+        sStats.streamDrops++;
+        sResyncPending = true;
+        return;
+    }
+
+    record[0] = APP_NETDIAG_OPCODE;
+    record[1] = sSeq++;
+    record[2] = (uint8_t)type;
+    record[3] = (uint8_t)(rloc16 >> 8);
+    record[4] = (uint8_t)(rloc16 & 0xff);
+    record[5] = len;
+    if (len > 0) {
+        memcpy(&record[APP_NETDIAG_RECORD_HEADER_LEN], payload, len);
+    }
+
+    xMessageBufferSend(sStream, record, total, 0);
+    sStats.records++;
+    sStats.streamBytes += total;
+}
+
+static void emit_routes_locked(const app_netdiag_node_t *node)
+{
+    uint8_t payload[NETDIAG_PAYLOAD_MAX];
+    uint8_t len = 0;
+
+    for (int i = 0; i < node->routeCount; i++) {
+        const app_netdiag_route_t *route = &node->routes[i];
+        payload[len++] = route->routerId;
+        payload[len++] = (uint8_t)((route->linkQualityIn << 4) | route->linkQualityOut);
+        payload[len++] = route->routeCost;
+    }
+    emit_locked(APP_NETDIAG_REC_ROUTES, node->rloc16, payload, len);
+}
+
+static void emit_children_locked(const app_netdiag_node_t *node)
+{
+    uint8_t payload[NETDIAG_PAYLOAD_MAX];
+    uint8_t len = 0;
+
+    for (int i = 0; i < node->childCount; i++) {
+        const app_netdiag_child_t *child = &node->children[i];
+        payload[len++] = (uint8_t)(child->rloc16 >> 8);
+        payload[len++] = (uint8_t)(child->rloc16 & 0xff);
+        payload[len++] = child->linkQuality;
+        payload[len++] = child->mode;
+    }
+    emit_locked(APP_NETDIAG_REC_CHILDREN, node->rloc16, payload, len);
+}
+
+// Écarts en LEB128: un compteur qui bouge peu tient sur un octet
+static void emit_counters_locked(uint16_t rloc16, const uint32_t *current, const uint32_t *previous)
+{
+    uint8_t payload[9 * 5];
+    uint8_t len = 0;
+
+    for (int i = 0; i < 9; i++) {
+        uint32_t delta = current[i] - ((previous != NULL) ? previous[i] : 0);
+        do {
+            uint8_t byte = delta & 0x7f;
+            delta >>= 7;
+            payload[len++] = (delta != 0) ? (byte | 0x80) : byte;
+        } while (delta != 0);
+    }
+    emit_locked(APP_NETDIAG_REC_COUNTERS, rloc16, payload, len);
+}
+
+// Image complète: l'hôte repart de zéro à chaque SYNC
+static void emit_keyframe_locked(void)
+{
+    uint8_t sync[2];
+    uint8_t count = 0;
+
+    for (int i = 0; i < APP_NETDIAG_MAX_ROUTERS; i++) {
+        count += sRouters[i].used ? 1 : 0;
+    }
+    sync[0] = count;
+    sync[1] = APP_NETDIAG_AIRTIME_PERMILLE;
+
+    sResyncPending = false;
+    emit_locked(APP_NETDIAG_REC_SYNC, otThreadGetRloc16(sInstance), sync, sizeof(sync));
+    for (int i = 0; i < APP_NETDIAG_MAX_ROUTERS; i++) {
+        if (sRouters[i].used) {
+            emit_routes_locked(&sRouters[i].node);
+            emit_children_locked(&sRouters[i].node);
+            emit_counters_locked(sRouters[i].node.rloc16, sRouters[i].node.macCounters, NULL);
+        }
+    }
+}
+
+static void maybe_resync_locked(void)
+{
+    if (sSubscribed && sResyncPending && xMessageBufferSpacesAvailable(sStream) >= NETDIAG_STREAM_SIZE / 2) {
+        emit_keyframe_locked();
+    }
+}
+
+static tracked_router_t *find_router(uint8_t routerId, bool allocate)
+{
+    tracked_router_t *freeSlot = NULL;
+
+    for (int i = 0; i < APP_NETDIAG_MAX_ROUTERS; i++) {
+        if (sRouters[i].used && sRouters[i].routerId == routerId) {
+            return &sRouters[i];
+        }
+        if (!sRouters[i].used && freeSlot == NULL) {
+            freeSlot = &sRouters[i];
+        }
+    }
+
+    if (!allocate || freeSlot == NULL) {
+        return NULL;
+    }
+    memset(freeSlot, 0, sizeof(*freeSlot));
+    freeSlot->used = true;
+    freeSlot->routerId = routerId;
+    return freeSlot;
+}
+
+static void parse_response(const otMessage *message, app_netdiag_node_t *node)
+{
+    otNetworkDiagIterator iterator = OT_NETWORK_DIAGNOSTIC_ITERATOR_INIT;
+    otNetworkDiagTlv tlv;
+
+    while (otThreadGetNextDiagnosticTlv(message, &iterator, &tlv) == OT_ERROR_NONE) {
+        if (tlv.mType == OT_NETWORK_DIAGNOSTIC_TLV_SHORT_ADDRESS) {
+            node->rloc16 = tlv.mData.mAddr16;
+        } else if (tlv.mType == OT_NETWORK_DIAGNOSTIC_TLV_ROUTE) {
+            const otNetworkDiagRoute *route = &tlv.mData.mRoute;
+            node->routeCount = 0;
+            for (int i = 0; i < route->mRouteCount && node->routeCount < APP_NETDIAG_MAX_ROUTERS; i++) {
+                app_netdiag_route_t *out = &node->routes[node->routeCount++];
+                out->routerId = route->mRouteData[i].mRouterId;
+                out->linkQualityIn = route->mRouteData[i].mLinkQualityIn;
+                out->linkQualityOut = route->mRouteData[i].mLinkQualityOut;
+                out->routeCost = route->mRouteData[i].mRouteCost;
+            }
+        } else if (tlv.mType == OT_NETWORK_DIAGNOSTIC_TLV_CHILD_TABLE) {
+            node->childCount = 0;
+            for (int i = 0; i < tlv.mData.mChildTable.mCount && node->childCount < APP_NETDIAG_MAX_CHILDREN; i++) {
+                const otNetworkDiagChildEntry *entry = &tlv.mData.mChildTable.mTable[i];
+                app_netdiag_child_t *out = &node->children[node->childCount++];
+                out->rloc16 = (uint16_t)((node->rloc16 & 0xfc00) | entry->mChildId);
+                out->linkQuality = entry->mLinkQuality;
+                out->mode = (uint8_t)((entry->mMode.mRxOnWhenIdle ? 0x01 : 0) | (entry->mMode.mDeviceType ? 0x02 : 0) |
+                                      (entry->mMode.mNetworkData ? 0x04 : 0));
+            }
+        } else if (tlv.mType == OT_NETWORK_DIAGNOSTIC_TLV_MAC_COUNTERS) {
+            const otNetworkDiagMacCounters *counters = &tlv.mData.mMacCounters;
+            const uint32_t values[9] = {
+                counters->mIfInUnknownProtos, counters->mIfInErrors,       counters->mIfOutErrors,
+                counters->mIfInUcastPkts,     counters->mIfInBroadcastPkts, counters->mIfInDiscards,
+                counters->mIfOutUcastPkts,    counters->mIfOutBroadcastPkts, counters->mIfOutDiscards,
+            };
+            memcpy(node->macCounters, values, sizeof(values));
+        }
+    }
+}
+
+// Compare la réponse à l'image connue de l'hôte et n'émet que les sections modifiées
+static void apply_response_locked(uint8_t routerId, const app_netdiag_node_t *fresh)
+{
+    tracked_router_t *tracked = find_router(routerId, false);
+    bool isNew = (tracked == NULL);
+
+    if (isNew) {
+        tracked = find_router(routerId, true);
+        if (tracked == NULL) {
+            ESP_LOGW(TAG, "Router table full, router %u ignored", routerId);
+            return;
+        }
+    }
+
+    app_netdiag_node_t *known = &tracked->node;
+    if (isNew || fresh->routeCount != known->routeCount ||
+        memcmp(fresh->routes, known->routes, fresh->routeCount * sizeof(fresh->routes[0])) != 0) {
+        emit_routes_locked(fresh);
+    }
+    if (isNew || fresh->childCount != known->childCount ||
+        memcmp(fresh->children, known->children, fresh->childCount * sizeof(fresh->children[0])) != 0) {
+        emit_children_locked(fresh);
+    }
+    if (isNew || memcmp(fresh->macCounters, known->macCounters, sizeof(known->macCounters)) != 0) {
+        emit_counters_locked(fresh->rloc16, fresh->macCounters, isNew ? NULL : known->macCounters);
+    }
+
+    *known = *fresh;
+    tracked->updatedUs = esp_timer_get_time();
+}
+
+// Temps d'antenne de la requête et de sa réponse, sur chaque saut; fixe la prochaine requête
+static void charge_airtime(uint16_t responseLen)
+{
+    uint32_t frames = 1;
+
+    if (responseLen > 0) {
+        frames += app_pack_frame_count(responseLen + NETDIAG_COAP_OVERHEAD, sQueryBudget);
+    }
+
+    uint64_t airtimeUs = (uint64_t)frames * NETDIAG_FRAME_AIRTIME_US * sQueryHops;
+    sAirtimeUs += airtimeUs;
+    sNextQueryUs = esp_timer_get_time() + (int64_t)(airtimeUs * 1000 / APP_NETDIAG_AIRTIME_PERMILLE);
+}
+
+static void diag_response_done_locked(otError aError, otMessage *aMessage, const otMessageInfo *aMessageInfo,
+                                      void *aContext)
+{
+    (void)aMessageInfo;
+    uint8_t routerId = (uint8_t)(uintptr_t)aContext;
+
+    // Réponse tardive à une requête déjà abandonnée
+    if (!sAwaiting || routerId != sAwaitingId) {
+        return;
+    }
+    sAwaiting = false;
+
+    if (aError != OT_ERROR_NONE || aMessage == NULL) {
+        sStats.failures++;
+        charge_airtime(0);
+        ESP_LOGD(TAG, "No diagnostics from router %u: %d", routerId, aError);
+        return;
+    }
+
+    app_netdiag_node_t fresh;
+    memset(&fresh, 0, sizeof(fresh));
+    fresh.rloc16 = (uint16_t)(routerId << 10);
+    parse_response(aMessage, &fresh);
+
+    sStats.responses++;
+    charge_airtime(otMessageGetLength(aMessage) - otMessageGetOffset(aMessage));
+    apply_response_locked(routerId, &fresh);
+    maybe_resync_locked();
+}
+
+static void handle_diag_response(otError aError, otMessage *aMessage, const otMessageInfo *aMessageInfo,
+                                 void *aContext)
+{
+    uint32_t start = app_cbwatch_begin();
+    diag_response_done_locked(aError, aMessage, aMessageInfo, aContext);
+    app_cbwatch_end_locked(APP_CBWATCH_NETDIAG, start);
+}
+
+static void query_router_locked(uint8_t routerId, const otRouterInfo *info)
+{
+    static const uint8_t tlvTypes[] = {
+        OT_NETWORK_DIAGNOSTIC_TLV_SHORT_ADDRESS,
+        OT_NETWORK_DIAGNOSTIC_TLV_ROUTE,
+        OT_NETWORK_DIAGNOSTIC_TLV_CHILD_TABLE,
+        OT_NETWORK_DIAGNOSTIC_TLV_MAC_COUNTERS,
+    };
+    uint16_t ownRloc16 = otThreadGetRloc16(sInstance);
+
+    // RLOC du routeur: préfixe mesh-local et IID 0:ff:fe00:rloc16, comme celui du leader
+    otIp6Address dst = *otThreadGetRloc(sInstance);
+    dst.mFields.m8[14] = (uint8_t)(info->mRloc16 >> 8);
+    dst.mFields.m8[15] = (uint8_t)(info->mRloc16 & 0xff);
+
+    // Coût de chemin ~ nombre de sauts; la requête au leader lui-même ne passe pas sur l'air
+    sQueryHops = (info->mRloc16 == ownRloc16) ? 0 : ((info->mPathCost > 0) ? info->mPathCost : 1);
+    sQueryBudget = app_pack_budget_locked(sInstance, &dst, NETDIAG_TMF_PORT, NETDIAG_TMF_PORT, sQueryHops > 1);
+
+    otError error = otThreadSendDiagnosticGet(sInstance, &dst, tlvTypes, sizeof(tlvTypes), handle_diag_response,
+                                              (void *)(uintptr_t)routerId);
+    if (error != OT_ERROR_NONE) {
+        sStats.failures++;
+        sNextQueryUs = esp_timer_get_time() + NETDIAG_RETRY_MS * 1000LL;
+        return;
+    }
+
+    sStats.queries++;
+    sAwaiting = true;
+    sAwaitingId = routerId;
+    sDeadlineUs = esp_timer_get_time() + NETDIAG_RESPONSE_TIMEOUT_MS * 1000LL;
+}
+
+// Fin de tour: les routeurs sortis de la table du leader sont retirés
+static void finish_sweep_locked(int64_t nowUs)
+{
+    otRouterInfo info;
+
+    for (int i = 0; i < APP_NETDIAG_MAX_ROUTERS; i++) {
+        tracked_router_t *tracked = &sRouters[i];
+        if (tracked->used &&
+            (otThreadGetRouterInfo(sInstance, tracked->routerId, &info) != OT_ERROR_NONE || !info.mAllocated)) {
+            emit_locked(APP_NETDIAG_REC_GONE, tracked->node.rloc16, NULL, 0);
+            tracked->used = false;
+        }
+    }
+
+    sStats.lastSweepMs = (uint32_t)((nowUs - sSweepStartUs) / 1000);
+    if (sNextQueryUs < sSweepStartUs + APP_NETDIAG_SWEEP_MIN_S * 1000000LL) {
+        sNextQueryUs = sSweepStartUs + APP_NETDIAG_SWEEP_MIN_S * 1000000LL;
+    }
+    sCursor = 0;
+}
+
+static void netdiag_tick_locked(void)
+{
+    int64_t nowUs = esp_timer_get_time();
+    otRouterInfo info;
+
+    if (otThreadGetDeviceRole(sInstance) != OT_DEVICE_ROLE_LEADER) {
+        return;
+    }
+
+    maybe_resync_locked();
+
+    if (sAwaiting) {
+        if (nowUs >= sDeadlineUs) {
+            sAwaiting = false;
+            sStats.failures++;
+        }
+        return;
+    }
+    if (nowUs < sNextQueryUs) {
+        return;
+    }
+    // Les réponses de topologie occupent l'air: requête reportée au passage suivant
+    // pendant une fenêtre de commande
+    if (!app_coex_bulk_allowed()) {
+        return;
+    }
+
+    uint8_t maxRouterId = otThreadGetMaxRouterId(sInstance);
+    for (uint16_t id = sCursor; id <= maxRouterId; id++) {
+        if (otThreadGetRouterInfo(sInstance, id, &info) == OT_ERROR_NONE && info.mAllocated) {
+            if (sCursor == 0) {
+                sSweepStartUs = nowUs;
+            }
+            sCursor = (uint8_t)(id + 1);
+            query_router_locked((uint8_t)id, &info);
+            return;
+        }
+    }
+
+    finish_sweep_locked(nowUs);
+}
+
+static void netdiag_tick_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    netdiag_tick_locked();
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_NETDIAG, start);
+    esp_openthread_lock_release();
+}
+
+void app_netdiag_init_locked(otInstance *instance)
+{
+    if (sTickTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+    sStartUs = esp_timer_get_time();
+
+    sStream = xMessageBufferCreate(NETDIAG_STREAM_SIZE);
+    if (sStream == NULL ||
+        xTaskCreate(netdiag_writer_task, "netdiag_tx", 2048, NULL, 2, &sWriterTask) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create topology stream");
+        return;
+    }
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = netdiag_tick_cb,
+        .name = "netdiag",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sTickTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sTickTimer, NETDIAG_TICK_MS * 1000));
+}
+
+bool app_netdiag_is_request(const uint8_t *data, uint16_t len)
+{
+    return (len == 2) && (data[0] == APP_NETDIAG_OPCODE) && (data[1] <= 1);
+}
+
+void app_netdiag_handle_request_locked(app_ingress_channel_t channel, const uint8_t *data)
+{
+    if (sStream == NULL) {
+        return;
+    }
+
+    if (data[1] == 0) {
+        sSubscribed = false;
+        ESP_LOGI(TAG, "Topology stream stopped");
+        return;
+    }
+
+    // Nouvel abonnement, ou reprise demandée par l'hôte après une perte: image complète
+    sChannel = channel;
+    sSubscribed = true;
+    ESP_LOGI(TAG, "Topology stream on %s", app_ingress_channel_name(channel));
+    emit_keyframe_locked();
+}
+
+bool app_netdiag_get_by_index_locked(uint16_t index, app_netdiag_node_t *outNode)
+{
+    int64_t nowUs = esp_timer_get_time();
+
+    for (int i = 0; i < APP_NETDIAG_MAX_ROUTERS; i++) {
+        if (!sRouters[i].used) {
+            continue;
+        }
+        if (index-- == 0) {
+            *outNode = sRouters[i].node;
+            outNode->ageS = (uint32_t)((nowUs - sRouters[i].updatedUs) / 1000000);
+            return true;
+        }
+    }
+    return false;
+}
+
+void app_netdiag_get_stats_locked(app_netdiag_stats_t *outStats)
+{
+    int64_t elapsedUs = esp_timer_get_time() - sStartUs;
+
+    *outStats = sStats;
+    outStats->subscribed = sSubscribed;
+    outStats->routers = 0;
+    for (int i = 0; i < APP_NETDIAG_MAX_ROUTERS; i++) {
+        outStats->routers += sRouters[i].used ? 1 : 0;
+    }
+    outStats->airtimeMs = (uint32_t)(sAirtimeUs / 1000);
+    outStats->airtimePermille = (elapsedUs > 0) ? (uint16_t)(sAirtimeUs * 1000 / (uint64_t)elapsedUs) : 0;
+}
@@ -0,0 +1,139 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Relevé de la topologie par diagnostics réseau et flux de deltas vers l'hôte
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_ingress.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Octet de commande hôte: abonnement au flux de topologie, et en-tête de chaque enregistrement */
+#define APP_NETDIAG_OPCODE 0xC1
+
+/** Routeurs suivis (un Thread en compte au plus 32 actifs) */
+#define APP_NETDIAG_MAX_ROUTERS 32
+
+/** Enfants gardés par routeur */
+#define APP_NETDIAG_MAX_CHILDREN 24
+
+/** Part du temps d'antenne accordée aux diagnostics, en pour mille */
+#define APP_NETDIAG_AIRTIME_PERMILLE 10
+
+/** Durée minimale d'un tour complet des routeurs */
+#define APP_NETDIAG_SWEEP_MIN_S 30
+
+/**
+ * Enregistrements du flux (entiers gros-boutistes):
+ * opcode, numéro de séquence, type, rloc16 (2), longueur, données.
+ *
+ * - SYNC: début d'une image complète, l'hôte repart de zéro (nombre de routeurs, part d'antenne en ‰)
+ * - ROUTES: par routeur connu: router ID, qualité de lien (entrée << 4 | sortie), coût de route
+ * - CHILDREN: par enfant: rloc16 (2), qualité de lien, mode (rx-on, FTD, données réseau complètes)
+ * - COUNTERS: 9 compteurs MAC en LEB128, écart depuis l'enregistrement précédent
+ * - GONE: routeur disparu de la table du leader
+ *
+ * Hors SYNC, un enregistrement n'est émis que si la section a changé.
+ */
+typedef enum {
+    APP_NETDIAG_REC_SYNC = 0,
+    APP_NETDIAG_REC_ROUTES,
+    APP_NETDIAG_REC_CHILDREN,
+    APP_NETDIAG_REC_COUNTERS,
+    APP_NETDIAG_REC_GONE,
+} app_netdiag_record_t;
+
+/** Longueur de l'en-tête d'un enregistrement */
+#define APP_NETDIAG_RECORD_HEADER_LEN 6
+
+/** Lien vers un routeur, vu par un routeur (qualités 0..3, 0 = pas voisin) */
+typedef struct {
+    uint8_t routerId;
+    uint8_t linkQualityIn;
+    uint8_t linkQualityOut;
+    uint8_t routeCost;
+} app_netdiag_route_t;
+
+/** Enfant d'un routeur */
+typedef struct {
+    uint16_t rloc16;
+    uint8_t linkQuality;
+    uint8_t mode;  // Bit 0: rx-on-when-idle, bit 1: FTD, bit 2: données réseau complètes
+} app_netdiag_child_t;
+
+/** Dernière réponse d'un routeur */
+typedef struct {
+    uint16_t rloc16;
+    uint8_t routeCount;
+    uint8_t childCount;
+    app_netdiag_route_t routes[APP_NETDIAG_MAX_ROUTERS];
+    app_netdiag_child_t children[APP_NETDIAG_MAX_CHILDREN];
+    uint32_t macCounters[9];  // Ordre de otNetworkDiagMacCounters
+    uint32_t ageS;
+} app_netdiag_node_t;
+
+/** Mesures du relevé */
+typedef struct {
+    bool subscribed;
+    uint16_t routers;
+    uint32_t queries;
+    uint32_t responses;
+    uint32_t failures;
+    uint32_t records;
+    uint32_t streamBytes;
+    uint32_t streamDrops;     // Enregistrements perdus (flux plein): une image complète suit
+    uint32_t airtimeMs;       // Estimation, requêtes et réponses sur tous les sauts
+    uint16_t airtimePermille; // Part mesurée depuis le démarrage
+    uint32_t lastSweepMs;
+} app_netdiag_stats_t;
+
+/**
+ * @brief Démarre le relevé périodique (actif seulement quand le nœud est leader)
+ *
+ * Chaque routeur reçoit à tour de rôle une requête Diagnostic Get (adresse,
+ * routes, table des enfants, compteurs MAC). La requête suivante attend que
+ * le temps d'antenne estimé de la précédente ne dépasse pas
+ * APP_NETDIAG_AIRTIME_PERMILLE du temps écoulé.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+void app_netdiag_init_locked(otInstance *instance);
+
+/**
+ * @brief Indique si une trame de l'hôte est une demande d'abonnement (0xC1 0x01, ou 0xC1 0x00 pour arrêter)
+ */
+bool app_netdiag_is_request(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Traite une demande d'abonnement: image complète puis deltas sur ce lien
+ *
+ * @param channel Lien hôte qui reçoit le flux
+ * @param data Trame de la demande
+ */
+void app_netdiag_handle_request_locked(app_ingress_channel_t channel, const uint8_t *data);
+
+/**
+ * @brief Lit le routeur rangé à un indice du relevé (verrou OpenThread tenu)
+ *
+ * @return false au-delà du dernier routeur
+ */
+bool app_netdiag_get_by_index_locked(uint16_t index, app_netdiag_node_t *outNode);
+
+/**
+ * @brief Copie les mesures du relevé (verrou OpenThread tenu)
+ */
+void app_netdiag_get_stats_locked(app_netdiag_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
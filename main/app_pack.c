@@ -0,0 +1,114 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Découpage des commandes en datagrammes d'une seule trame 802.15.4
+ */
+
+#include "app_pack.h"
+
+#include "app_addr.h"
+
+/*
+ * Trame 802.15.4 de données Thread: PSDU de 127 octets au plus.
+ * MAC: contrôle (2), séquence (1), PAN ID (2), adresses courtes (2 + 2), FCS (2);
+ * sécurité: en-tête auxiliaire mode 1 (6) et MIC-32 (4).
+ */
+#define MAC_FRAME_MAX        127
+#define MAC_HEADER_LEN       9
+#define MAC_FCS_LEN          2
+#define MAC_SECURITY_LEN     (6 + 4)
+#define MESH_HEADER_LEN      5
+#define IPHC_BASE_LEN        2
+#define UDP_NHC_LEN          1
+#define UDP_CHECKSUM_LEN     2
+#define FRAG1_HEADER_LEN     4
+#define FRAGN_HEADER_LEN     5
+
+static app_pack_stats_t sStats;
+
+// Ports UDP compressés: 0xF0Bx sur 4 bits, 0xF0xx sur 8 bits, sinon en ligne
+static uint8_t udp_ports_len(uint16_t srcPort, uint16_t dstPort)
+{
+    if ((srcPort & 0xfff0) == 0xf0b0 && (dstPort & 0xfff0) == 0xf0b0) {
+        return 1;
+    }
+    if ((srcPort & 0xff00) == 0xf000 || (dstPort & 0xff00) == 0xf000) {
+        return 3;
+    }
+
+    return 4;
+}
+
+uint16_t app_pack_budget_locked(otInstance *instance, const otIp6Address *dst, uint16_t srcPort, uint16_t dstPort,
+                                bool multiHop)
+{
+    uint16_t overhead = MAC_HEADER_LEN + MAC_FCS_LEN + MAC_SECURITY_LEN;
+
+    overhead += multiHop ? MESH_HEADER_LEN : 0;
+
+    // La source choisie par la pile suit la forme de la destination (RLOC vers RLOC, sinon ML-EID)
+    overhead += IPHC_BASE_LEN + 2 * app_addr_inline_len_locked(instance, dst);
+    overhead += UDP_NHC_LEN + udp_ports_len(srcPort, dstPort) + UDP_CHECKSUM_LEN;
+
+    return MAC_FRAME_MAX - overhead;
+}
+
+uint16_t app_pack_frame_len(const uint8_t *data, uint16_t len)
+{
+    (void)data;
+
+    return (len > 0) ? 1 : 0;
+}
+
+uint16_t app_pack_next(const uint8_t *data, uint16_t len, uint16_t budget)
+{
+    uint16_t packed = app_pack_frame_len(data, len);
+
+    while (packed < len) {
+        uint16_t frameLen = app_pack_frame_len(&data[packed], len - packed);
+        if (packed + frameLen > budget) {
+            break;
+        }
+        packed += frameLen;
+    }
+
+    return packed;
+}
+
+uint16_t app_pack_frame_count(uint16_t len, uint16_t budget)
+{
+    if (len <= budget) {
+        return 1;
+    }
+
+    // Le premier fragment porte aussi les en-têtes IPHC et UDP, déjà hors budget
+    uint16_t firstLen = (budget - FRAG1_HEADER_LEN) & ~0x7;
+    uint16_t nextLen = (budget - FRAGN_HEADER_LEN) & ~0x7;
+    uint16_t remaining = len - firstLen;
+
+    return 1 + (remaining + nextLen - 1) / nextLen;
+}
+
+void app_pack_note_sent(const uint8_t *data, uint16_t len, uint16_t budget)
+{
+    uint16_t offset = 0;
+
+    while (offset < len) {
+        offset += app_pack_frame_len(&data[offset], len - offset);
+        sStats.frames++;
+    }
+
+    sStats.datagrams++;
+    sStats.bytes += len;
+    sStats.lastBudget = budget;
+    if (len > budget) {
+        sStats.oversize++;
+    }
+}
+
+void app_pack_get_stats(app_pack_stats_t *outStats)
+{
+    *outStats = sStats;
+}
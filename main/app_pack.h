@@ -0,0 +1,93 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Découpage des commandes en datagrammes d'une seule trame 802.15.4
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Compteurs du découpage */
+typedef struct {
+    uint32_t datagrams;
+    uint32_t frames;     // Commandes applicatives envoyées
+    uint32_t bytes;
+    uint32_t oversize;   // Commande seule plus grande que le budget: fragmentée par 6LoWPAN
+    uint16_t lastBudget; // Budget du dernier envoi, en octets utiles
+} app_pack_stats_t;
+
+/**
+ * @brief Calcule la charge utile UDP qui tient dans une seule trame 802.15.4
+ *
+ * Compte l'en-tête MAC (adresses courtes, sécurité mode 1, MIC-32), l'en-tête
+ * mesh si la destination n'est pas un voisin, l'en-tête IPHC selon la
+ * compressibilité des adresses (contexte mesh-local 0) et l'en-tête UDP
+ * compressé selon les ports.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param dst Adresse de destination
+ * @param srcPort Port source
+ * @param dstPort Port destination
+ * @param multiHop true si la destination est à plus d'un saut
+ * @return Octets utiles disponibles
+ */
+uint16_t app_pack_budget_locked(otInstance *instance, const otIp6Address *dst, uint16_t srcPort, uint16_t dstPort,
+                                bool multiHop);
+
+/**
+ * @brief Longueur de la commande applicative en tête de data
+ *
+ * Toutes les commandes actuelles tiennent sur un octet.
+ *
+ * @return Longueur de la commande, bornée par len
+ */
+uint16_t app_pack_frame_len(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Longueur du prochain datagramme: commandes entières tenant dans le budget
+ *
+ * Au moins une commande est prise, même si elle dépasse le budget.
+ *
+ * @param data Commandes restant à envoyer
+ * @param len Longueur restante
+ * @param budget Charge utile d'une trame (app_pack_budget_locked)
+ * @return Octets à placer dans le datagramme
+ */
+uint16_t app_pack_next(const uint8_t *data, uint16_t len, uint16_t budget);
+
+/**
+ * @brief Estime le nombre de trames 802.15.4 d'un datagramme
+ *
+ * Au-delà du budget, 6LoWPAN fragmente: en-tête FRAG1 (4 octets) puis FRAGN
+ * (5 octets), charge de chaque fragment arrondie à un multiple de 8.
+ *
+ * @param len Charge utile UDP
+ * @param budget Charge utile d'une trame (app_pack_budget_locked)
+ * @return Trames émises pour un datagramme
+ */
+uint16_t app_pack_frame_count(uint16_t len, uint16_t budget);
+
+/**
+ * @brief Comptabilise un datagramme envoyé
+ */
+void app_pack_note_sent(const uint8_t *data, uint16_t len, uint16_t budget);
+
+/**
+ * @brief Copie les compteurs du découpage
+ */
+void app_pack_get_stats(app_pack_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
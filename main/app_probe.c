@@ -0,0 +1,553 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Sonde de latence applicative (découverte des nœuds et mesure d'aller-retour)
+ */
+
+#include "app_probe.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "app_addr.h"
+#include "app_cbwatch.h"
+#include "app_coex.h"
+#include "app_pack.h"
+
+#include "openthread/ip6.h"
+#include "openthread/thread.h"
+#include "openthread/udp.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#define TAG "app_probe"
+
+#define PROBE_MSG_DISCOVER   0x01
+#define PROBE_MSG_ECHO       0x02
+#define PROBE_MSG_BURST      0x03
+#define PROBE_MSG_REPLY_FLAG 0x80
+
+#define PROBE_REQUEST_LEN 3
+#define PROBE_REPLY_LEN   7
+
+#define PROBE_DISCOVER_WINDOW_MS 2000
+#define PROBE_ECHO_TIMEOUT_MS    1000
+#define PROBE_ROUND_GAP_MS       50
+#define PROBE_BULK_RETRY_MS      10
+#define PROBE_BURST_DRAIN_MS     3000
+#define PROBE_REPLY_QUEUE_LEN    APP_PROBE_MAX_TARGETS
+
+// Trame 802.15.4 maximale et temps d'antenne à 250 kbit/s (32 us/octet, SHR+PHR compris)
+#define RADIO_MAX_PSDU       127
+#define RADIO_AIR_US_PER_BYTE 32
+#define RADIO_PHY_HEADER_LEN 6
+
+// Encapsulation spinel d'une trame sur l'UART du RCP: en-têtes, métadonnées, FCS et délimiteurs HDLC
+#define RCP_SPINEL_OVERHEAD_LEN 20
+#define RCP_UART_BITS_PER_BYTE  10
+
+/**
+ * Réponse reçue par le nœud qui exécute le benchmark.
+ * Format sur le réseau: type, seq (2), rloc16 (2), rloc16 du parent (2).
+ */
+typedef struct {
+    uint8_t type;
+    uint16_t seq;
+    uint16_t rloc16;
+    uint16_t parentRloc16;
+    int64_t rxTimeUs;
+} probe_reply_t;
+
+typedef struct {
+    uint16_t rloc16;
+    uint16_t parentRloc16;
+    uint16_t sent;
+    uint16_t received;
+    int64_t minUs;
+    int64_t maxUs;
+    int64_t totalUs;
+} probe_target_t;
+
+static otUdpSocket sProbeSocket;
+static bool sProbeSocketOpen = false;
+static QueueHandle_t sReplyQueue = NULL;
+static volatile bool sBenchRunning = false;
+static uint16_t sBenchRounds = APP_PROBE_DEFAULT_ROUNDS;
+static uint16_t sBenchPayloadLen = 0;
+static uint16_t sBurstCount = 0;
+static uint8_t sRequest[APP_PROBE_MAX_PAYLOAD];
+
+static uint16_t get_parent_rloc16_locked(otInstance *instance)
+{
+    otDeviceRole role = otThreadGetDeviceRole(instance);
+
+    if (role == OT_DEVICE_ROLE_CHILD) {
+        otRouterInfo parentInfo;
+        if (otThreadGetParentInfo(instance, &parentInfo) == OT_ERROR_NONE) {
+            return parentInfo.mRloc16;
+        }
+    }
+
+    // Un routeur ou le leader est son propre « parent »
+    return otThreadGetRloc16(instance);
+}
+
+static bool probe_send_locked(otInstance *instance, const otIp6Address *peerAddr, uint16_t peerPort,
+                              const uint8_t *data, uint16_t len)
+{
+    otMessage *message = otUdpNewMessage(instance, NULL);
+    if (message == NULL) {
+        ESP_LOGE(TAG, "Failed to create probe message");
+        return false;
+    }
+
+    otError error = otMessageAppend(message, data, len);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to append probe data: %d", error);
+        otMessageFree(message);
+        return false;
+    }
+
+    otMessageInfo messageInfo;
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = *peerAddr;
+    messageInfo.mPeerPort = peerPort;
+
+    error = otUdpSend(instance, &sProbeSocket, message, &messageInfo);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to send probe message: %d", error);
+        otMessageFree(message);
+        return false;
+    }
+
+    return true;
+}
+
+// Fonction de rappel de la sonde: répond aux requêtes, transmet les réponses au benchmark
+static void handle_probe_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    otInstance *instance = (otInstance *)aContext;
+    uint8_t data[PROBE_REPLY_LEN];
+    uint16_t length = otMessageGetLength(aMessage);
+
+    if (length < PROBE_REQUEST_LEN) {
+        return;
+    }
+
+    // Seul l'en-tête des requêtes est lu: le remplissage éventuel ne sert qu'à charger le lien
+    otMessageRead(aMessage, 0, data, (length < sizeof(data)) ? length : sizeof(data));
+
+    if ((data[0] & PROBE_MSG_REPLY_FLAG) == 0) {
+        uint16_t rloc16 = otThreadGetRloc16(instance);
+        uint16_t parentRloc16 = get_parent_rloc16_locked(instance);
+        uint8_t reply[PROBE_REPLY_LEN] = {
+            data[0] | PROBE_MSG_REPLY_FLAG,
+            data[1],
+            data[2],
+            (uint8_t)(rloc16 >> 8),
+            (uint8_t)(rloc16 & 0xff),
+            (uint8_t)(parentRloc16 >> 8),
+            (uint8_t)(parentRloc16 & 0xff),
+        };
+
+        probe_send_locked(instance, &aMessageInfo->mPeerAddr, aMessageInfo->mPeerPort, reply, sizeof(reply));
+        return;
+    }
+
+    if (!sBenchRunning || length != PROBE_REPLY_LEN || sReplyQueue == NULL) {
+        return;
+    }
+
+    probe_reply_t reply = {
+        .type = data[0] & ~PROBE_MSG_REPLY_FLAG,
+        .seq = (uint16_t)((data[1] << 8) | data[2]),
+        .rloc16 = (uint16_t)((data[3] << 8) | data[4]),
+        .parentRloc16 = (uint16_t)((data[5] << 8) | data[6]),
+        .rxTimeUs = esp_timer_get_time(),
+    };
+
+    // Appelé sur la tâche OpenThread: ne jamais bloquer
+    xQueueSend(sReplyQueue, &reply, 0);
+}
+
+bool app_probe_init_locked(otInstance *instance)
+{
+    if (sProbeSocketOpen) {
+        return true;
+    }
+
+    otError error =
+        app_cbwatch_udp_open_locked(instance, &sProbeSocket, handle_probe_receive, instance, APP_CBWATCH_UDP_PROBE);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to open probe UDP socket: %d", error);
+        return false;
+    }
+
+    otSockAddr sockaddr;
+    memset(&sockaddr, 0, sizeof(sockaddr));
+    sockaddr.mPort = APP_PROBE_PORT;
+
+    error = otUdpBind(instance, &sProbeSocket, &sockaddr, OT_NETIF_THREAD_INTERNAL);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to bind probe UDP socket: %d", error);
+        otUdpClose(instance, &sProbeSocket);
+        return false;
+    }
+
+    sProbeSocketOpen = true;
+    ESP_LOGI(TAG, "Probe UDP socket initialized on port %d", APP_PROBE_PORT);
+    return true;
+}
+
+static probe_target_t *find_or_add_target(probe_target_t *targets, uint16_t *count, const probe_reply_t *reply)
+{
+    for (uint16_t i = 0; i < *count; i++) {
+        if (targets[i].rloc16 == reply->rloc16) {
+            return &targets[i];
+        }
+    }
+
+    if (*count >= APP_PROBE_MAX_TARGETS) {
+        return NULL;
+    }
+
+    probe_target_t *target = &targets[(*count)++];
+    memset(target, 0, sizeof(*target));
+    target->rloc16 = reply->rloc16;
+    target->parentRloc16 = reply->parentRloc16;
+    return target;
+}
+
+static void build_request(uint8_t type, uint16_t seq, uint8_t *request)
+{
+    request[0] = type;
+    request[1] = (uint8_t)(seq >> 8);
+    request[2] = (uint8_t)(seq & 0xff);
+}
+
+static uint16_t discover_targets(otInstance *instance, probe_target_t *targets)
+{
+    uint16_t count = 0;
+    uint8_t request[PROBE_REQUEST_LEN];
+    otIp6Address realmLocalAllNodes;
+    probe_reply_t reply;
+
+    otIp6AddressFromString("ff03::1", &realmLocalAllNodes);
+    build_request(PROBE_MSG_DISCOVER, 0, request);
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    probe_send_locked(instance, &realmLocalAllNodes, APP_PROBE_PORT, request, sizeof(request));
+    esp_openthread_lock_release();
+
+    int64_t deadlineUs = esp_timer_get_time() + PROBE_DISCOVER_WINDOW_MS * 1000LL;
+    int64_t nowUs;
+    while ((nowUs = esp_timer_get_time()) < deadlineUs) {
+        TickType_t wait = pdMS_TO_TICKS((deadlineUs - nowUs) / 1000) + 1;
+        if (xQueueReceive(sReplyQueue, &reply, wait) == pdTRUE && reply.type == PROBE_MSG_DISCOVER) {
+            find_or_add_target(targets, &count, &reply);
+        }
+    }
+
+    return count;
+}
+
+static void measure_target(otInstance *instance, probe_target_t *target, uint16_t rounds, uint16_t payloadLen,
+                           uint16_t *seq)
+{
+    uint8_t *request = sRequest;
+    uint16_t requestLen = (payloadLen > PROBE_REQUEST_LEN) ? payloadLen : PROBE_REQUEST_LEN;
+    otIp6Address peerAddr;
+    probe_reply_t reply;
+
+    target->minUs = INT64_MAX;
+
+    for (uint16_t round = 0; round < rounds; round++) {
+        uint16_t expectedSeq = ++(*seq);
+        build_request(PROBE_MSG_ECHO, expectedSeq, request);
+
+        // Requêtes remplies: trafic de masse, différé tant que la coexistence le demande.
+        // Requêtes minimales: mesurées comme des commandes, en priorité haute
+        if (requestLen > PROBE_REQUEST_LEN) {
+            while (!app_coex_bulk_allowed()) {
+                vTaskDelay(pdMS_TO_TICKS(PROBE_BULK_RETRY_MS));
+            }
+        } else {
+            app_coex_control_begin();
+        }
+
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        app_addr_build_rloc_locked(instance, target->rloc16, &peerAddr);
+        int64_t txTimeUs = esp_timer_get_time();
+        bool sent = probe_send_locked(instance, &peerAddr, APP_PROBE_PORT, request, requestLen);
+        esp_openthread_lock_release();
+
+        if (!sent) {
+            vTaskDelay(pdMS_TO_TICKS(PROBE_ROUND_GAP_MS));
+            continue;
+        }
+        target->sent++;
+
+        // Les réponses tardives d'un tour précédent sont ignorées via le numéro de séquence
+        int64_t deadlineUs = txTimeUs + PROBE_ECHO_TIMEOUT_MS * 1000LL;
+        int64_t nowUs;
+        while ((nowUs = esp_timer_get_time()) < deadlineUs) {
+            TickType_t wait = pdMS_TO_TICKS((deadlineUs - nowUs) / 1000) + 1;
+            if (xQueueReceive(sReplyQueue, &reply, wait) != pdTRUE) {
+                break;
+            }
+            if (reply.type == PROBE_MSG_ECHO && reply.seq == expectedSeq && reply.rloc16 == target->rloc16) {
+                int64_t rttUs = reply.rxTimeUs - txTimeUs;
+                target->received++;
+                target->totalUs += rttUs;
+                target->minUs = (rttUs < target->minUs) ? rttUs : target->minUs;
+                target->maxUs = (rttUs > target->maxUs) ? rttUs : target->maxUs;
+                break;
+            }
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(PROBE_ROUND_GAP_MS));
+    }
+}
+
+/**
+ * @brief Tâche de benchmark de latence
+ *
+ * Découvre les nœuds, mesure l'aller-retour vers chacun puis affiche un
+ * tableau par nœud et un résumé séparant les enfants directs du leader
+ * des nœuds joints via un autre routeur.
+ *
+ * @param pvParameters Instance OpenThread
+ */
+static void log_radio_link(void)
+{
+    uint32_t airUs = (RADIO_MAX_PSDU + RADIO_PHY_HEADER_LEN) * RADIO_AIR_US_PER_BYTE;
+
+#if CONFIG_APP_RADIO_UART_RCP
+    uint32_t uartUs = (uint32_t)(((uint64_t)(RADIO_MAX_PSDU + RCP_SPINEL_OVERHEAD_LEN) * RCP_UART_BITS_PER_BYTE *
+                                  1000000) / CONFIG_APP_RCP_UART_BAUD);
+    ESP_LOGI(TAG, "Radio link: RCP over UART%d at %d baud, max frame %lu us on UART vs %lu us on air (%s-bound)",
+             CONFIG_APP_RCP_UART_PORT, CONFIG_APP_RCP_UART_BAUD, (unsigned long)uartUs, (unsigned long)airUs,
+             (uartUs > airUs) ? "UART" : "air");
+#else
+    ESP_LOGI(TAG, "Radio link: native, max frame %lu us on air", (unsigned long)airUs);
+#endif
+}
+
+static void probe_bench_task(void *pvParameters)
+{
+    otInstance *instance = (otInstance *)pvParameters;
+    static probe_target_t targets[APP_PROBE_MAX_TARGETS];
+    uint16_t rounds = sBenchRounds;
+    uint16_t payloadLen = sBenchPayloadLen;
+    uint16_t seq = 0;
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    uint16_t ownRloc16 = otThreadGetRloc16(instance);
+    esp_openthread_lock_release();
+
+    uint16_t count = discover_targets(instance, targets);
+    ESP_LOGI(TAG, "Latency bench: %u node(s) discovered, %u round(s) each, %u-byte requests", count, rounds,
+             (payloadLen > PROBE_REQUEST_LEN) ? payloadLen : PROBE_REQUEST_LEN);
+
+    int64_t directTotalUs = 0, relayedTotalUs = 0;
+    uint32_t directReceived = 0, relayedReceived = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        probe_target_t *target = &targets[i];
+        measure_target(instance, target, rounds, payloadLen, &seq);
+
+        bool direct = (target->parentRloc16 == ownRloc16);
+        uint16_t requestLen = (payloadLen > PROBE_REQUEST_LEN) ? payloadLen : PROBE_REQUEST_LEN;
+        otIp6Address peerAddr;
+
+        // Trames radio par requête: au-delà d'une, chaque fragment perdu fait perdre la requête
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        app_addr_build_rloc_locked(instance, target->rloc16, &peerAddr);
+        uint16_t budget = app_pack_budget_locked(instance, &peerAddr, APP_PROBE_PORT, APP_PROBE_PORT, !direct);
+        esp_openthread_lock_release();
+        ESP_LOGI(TAG, "node 0x%04x: %u-byte requests, %u-byte frame budget, %u frame(s) per request",
+                 target->rloc16, requestLen, budget, app_pack_frame_count(requestLen, budget));
+
+        if (target->received == 0) {
+            ESP_LOGW(TAG, "node 0x%04x parent 0x%04x (%s): %u/%u replies",
+                     target->rloc16, target->parentRloc16, direct ? "direct" : "relayed",
+                     target->received, target->sent);
+            continue;
+        }
+
+        ESP_LOGI(TAG, "node 0x%04x parent 0x%04x (%s): %u/%u replies, rtt min/avg/max %lld/%lld/%lld us",
+                 target->rloc16, target->parentRloc16, direct ? "direct" : "relayed",
+                 target->received, target->sent, target->minUs,
+                 target->totalUs / target->received, target->maxUs);
+
+        if (direct) {
+            directTotalUs += target->totalUs;
+            directReceived += target->received;
+        } else {
+            relayedTotalUs += target->totalUs;
+            relayedReceived += target->received;
+        }
+    }
+
+    ESP_LOGI(TAG, "Latency bench summary: direct avg %lld us (%lu samples), relayed avg %lld us (%lu samples)",
+             directReceived ? directTotalUs / directReceived : 0, (unsigned long)directReceived,
+             relayedReceived ? relayedTotalUs / relayedReceived : 0, (unsigned long)relayedReceived);
+
+    // Débit utile aller: la réponse fait 7 octets, le temps d'aller-retour est dominé par la requête
+    int64_t totalUs = directTotalUs + relayedTotalUs;
+    if (payloadLen > PROBE_REQUEST_LEN && totalUs > 0) {
+        uint64_t bytes = (uint64_t)payloadLen * (directReceived + relayedReceived);
+        ESP_LOGI(TAG, "Throughput estimate: %llu B/s (%u-byte requests, sequential)",
+                 (unsigned long long)(bytes * 1000000 / totalUs), payloadLen);
+    }
+    log_radio_link();
+
+    sBenchRunning = false;
+    vTaskDelete(NULL);
+}
+
+// Retire les réponses en attente d'une rafale et compte celles du nœud visé
+static uint16_t drain_burst_replies(uint16_t rloc16, TickType_t wait)
+{
+    probe_reply_t reply;
+    uint16_t replies = 0;
+
+    while (xQueueReceive(sReplyQueue, &reply, wait) == pdTRUE) {
+        if (reply.type == PROBE_MSG_BURST && reply.rloc16 == rloc16) {
+            replies++;
+        }
+    }
+
+    return replies;
+}
+
+/**
+ * @brief Tâche de rafale: envoie sans attendre puis compte les réponses
+ *
+ * Les envois refusés localement (pool de messages épuisé) et les réponses
+ * manquantes donnent le taux de perte du profil de charge compilé.
+ *
+ * @param pvParameters Instance OpenThread
+ */
+static void probe_burst_task(void *pvParameters)
+{
+    otInstance *instance = (otInstance *)pvParameters;
+    static probe_target_t targets[APP_PROBE_MAX_TARGETS];
+    uint16_t requestLen = (sBenchPayloadLen > PROBE_REQUEST_LEN) ? sBenchPayloadLen : PROBE_REQUEST_LEN;
+    uint16_t seq = 0;
+    otIp6Address peerAddr;
+    uint32_t totalRefused = 0, totalReplies = 0;
+
+    uint16_t count = discover_targets(instance, targets);
+    ESP_LOGI(TAG, "Burst: %u node(s) discovered, %u x %u-byte requests each", count, sBurstCount, requestLen);
+
+    for (uint16_t i = 0; i < count; i++) {
+        probe_target_t *target = &targets[i];
+        uint16_t refused = 0, replies = 0;
+
+        for (uint16_t n = 0; n < sBurstCount; n++) {
+            build_request(PROBE_MSG_BURST, ++seq, sRequest);
+
+            // Rafale: trafic de masse, différé comme les requêtes remplies du banc
+            while (!app_coex_bulk_allowed()) {
+                replies += drain_burst_replies(target->rloc16, pdMS_TO_TICKS(PROBE_BULK_RETRY_MS));
+            }
+
+            esp_openthread_lock_acquire(portMAX_DELAY);
+            app_addr_build_rloc_locked(instance, target->rloc16, &peerAddr);
+            bool sent = probe_send_locked(instance, &peerAddr, APP_PROBE_PORT, sRequest, requestLen);
+            esp_openthread_lock_release();
+
+            if (sent) {
+                target->sent++;
+            } else {
+                refused++;
+            }
+
+            // Vider la file pendant l'envoi: elle est plus courte qu'une rafale
+            replies += drain_burst_replies(target->rloc16, 0);
+        }
+
+        int64_t deadlineUs = esp_timer_get_time() + PROBE_BURST_DRAIN_MS * 1000LL;
+        while (replies < target->sent && esp_timer_get_time() < deadlineUs) {
+            replies += drain_burst_replies(target->rloc16, pdMS_TO_TICKS(PROBE_ROUND_GAP_MS));
+        }
+
+        uint32_t lost = (replies < sBurstCount) ? (sBurstCount - replies) : 0;
+        ESP_LOGI(TAG, "node 0x%04x: %u sent, %u refused locally, %u replies, loss %lu%%",
+                 target->rloc16, target->sent, refused, replies, (unsigned long)(lost * 100 / sBurstCount));
+
+        totalRefused += refused;
+        totalReplies += replies;
+    }
+
+    if (count > 0) {
+        uint32_t attempts = (uint32_t)count * sBurstCount;
+        ESP_LOGI(TAG, "Burst summary: %lu attempts, %lu refused locally, %lu replies, loss %lu%%",
+                 (unsigned long)attempts, (unsigned long)totalRefused, (unsigned long)totalReplies,
+                 (unsigned long)((attempts - totalReplies) * 100 / attempts));
+    }
+
+    sBenchRunning = false;
+    vTaskDelete(NULL);
+}
+
+static otError start_probe_task(otInstance *instance, TaskFunction_t task, const char *name)
+{
+    if (sBenchRunning) {
+        return OT_ERROR_BUSY;
+    }
+
+    if (!sProbeSocketOpen) {
+        return OT_ERROR_INVALID_STATE;
+    }
+
+    if (sReplyQueue == NULL) {
+        sReplyQueue = xQueueCreate(PROBE_REPLY_QUEUE_LEN, sizeof(probe_reply_t));
+        if (sReplyQueue == NULL) {
+            return OT_ERROR_NO_BUFS;
+        }
+    }
+
+    xQueueReset(sReplyQueue);
+    sBenchRunning = true;
+
+    if (xTaskCreate(task, name, 4096, instance, 4, NULL) != pdPASS) {
+        sBenchRunning = false;
+        return OT_ERROR_NO_BUFS;
+    }
+
+    return OT_ERROR_NONE;
+}
+
+otError app_probe_bench_start(otInstance *instance, uint16_t rounds, uint16_t payloadLen)
+{
+    if (sBenchRunning) {
+        return OT_ERROR_BUSY;
+    }
+
+    sBenchRounds = (rounds == 0) ? APP_PROBE_DEFAULT_ROUNDS : rounds;
+    sBenchPayloadLen = (payloadLen > APP_PROBE_MAX_PAYLOAD) ? APP_PROBE_MAX_PAYLOAD : payloadLen;
+
+    return start_probe_task(instance, probe_bench_task, "probe_bench");
+}
+
+otError app_probe_burst_start(otInstance *instance, uint16_t count, uint16_t payloadLen)
+{
+    if (sBenchRunning) {
+        return OT_ERROR_BUSY;
+    }
+
+    sBurstCount = (count == 0) ? APP_PROBE_DEFAULT_BURST : count;
+    sBenchPayloadLen = (payloadLen > APP_PROBE_MAX_PAYLOAD) ? APP_PROBE_MAX_PAYLOAD : payloadLen;
+
+    return start_probe_task(instance, probe_burst_task, "probe_burst");
+}
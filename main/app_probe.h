@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Sonde de latence applicative (découverte des nœuds et mesure d'aller-retour)
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Port UDP de la sonde, distinct du port des commandes */
+#define APP_PROBE_PORT 12346
+
+/** Nombre maximal de nœuds suivis par une mesure */
+#define APP_PROBE_MAX_TARGETS 32
+
+/** Nombre d'allers-retours par nœud si non précisé */
+#define APP_PROBE_DEFAULT_ROUNDS 10
+
+/** Nombre de requêtes par nœud d'une rafale si non précisé */
+#define APP_PROBE_DEFAULT_BURST 50
+
+/** Taille maximale des requêtes d'écho (au-delà de ~80 octets: fragmentation 6LoWPAN) */
+#define APP_PROBE_MAX_PAYLOAD 1024
+
+/**
+ * @brief Ouvre le socket de la sonde et répond aux requêtes reçues
+ *
+ * Tous les nœuds (leader, routeurs, enfants) doivent appeler cette fonction
+ * pour être visibles et mesurables par le benchmark.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @return true si le socket est ouvert, false sinon
+ */
+bool app_probe_init_locked(otInstance *instance);
+
+/**
+ * @brief Lance le benchmark de latence par enfant en tâche de fond
+ *
+ * Le benchmark découvre les nœuds par multicast realm-local, puis mesure
+ * séquentiellement l'aller-retour unicast vers chacun (adresse RLOC).
+ * Les résultats sont groupés par routeur parent, ce qui permet de comparer
+ * une topologie en étoile (tous enfants du leader) à un maillage multi-routeurs.
+ * Avec une charge utile, les requêtes sont complétées à payloadLen octets et
+ * le débit utile aller est estimé; le résumé rappelle le lien radio utilisé
+ * (natif ou RCP et son débit UART) pour comparer les deux configurations.
+ *
+ * @param instance Instance OpenThread
+ * @param rounds Nombre d'allers-retours par nœud
+ * @param payloadLen Taille des requêtes d'écho (0: requête minimale)
+ * @return OT_ERROR_NONE si lancé, OT_ERROR_BUSY si un benchmark est en cours
+ */
+otError app_probe_bench_start(otInstance *instance, uint16_t rounds, uint16_t payloadLen);
+
+/**
+ * @brief Lance une rafale de requêtes vers chaque nœud découvert
+ *
+ * Les requêtes partent sans attendre les réponses, ce qui remplit les files
+ * et le pool de messages. Le journal donne, par nœud, les envois refusés
+ * localement et les réponses manquantes: le taux de perte d'un profil de
+ * charge se lit avec l'occupation du pool (« relay load »).
+ *
+ * @param instance Instance OpenThread
+ * @param count Nombre de requêtes par nœud (0: APP_PROBE_DEFAULT_BURST)
+ * @param payloadLen Taille des requêtes (0: requête minimale)
+ * @return OT_ERROR_NONE si lancé, OT_ERROR_BUSY si une mesure est en cours
+ */
+otError app_probe_burst_start(otInstance *instance, uint16_t count, uint16_t payloadLen);
+
+#ifdef __cplusplus
+}
+#endif
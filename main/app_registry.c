@@ -0,0 +1,695 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Registre des appareils par identifiant logique (EUI-64 → ID court → ML-EID)
+ */
+
+#include "app_registry.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_random.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_deferred.h"
+#include "app_failover.h"
+#include "app_lock.h"
+#include "app_settings.h"
+
+#include "openthread/link.h"
+#include "openthread/thread.h"
+#include "openthread/udp.h"
+
+#include "freertos/FreeRTOS.h"
+
+#define TAG "app_registry"
+
+#define REGISTRY_MSG_ANNOUNCE     0x01
+#define REGISTRY_MSG_REANNOUNCE   0x02
+#define REGISTRY_MSG_SYNC_REQUEST 0x03
+#define REGISTRY_MSG_ANNOUNCE_ACK 0x81
+#define REGISTRY_MSG_SYNC         0x83
+
+// Annonce: type, EUI-64 (8), RLOC16 (2), ML-EID (16); accusé: type, ID (2); demande: type
+#define REGISTRY_ANNOUNCE_LEN   27
+#define REGISTRY_ACK_LEN        3
+#define REGISTRY_REANNOUNCE_LEN 1
+
+// Recopie vers le secours. Demande: type, ID déjà recopiés (2). Réponse: type, nombre d'ID du nœud
+// actif (2), premier ID (2), nombre d'EUI-64 (1), puis les EUI-64 dans l'ordre des ID
+#define REGISTRY_SYNC_REQUEST_LEN 3
+#define REGISTRY_SYNC_HEADER_LEN  6
+#define REGISTRY_SYNC_MAX_IDS     8
+#define REGISTRY_SYNC_CHECK_S     10
+#define REGISTRY_SYNC_UNKNOWN     0xffff
+#define REGISTRY_RX_MAX           (REGISTRY_SYNC_HEADER_LEN + REGISTRY_SYNC_MAX_IDS * 8)
+
+// Table EUI-64 par ID en NVS: blob de 8 octets par appareil, l'ID n à l'offset 8 * (n - 1)
+#define REGISTRY_TABLE_KEY   "registry_eui"
+#define REGISTRY_SAVE_SETTLE_MS    1000
+#define REGISTRY_SAVE_MAX_DEFER_MS 10000
+
+#define REGISTRY_TICK_MS  1000
+#define REGISTRY_RETRY_S  5
+
+// Table de hachage à adressage ouvert, deux fois plus d'alvéoles que d'appareils
+#define HASH_SLOTS 512
+#define HASH_EMPTY 0
+
+_Static_assert((HASH_SLOTS & (HASH_SLOTS - 1)) == 0, "HASH_SLOTS must be a power of two");
+_Static_assert(HASH_SLOTS >= 2 * APP_REGISTRY_MAX_DEVICES, "hash table load factor above 0.5");
+
+/*
+ * Le nœud qui tient le lien hôte attribue les ID, dans l'ordre
+ * d'enregistrement: l'entrée de l'ID n est sEntries[n - 1]. Le nœud de
+ * secours recopie sa table et suit les annonces: après une bascule, les
+ * trames adressées gardent les mêmes ID. Chaque nœud enregistre la table en
+ * NVS et la relit au démarrage. Seule la recopie remplace ou retire des
+ * entrées, pour rejoindre la table du nœud actif.
+ */
+static app_registry_entry_t sEntries[APP_REGISTRY_MAX_DEVICES];
+static uint16_t sHash[HASH_SLOTS];  // Indice + 1 de l'entrée, HASH_EMPTY si libre
+static app_registry_stats_t sStats;
+
+// Copie de la table pour la tâche d'écriture, modifiée sous sTableLock
+static portMUX_TYPE sTableLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t sTable[APP_REGISTRY_MAX_DEVICES][8];
+static uint16_t sTableCount = 0;
+static uint32_t sTableVersion = 0;
+static uint8_t sSaveBuf[APP_REGISTRY_MAX_DEVICES][8];  // Tâche d'écriture seulement
+static uint32_t sPersistedVersion = 0;                  // Tâche d'écriture seulement
+static app_deferred_writer_t sWriter;
+static bool sTableRestored = false;
+
+static otInstance *sInstance = NULL;
+static otUdpSocket sSocket;
+static bool sSocketOpen = false;
+static esp_timer_handle_t sTickTimer = NULL;
+
+// Côté appareil: état de la dernière annonce
+static bool sAcked = false;
+static int64_t sLastAnnounceUs = 0;
+static uint16_t sAnnouncedRloc16 = 0;
+static uint8_t sAnnouncedLeaderId = 0xff;
+static uint32_t sAnnouncedPartitionId = 0;
+
+// Nœud actif: dernière demande de ré-annonce
+static bool sWasOwner = false;
+static int64_t sLastRequestUs = 0;
+
+// Secours: recopie depuis le nœud actif
+static otIp6Address sSyncPeer;
+static uint16_t sSyncTotal = REGISTRY_SYNC_UNKNOWN;
+static int64_t sLastSyncUs = 0;
+
+// Le nœud qui relaie l'hôte tient le registre; l'autre nœud câblé le recopie
+static bool is_owner(void)
+{
+    return app_failover_is_started() && app_failover_is_active();
+}
+
+static bool is_mirror(void)
+{
+    return app_failover_is_started() && !app_failover_is_active();
+}
+
+static uint32_t now_s(void)
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// FNV-1a sur l'EUI-64
+static uint16_t hash_eui64(const uint8_t *eui64)
+{
+    uint32_t hash = 2166136261u;
+
+    for (int i = 0; i < 8; i++) {
+        hash = (hash ^ eui64[i]) * 16777619u;
+    }
+
+    return (uint16_t)(hash & (HASH_SLOTS - 1));
+}
+
+/**
+ * @brief Trouve l'entrée d'un EUI-64 ou l'alvéole libre où l'insérer
+ *
+ * @param eui64 EUI-64 cherché
+ * @param outSlot Alvéole de l'entrée, ou première alvéole libre
+ * @return Entrée trouvée, NULL si absente
+ */
+static app_registry_entry_t *find_eui64(const uint8_t *eui64, uint16_t *outSlot)
+{
+    uint16_t slot = hash_eui64(eui64);
+
+    for (uint16_t probe = 0; probe < HASH_SLOTS; probe++) {
+        if (sHash[slot] == HASH_EMPTY) {
+            *outSlot = slot;
+            return NULL;
+        }
+
+        app_registry_entry_t *entry = &sEntries[sHash[slot] - 1];
+        if (memcmp(entry->eui64, eui64, sizeof(entry->eui64)) == 0) {
+            *outSlot = slot;
+            return entry;
+        }
+
+        if (probe + 1 > sStats.maxProbe) {
+            sStats.maxProbe = probe + 1;
+        }
+        slot = (slot + 1) & (HASH_SLOTS - 1);
+    }
+
+    *outSlot = HASH_SLOTS;
+    return NULL;
+}
+
+static void registry_send_locked(const otIp6Address *peerAddr, const uint8_t *data, uint16_t len)
+{
+    otMessage *message = otUdpNewMessage(sInstance, NULL);
+    if (message == NULL) {
+        ESP_LOGE(TAG, "Failed to create registry message");
+        return;
+    }
+
+    otError error = otMessageAppend(message, data, len);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to append registry data: %d", error);
+        otMessageFree(message);
+        return;
+    }
+
+    otMessageInfo messageInfo;
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = *peerAddr;
+    messageInfo.mPeerPort = APP_REGISTRY_PORT;
+
+    error = otUdpSend(sInstance, &sSocket, message, &messageInfo);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to send registry message: %d", error);
+        otMessageFree(message);
+    }
+}
+
+/**
+ * @brief Écrit la table, une fois par rafale d'enregistrements (tâche d'écriture)
+ *
+ * @param context Non utilisé
+ */
+static void write_table(void *context)
+{
+    uint16_t count;
+    uint32_t version;
+    (void)context;
+
+    portENTER_CRITICAL(&sTableLock);
+    count = sTableCount;
+    version = sTableVersion;
+    memcpy(sSaveBuf, sTable, (size_t)count * sizeof(sTable[0]));
+    portEXIT_CRITICAL(&sTableLock);
+    if (version == sPersistedVersion) {
+        return;
+    }
+
+    esp_err_t err = app_settings_set_blob(REGISTRY_TABLE_KEY, sSaveBuf, (size_t)count * sizeof(sSaveBuf[0]));
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save registry table: %s", esp_err_to_name(err));
+        return;
+    }
+    sPersistedVersion = version;
+    ESP_LOGI(TAG, "Saved registry table: %u devices", count);
+}
+
+static app_registry_entry_t *add_entry(const uint8_t *eui64, uint16_t slot)
+{
+    app_registry_entry_t *entry = &sEntries[sStats.devices];
+
+    memcpy(entry->eui64, eui64, sizeof(entry->eui64));
+    entry->id = ++sStats.devices;
+    entry->rloc16 = APP_REGISTRY_RLOC16_UNKNOWN;
+    sHash[slot] = entry->id;
+
+    portENTER_CRITICAL(&sTableLock);
+    memcpy(sTable[entry->id - 1], eui64, sizeof(sTable[0]));
+    sTableCount = entry->id;
+    sTableVersion++;
+    portEXIT_CRITICAL(&sTableLock);
+    return entry;
+}
+
+// Après une recopie: index de hachage et copie pour la NVS refaits depuis sEntries
+static void rebuild_table_locked(void)
+{
+    uint16_t slot;
+
+    memset(sHash, 0, sizeof(sHash));
+    for (uint16_t i = 0; i < sStats.devices; i++) {
+        // Un doublon transitoire (appareil déplacé vers un autre ID) reste hors de l'index
+        if (find_eui64(sEntries[i].eui64, &slot) == NULL && slot < HASH_SLOTS) {
+            sHash[slot] = i + 1;
+        }
+    }
+
+    portENTER_CRITICAL(&sTableLock);
+    for (uint16_t i = 0; i < sStats.devices; i++) {
+        memcpy(sTable[i], sEntries[i].eui64, sizeof(sTable[0]));
+    }
+    sTableCount = sStats.devices;
+    sTableVersion++;
+    portEXIT_CRITICAL(&sTableLock);
+
+    app_deferred_notify(&sWriter);
+}
+
+// Relit la table enregistrée: les appareils gardent leur ID mais restent à localiser
+static void restore_table(void)
+{
+    size_t length = sizeof(sTable);
+    uint16_t slot;
+
+    esp_err_t err = app_settings_get_blob(REGISTRY_TABLE_KEY, sTable, &length);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        return;
+    }
+    if (err != ESP_OK || length % sizeof(sTable[0]) != 0) {
+        ESP_LOGW(TAG, "Failed to read registry table: %s", esp_err_to_name(err));
+        return;
+    }
+
+    for (size_t i = 0; i < length / sizeof(sTable[0]); i++) {
+        if (find_eui64(sTable[i], &slot) != NULL || slot >= HASH_SLOTS) {
+            ESP_LOGW(TAG, "Registry table corrupted, %u devices kept", sStats.devices);
+            break;
+        }
+        add_entry(sTable[i], slot);
+    }
+    ESP_LOGI(TAG, "Restored registry table: %u devices", sStats.devices);
+}
+
+// Trouve l'entrée d'un appareil, ou la crée sur le nœud actif; NULL si absente ou registre plein
+static app_registry_entry_t *register_locked(const uint8_t *eui64)
+{
+    uint16_t slot;
+
+    app_registry_entry_t *entry = find_eui64(eui64, &slot);
+    if (entry == NULL) {
+        // Le secours n'attribue pas d'ID: il les reçoit du nœud actif
+        if (is_mirror()) {
+            return NULL;
+        }
+        if (sStats.devices >= APP_REGISTRY_MAX_DEVICES || slot >= HASH_SLOTS) {
+            ESP_LOGW(TAG, "Registry full, device dropped");
+            return NULL;
+        }
+
+        entry = add_entry(eui64, slot);
+        app_deferred_notify(&sWriter);
+        ESP_LOGI(TAG, "Device %02x%02x%02x%02x%02x%02x%02x%02x registered as ID %u", eui64[0], eui64[1],
+                 eui64[2], eui64[3], eui64[4], eui64[5], eui64[6], eui64[7], entry->id);
+    }
+
+    entry->lastSeenS = now_s();
+    return entry;
+}
+
+uint16_t app_registry_learn_locked(const uint8_t *eui64, const otIp6Address *address)
+{
+    app_registry_entry_t *entry = register_locked(eui64);
+    if (entry == NULL) {
+        return 0;
+    }
+
+    // Le ML-EID annoncé prime sur l'adresse de l'hôte SRP
+    if (!entry->announced) {
+        entry->address = *address;
+        entry->located = true;
+    }
+    return entry->id;
+}
+
+/*
+ * Nœud actif: demande aux routeurs de s'annoncer, au plus une fois par
+ * REGISTRY_RETRY_S. Les enfants, souvent endormis, ne sont pas réveillés:
+ * ils s'annoncent d'eux-mêmes (changement de leader, de partition, échéance).
+ */
+static void request_reannounce_locked(void)
+{
+    uint8_t request[REGISTRY_REANNOUNCE_LEN] = {REGISTRY_MSG_REANNOUNCE};
+    otIp6Address realmLocalAllRouters;
+    int64_t nowUs = esp_timer_get_time();
+
+    if (!sSocketOpen || !is_owner()) {
+        return;
+    }
+    if (sLastRequestUs != 0 && nowUs - sLastRequestUs < REGISTRY_RETRY_S * 1000000LL) {
+        return;
+    }
+    sLastRequestUs = nowUs;
+
+    otIp6AddressFromString("ff03::2", &realmLocalAllRouters);
+    registry_send_locked(&realmLocalAllRouters, request, sizeof(request));
+    ESP_LOGI(TAG, "Asked devices to announce again");
+}
+
+/*
+ * Nœud actif: enregistre ou met à jour l'appareil, puis lui renvoie son ID.
+ * Secours: met à jour la position d'un appareil déjà recopié, sans répondre.
+ */
+static void handle_announce_locked(const uint8_t *data, const otMessageInfo *messageInfo)
+{
+    sStats.announces++;
+
+    app_registry_entry_t *entry = register_locked(&data[1]);
+    if (entry == NULL) {
+        return;
+    }
+    entry->rloc16 = (uint16_t)((data[9] << 8) | data[10]);
+    memcpy(entry->address.mFields.m8, &data[11], sizeof(entry->address.mFields.m8));
+    entry->located = true;
+    entry->announced = true;
+    if (!is_owner()) {
+        return;
+    }
+
+    uint8_t ack[REGISTRY_ACK_LEN] = {
+        REGISTRY_MSG_ANNOUNCE_ACK,
+        (uint8_t)(entry->id >> 8),
+        (uint8_t)(entry->id & 0xff),
+    };
+    registry_send_locked(&messageInfo->mPeerAddr, ack, sizeof(ack));
+}
+
+// Secours: demande au nœud actif la suite de sa table
+static void request_sync_locked(void)
+{
+    uint8_t request[REGISTRY_SYNC_REQUEST_LEN] = {
+        REGISTRY_MSG_SYNC_REQUEST,
+        (uint8_t)(sStats.syncedIds >> 8),
+        (uint8_t)(sStats.syncedIds & 0xff),
+    };
+
+    sLastSyncUs = esp_timer_get_time();
+    registry_send_locked(&sSyncPeer, request, sizeof(request));
+}
+
+// Nœud actif: envoie au secours les ID qui suivent ceux qu'il a déjà
+static void handle_sync_request_locked(const uint8_t *data, const otMessageInfo *messageInfo)
+{
+    uint8_t reply[REGISTRY_RX_MAX];
+    uint16_t have = (uint16_t)((data[1] << 8) | data[2]);
+    uint8_t count = 0;
+
+    if (!is_owner()) {
+        return;
+    }
+
+    while (have + count < sStats.devices && count < REGISTRY_SYNC_MAX_IDS) {
+        memcpy(&reply[REGISTRY_SYNC_HEADER_LEN + count * 8], sEntries[have + count].eui64, 8);
+        count++;
+    }
+    reply[0] = REGISTRY_MSG_SYNC;
+    reply[1] = (uint8_t)(sStats.devices >> 8);
+    reply[2] = (uint8_t)(sStats.devices & 0xff);
+    reply[3] = (uint8_t)((have + 1) >> 8);
+    reply[4] = (uint8_t)((have + 1) & 0xff);
+    reply[5] = count;
+    registry_send_locked(&messageInfo->mPeerAddr, reply, REGISTRY_SYNC_HEADER_LEN + count * 8);
+}
+
+/*
+ * Secours: aligne sa table sur celle du nœud actif. Une entrée différente
+ * est remplacée (l'appareil sera localisé à sa prochaine annonce), les ID
+ * au-delà de la table du nœud actif sont retirés.
+ */
+static void handle_sync_locked(const uint8_t *data, uint16_t length, const otMessageInfo *messageInfo)
+{
+    uint16_t total = (uint16_t)((data[1] << 8) | data[2]);
+    uint16_t firstId = (uint16_t)((data[3] << 8) | data[4]);
+    uint8_t count = data[5];
+    bool changed = false;
+
+    // Réponse à une demande périmée, ou d'un autre nœud que le nœud actif
+    if (!is_mirror() || length != REGISTRY_SYNC_HEADER_LEN + count * 8 ||
+        !otIp6IsAddressEqual(&messageInfo->mPeerAddr, &sSyncPeer) || firstId != sStats.syncedIds + 1 ||
+        total > APP_REGISTRY_MAX_DEVICES || firstId - 1 + count > total) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        const uint8_t *eui64 = &data[REGISTRY_SYNC_HEADER_LEN + i * 8];
+        app_registry_entry_t *entry = &sEntries[firstId - 1 + i];
+
+        if (firstId + i <= sStats.devices && memcmp(entry->eui64, eui64, sizeof(entry->eui64)) == 0) {
+            continue;
+        }
+        memset(entry, 0, sizeof(*entry));
+        memcpy(entry->eui64, eui64, sizeof(entry->eui64));
+        entry->id = firstId + i;
+        entry->rloc16 = APP_REGISTRY_RLOC16_UNKNOWN;
+        if (entry->id > sStats.devices) {
+            sStats.devices = entry->id;
+        }
+        changed = true;
+    }
+    sStats.syncedIds = firstId - 1 + count;
+
+    if (total < sStats.devices) {
+        memset(&sEntries[total], 0, (size_t)(sStats.devices - total) * sizeof(sEntries[0]));
+        sStats.devices = total;
+        changed = true;
+    }
+    if (changed) {
+        rebuild_table_locked();
+    }
+
+    sSyncTotal = total;
+    if (sStats.syncedIds < sSyncTotal) {
+        request_sync_locked();
+    } else if (changed) {
+        ESP_LOGI(TAG, "Registry table copied from the active node: %u devices", sStats.devices);
+    }
+}
+
+// Fonction de rappel du registre: annonces et recopie sur les nœuds du lien hôte, accusés sur les appareils
+static void handle_registry_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    (void)aContext;
+    uint8_t data[REGISTRY_RX_MAX];
+    uint16_t length = otMessageGetLength(aMessage);
+
+    if (length == 0 || length > sizeof(data)) {
+        return;
+    }
+    otMessageRead(aMessage, 0, data, length);
+
+    if (data[0] == REGISTRY_MSG_ANNOUNCE && length == REGISTRY_ANNOUNCE_LEN) {
+        if (app_failover_is_started()) {
+            handle_announce_locked(data, aMessageInfo);
+        }
+    } else if (data[0] == REGISTRY_MSG_SYNC_REQUEST && length == REGISTRY_SYNC_REQUEST_LEN) {
+        handle_sync_request_locked(data, aMessageInfo);
+    } else if (data[0] == REGISTRY_MSG_SYNC && length >= REGISTRY_SYNC_HEADER_LEN) {
+        handle_sync_locked(data, length, aMessageInfo);
+    } else if (data[0] == REGISTRY_MSG_REANNOUNCE && length == REGISTRY_REANNOUNCE_LEN) {
+        // Nouvelle annonce étalée sur REGISTRY_RETRY_S: les appareils ne répondent pas tous ensemble
+        if (!app_failover_is_started()) {
+            sAcked = false;
+            sLastAnnounceUs = esp_timer_get_time() - (int64_t)(esp_random() % (REGISTRY_RETRY_S * 1000000u));
+        }
+    } else if (data[0] == REGISTRY_MSG_ANNOUNCE_ACK && length == REGISTRY_ACK_LEN) {
+        uint16_t id = (uint16_t)((data[1] << 8) | data[2]);
+        if (!sAcked || id != sStats.ownId) {
+            ESP_LOGI(TAG, "Registered by the host link node as ID %u", id);
+        }
+        sStats.ownId = id;
+        sAcked = true;
+    }
+}
+
+// Appareil: s'annonce aux routeurs, parmi lesquels le nœud actif du lien hôte et son secours
+static void announce_locked(void)
+{
+    otIp6Address realmLocalAllRouters;
+    otExtAddress eui64;
+    uint8_t announce[REGISTRY_ANNOUNCE_LEN];
+    uint16_t rloc16 = otThreadGetRloc16(sInstance);
+
+    otIp6AddressFromString("ff03::2", &realmLocalAllRouters);
+    otLinkGetFactoryAssignedIeeeEui64(sInstance, &eui64);
+    announce[0] = REGISTRY_MSG_ANNOUNCE;
+    memcpy(&announce[1], eui64.m8, sizeof(eui64.m8));
+    announce[9] = (uint8_t)(rloc16 >> 8);
+    announce[10] = (uint8_t)(rloc16 & 0xff);
+    memcpy(&announce[11], otThreadGetMeshLocalEid(sInstance)->mFields.m8, 16);
+
+    registry_send_locked(&realmLocalAllRouters, announce, sizeof(announce));
+}
+
+// Secours: suit le nœud actif, reprend la recopie depuis le début s'il change
+static void sync_tick_locked(int64_t nowUs)
+{
+    otIp6Address peer;
+
+    if (!app_failover_get_active_peer(&peer)) {
+        return;
+    }
+    if (!otIp6IsAddressEqual(&peer, &sSyncPeer)) {
+        sSyncPeer = peer;
+        sStats.syncedIds = 0;
+        sSyncTotal = REGISTRY_SYNC_UNKNOWN;
+    }
+
+    // En retard: une demande par tick (réponse perdue); à jour: une vérification par REGISTRY_SYNC_CHECK_S
+    if (sStats.syncedIds < sSyncTotal || nowUs - sLastSyncUs >= REGISTRY_SYNC_CHECK_S * 1000000LL) {
+        request_sync_locked();
+    }
+}
+
+/*
+ * Appareil: ré-annonce après un changement de RLOC16, de leader ou de
+ * partition, sans accusé, ou à échéance. Nœud actif du lien hôte: à la prise
+ * du lien, demande aux routeurs de s'annoncer pour relocaliser la table
+ * relue. Secours: recopie la table du nœud actif.
+ */
+static void registry_tick_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    otDeviceRole role = otThreadGetDeviceRole(sInstance);
+    int64_t nowUs = esp_timer_get_time();
+    bool owner = is_owner();
+    if (owner && !sWasOwner) {
+        memset(&sSyncPeer, 0, sizeof(sSyncPeer));
+        request_reannounce_locked();
+    }
+    sWasOwner = owner;
+
+    if (app_failover_is_started()) {
+        if (!owner) {
+            sync_tick_locked(nowUs);
+        }
+    } else if (role == OT_DEVICE_ROLE_CHILD || role == OT_DEVICE_ROLE_ROUTER || role == OT_DEVICE_ROLE_LEADER) {
+        uint16_t rloc16 = otThreadGetRloc16(sInstance);
+        uint8_t leaderId = otThreadGetLeaderRouterId(sInstance);
+        uint32_t partitionId = otThreadGetPartitionId(sInstance);
+        int64_t sinceUs = nowUs - sLastAnnounceUs;
+
+        if (rloc16 != sAnnouncedRloc16 || leaderId != sAnnouncedLeaderId || partitionId != sAnnouncedPartitionId) {
+            sAcked = false;
+            sLastAnnounceUs = 0;
+            sinceUs = INT64_MAX;
+        }
+
+        if ((!sAcked && sinceUs >= REGISTRY_RETRY_S * 1000000LL) ||
+            sinceUs >= APP_REGISTRY_REFRESH_S * 1000000LL) {
+            announce_locked();
+            sLastAnnounceUs = nowUs;
+            sAnnouncedRloc16 = rloc16;
+            sAnnouncedLeaderId = leaderId;
+            sAnnouncedPartitionId = partitionId;
+        }
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_REGISTRY, start);
+    esp_openthread_lock_release();
+}
+
+void app_registry_init_locked(otInstance *instance)
+{
+    if (sSocketOpen) {
+        return;
+    }
+
+    sInstance = instance;
+    if (!sTableRestored) {
+        restore_table();
+        sTableRestored = true;
+
+        // Table relue: déjà en NVS, rien à réécrire avant le prochain changement
+        sPersistedVersion = sTableVersion;
+        if (!app_deferred_start(&sWriter, "registry_nvs", REGISTRY_SAVE_SETTLE_MS, REGISTRY_SAVE_MAX_DEFER_MS,
+                                write_table, NULL)) {
+            ESP_LOGE(TAG, "Failed to create registry writer task");
+        }
+    }
+
+    otError error =
+        app_cbwatch_udp_open_locked(instance, &sSocket, handle_registry_receive, NULL, APP_CBWATCH_UDP_REGISTRY);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to open registry UDP socket: %d", error);
+        return;
+    }
+
+    otSockAddr sockaddr;
+    memset(&sockaddr, 0, sizeof(sockaddr));
+    sockaddr.mPort = APP_REGISTRY_PORT;
+
+    error = otUdpBind(instance, &sSocket, &sockaddr, OT_NETIF_THREAD_INTERNAL);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to bind registry UDP socket: %d", error);
+        otUdpClose(instance, &sSocket);
+        return;
+    }
+    sSocketOpen = true;
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = registry_tick_cb,
+        .name = "registry_tick",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sTickTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sTickTimer, REGISTRY_TICK_MS * 1000ULL));
+
+    ESP_LOGI(TAG, "Registry UDP socket initialized on port %d", APP_REGISTRY_PORT);
+}
+
+bool app_registry_is_routed_frame(const uint8_t *data, uint16_t len)
+{
+    return len > 0 && data[0] == APP_REGISTRY_OPCODE;
+}
+
+uint16_t app_registry_frame_id(const uint8_t *data)
+{
+    return (uint16_t)((data[1] << 8) | data[2]);
+}
+
+bool app_registry_lookup_locked(uint16_t id, app_registry_entry_t *outEntry)
+{
+    sStats.lookups++;
+
+    if (id == 0 || id > sStats.devices) {
+        sStats.misses++;
+        return false;
+    }
+    if (!sEntries[id - 1].located) {
+        // ID relu de la table mais appareil ni annoncé ni découvert depuis le démarrage
+        sStats.misses++;
+        request_reannounce_locked();
+        return false;
+    }
+
+    *outEntry = sEntries[id - 1];
+    return true;
+}
+
+bool app_registry_get_by_index_locked(uint16_t index, app_registry_entry_t *outEntry)
+{
+    if (index >= sStats.devices) {
+        return false;
+    }
+
+    *outEntry = sEntries[index];
+    return true;
+}
+
+void app_registry_get_stats_locked(app_registry_stats_t *outStats)
+{
+    *outStats = sStats;
+}
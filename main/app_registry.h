@@ -0,0 +1,122 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Registre des appareils par identifiant logique (EUI-64 → ID court → ML-EID)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+#include "openthread/ip6.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Port UDP des annonces d'appareils */
+#define APP_REGISTRY_PORT 12349
+
+/** Appareils enregistrés au plus par le nœud du lien hôte */
+#define APP_REGISTRY_MAX_DEVICES 256
+
+/** Trame hôte adressée: 0xD0, ID (2 octets, gros-boutiste), puis les commandes */
+#define APP_REGISTRY_OPCODE     0xD0
+#define APP_REGISTRY_HEADER_LEN 3
+
+/** RLOC16 inconnu: appareil appris par la découverte de services, joint par son ML-EID */
+#define APP_REGISTRY_RLOC16_UNKNOWN 0xfffe
+
+/** Ré-annonce périodique d'un appareil déjà enregistré */
+#define APP_REGISTRY_REFRESH_S 300
+
+/** Entrée du registre */
+typedef struct {
+    uint16_t id;
+    uint8_t eui64[8];
+    uint16_t rloc16;
+    otIp6Address address;  // ML-EID annoncé, sinon adresse résolue par la découverte de services
+    bool located;          // Annoncé ou découvert depuis le démarrage; sinon relu de la NVS seulement
+    bool announced;        // address est le ML-EID annoncé par l'appareil
+    uint32_t lastSeenS;  // Secondes depuis le démarrage
+} app_registry_entry_t;
+
+/** Mesures du registre */
+typedef struct {
+    uint16_t devices;
+    uint32_t announces;
+    uint32_t lookups;
+    uint32_t misses;
+    uint16_t maxProbe;  // Plus longue suite de collisions dans la table de hachage
+    uint16_t ownId;     // ID attribué à ce nœud par le nœud du lien hôte, 0 si aucun
+    uint16_t syncedIds;  // Secours: ID recopiés du nœud actif et vérifiés
+} app_registry_stats_t;
+
+/**
+ * @brief Relit la table des ID, ouvre le socket des annonces et démarre la ré-annonce périodique
+ *
+ * Le nœud actif du lien hôte (app_failover) tient le registre, quel que
+ * soit le leader Thread. Les autres nœuds s'annoncent aux routeurs (ff03::2)
+ * à chaque changement de RLOC16, de leader ou de partition, puis toutes les
+ * APP_REGISTRY_REFRESH_S. Le nœud de secours recopie la table du nœud actif
+ * et suit les annonces: après une bascule, les ID ne changent pas. La table
+ * EUI-64 → ID est gardée en NVS: après un redémarrage, un appareil retrouve
+ * son ID. Le nœud actif demande aux routeurs de s'annoncer quand il prend
+ * le lien, et quand une trame vise un ID relu dont l'appareil ne s'est pas
+ * encore annoncé.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+void app_registry_init_locked(otInstance *instance);
+
+/**
+ * @brief Enregistre ou met à jour un appareil découvert par un autre moyen que son annonce
+ *
+ * L'adresse résolue (hôte SRP, souvent une adresse OMR, joignable dans le
+ * maillage) localise l'appareil tant qu'il ne s'est pas annoncé. Son annonce
+ * la remplace par le ML-EID, qu'une découverte ultérieure ne change plus.
+ *
+ * @param eui64 EUI-64 de l'appareil
+ * @param address Adresse résolue de l'appareil
+ * @return ID logique attribué, 0 si le registre est plein
+ */
+uint16_t app_registry_learn_locked(const uint8_t *eui64, const otIp6Address *address);
+
+/**
+ * @brief Indique si une trame hôte est adressée par identifiant logique
+ */
+bool app_registry_is_routed_frame(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Lit l'identifiant logique d'une trame adressée (len > APP_REGISTRY_HEADER_LEN)
+ */
+uint16_t app_registry_frame_id(const uint8_t *data);
+
+/**
+ * @brief Cherche un appareil par identifiant logique, en temps constant
+ *
+ * @param id Identifiant logique
+ * @param outEntry Copie de l'entrée
+ * @return true si l'appareil est enregistré et localisé
+ */
+bool app_registry_lookup_locked(uint16_t id, app_registry_entry_t *outEntry);
+
+/**
+ * @brief Lit l'entrée rangée à un indice, pour l'affichage (0 .. devices-1)
+ *
+ * @return false au-delà du dernier appareil
+ */
+bool app_registry_get_by_index_locked(uint16_t index, app_registry_entry_t *outEntry);
+
+/**
+ * @brief Copie les mesures du registre (verrou OpenThread tenu)
+ */
+void app_registry_get_stats_locked(app_registry_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
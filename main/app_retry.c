@@ -0,0 +1,251 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Nombre de réémissions MAC adapté à la qualité des liens voisins
+ */
+
+#include "app_retry.h"
+
+#include <strings.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_settings.h"
+
+#include "openthread/link.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+#define TAG "app_retry"
+
+#define RETRY_MODE_KEY "retry_mode"
+
+// Les réémissions directes et indirectes sont des réglages globaux de la pile
+#define RETRY_CLASS_DIRECT 0
+#define RETRY_CLASS_INDIRECT 1
+#define RETRY_CLASS_COUNT 2
+
+static const char *const sModeNames[APP_RETRY_MODE_COUNT] = {
+    [APP_RETRY_MODE_OFF] = "off",
+    [APP_RETRY_MODE_ADAPTIVE] = "adaptive",
+};
+
+static const char *const sLinkClassNames[] = {
+    [APP_RETRY_LINK_GOOD] = "good",
+    [APP_RETRY_LINK_MARGINAL] = "marginal",
+    [APP_RETRY_LINK_POOR] = "poor",
+};
+
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sSampleTimer = NULL;
+static app_retry_mode_t sMode = APP_RETRY_MODE_OFF;
+static app_retry_status_t sStatus;
+static app_retry_link_t sLinks[APP_RETRY_MAX_LINKS];
+static uint8_t sLowerSamples[RETRY_CLASS_COUNT];
+
+// Plus petit nombre de réémissions qui ramène la perte sous la cible (FER^(n+1))
+static uint8_t needed_retries(uint16_t frameErrorPermille)
+{
+    uint32_t lossPermille = frameErrorPermille;
+    uint8_t retries = 0;
+
+    while (lossPermille > APP_RETRY_TARGET_LOSS_PERMILLE && retries < APP_RETRY_MAX) {
+        lossPermille = lossPermille * frameErrorPermille / 1000;
+        retries++;
+    }
+    return retries;
+}
+
+static app_retry_link_class_t classify(uint16_t frameErrorPermille)
+{
+    if (frameErrorPermille <= APP_RETRY_GOOD_PERMILLE) {
+        return APP_RETRY_LINK_GOOD;
+    }
+    if (frameErrorPermille <= APP_RETRY_POOR_PERMILLE) {
+        return APP_RETRY_LINK_MARGINAL;
+    }
+    return APP_RETRY_LINK_POOR;
+}
+
+static void apply_locked(uint8_t direct, uint8_t indirect)
+{
+    if (direct == sStatus.direct && indirect == sStatus.indirect) {
+        return;
+    }
+
+    otLinkSetMaxFrameRetriesDirect(sInstance, direct);
+    otLinkSetMaxFrameRetriesIndirect(sInstance, indirect);
+    ESP_LOGI(TAG, "MAC retries: direct %u -> %u, indirect %u -> %u", sStatus.direct, direct, sStatus.indirect,
+             indirect);
+    sStatus.direct = direct;
+    sStatus.indirect = indirect;
+    sStatus.changes++;
+}
+
+// Monte immédiatement, ne redescend que d'un cran après APP_RETRY_HOLD_SAMPLES échantillons plus bas
+static uint8_t next_setting(int retryClass, uint8_t current, uint8_t wanted)
+{
+    if (wanted >= current) {
+        sLowerSamples[retryClass] = 0;
+        return wanted;
+    }
+    if (++sLowerSamples[retryClass] < APP_RETRY_HOLD_SAMPLES) {
+        return current;
+    }
+    sLowerSamples[retryClass] = 0;
+    return current - 1;
+}
+
+// Relève le taux d'erreur de chaque voisin et règle les deux classes
+static void sample_links_locked(void)
+{
+    otNeighborInfoIterator iterator = OT_NEIGHBOR_INFO_ITERATOR_INIT;
+    otNeighborInfo neighbor;
+    const uint8_t defaults[RETRY_CLASS_COUNT] = {sStatus.defaultDirect, sStatus.defaultIndirect};
+    uint8_t wanted[RETRY_CLASS_COUNT] = {defaults[RETRY_CLASS_DIRECT], defaults[RETRY_CLASS_INDIRECT]};
+    uint16_t count = 0;
+
+    sStatus.marginalLinks = 0;
+    sStatus.poorLinks = 0;
+
+    while (count < APP_RETRY_MAX_LINKS &&
+           otThreadGetNextNeighborInfo(sInstance, &iterator, &neighbor) == OT_ERROR_NONE) {
+        app_retry_link_t *link = &sLinks[count++];
+        int retryClass = (neighbor.mIsChild && !neighbor.mRxOnWhenIdle) ? RETRY_CLASS_INDIRECT : RETRY_CLASS_DIRECT;
+
+        link->rloc16 = neighbor.mRloc16;
+        link->indirect = (retryClass == RETRY_CLASS_INDIRECT);
+        link->frameErrorPermille = (uint16_t)((uint32_t)neighbor.mFrameErrorRate * 1000 / 0xffff);
+        link->messageErrorPermille = (uint16_t)((uint32_t)neighbor.mMessageErrorRate * 1000 / 0xffff);
+        link->linkClass = classify(link->frameErrorPermille);
+        link->neededRetries = needed_retries(link->frameErrorPermille);
+
+        uint8_t need = link->neededRetries;
+        if (link->linkClass == APP_RETRY_LINK_POOR) {
+            // Au-delà, chaque essai de plus occupe le canal pour un gain presque nul
+            sStatus.poorLinks++;
+            need = (need < defaults[retryClass]) ? need : defaults[retryClass];
+        } else if (link->linkClass == APP_RETRY_LINK_MARGINAL) {
+            sStatus.marginalLinks++;
+        }
+        if (need > wanted[retryClass]) {
+            wanted[retryClass] = need;
+        }
+    }
+    sStatus.links = count;
+
+    if (sMode == APP_RETRY_MODE_ADAPTIVE) {
+        apply_locked(next_setting(RETRY_CLASS_DIRECT, sStatus.direct, wanted[RETRY_CLASS_DIRECT]),
+                     next_setting(RETRY_CLASS_INDIRECT, sStatus.indirect, wanted[RETRY_CLASS_INDIRECT]));
+    }
+}
+
+static void sample_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    sample_links_locked();
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_RETRY, start);
+    esp_openthread_lock_release();
+}
+
+void app_retry_init_locked(otInstance *instance)
+{
+    uint8_t value;
+
+    if (sSampleTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+    sStatus.defaultDirect = otLinkGetMaxFrameRetriesDirect(instance);
+    sStatus.defaultIndirect = otLinkGetMaxFrameRetriesIndirect(instance);
+    sStatus.direct = sStatus.defaultDirect;
+    sStatus.indirect = sStatus.defaultIndirect;
+
+    if (app_settings_get_u8(RETRY_MODE_KEY, &value) == ESP_OK && value < APP_RETRY_MODE_COUNT) {
+        sMode = (app_retry_mode_t)value;
+    }
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = sample_timer_cb,
+        .name = "retry_sample",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sSampleTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sSampleTimer, APP_RETRY_SAMPLE_PERIOD_S * 1000000ULL));
+
+    ESP_LOGI(TAG, "MAC retry mode: %s (stack defaults: direct %u, indirect %u)", sModeNames[sMode],
+             sStatus.defaultDirect, sStatus.defaultIndirect);
+}
+
+app_retry_mode_t app_retry_mode_get(void)
+{
+    return sMode;
+}
+
+esp_err_t app_retry_mode_set_locked(app_retry_mode_t mode)
+{
+    if (mode >= APP_RETRY_MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sMode = mode;
+    sLowerSamples[RETRY_CLASS_DIRECT] = 0;
+    sLowerSamples[RETRY_CLASS_INDIRECT] = 0;
+    if (sInstance != NULL) {
+        if (mode == APP_RETRY_MODE_OFF) {
+            apply_locked(sStatus.defaultDirect, sStatus.defaultIndirect);
+        } else {
+            sample_links_locked();
+        }
+    }
+    return app_settings_set_u8(RETRY_MODE_KEY, (uint8_t)mode);
+}
+
+const char *app_retry_mode_to_string(app_retry_mode_t mode)
+{
+    return (mode < APP_RETRY_MODE_COUNT) ? sModeNames[mode] : "unknown";
+}
+
+bool app_retry_mode_from_string(const char *name, app_retry_mode_t *outMode)
+{
+    for (int i = 0; i < APP_RETRY_MODE_COUNT; i++) {
+        if (strcasecmp(name, sModeNames[i]) == 0) {
+            *outMode = (app_retry_mode_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void app_retry_get_status_locked(app_retry_status_t *outStatus)
+{
+    *outStatus = sStatus;
+}
+
+bool app_retry_get_link_locked(uint16_t index, app_retry_link_t *outLink)
+{
+    if (index >= sStatus.links) {
+        return false;
+    }
+
+    *outLink = sLinks[index];
+    return true;
+}
+
+const char *app_retry_link_class_name(app_retry_link_class_t linkClass)
+{
+    return (linkClass <= APP_RETRY_LINK_POOR) ? sLinkClassNames[linkClass] : "?";
+}
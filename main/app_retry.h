@@ -0,0 +1,146 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Nombre de réémissions MAC adapté à la qualité des liens voisins
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Période d'échantillonnage des taux d'erreur des voisins */
+#define APP_RETRY_SAMPLE_PERIOD_S 10
+
+/** Liens suivis (voisins routeurs et enfants) */
+#define APP_RETRY_MAX_LINKS 32
+
+/** Taux d'erreur par essai (‰) jusqu'auquel un lien est bon */
+#define APP_RETRY_GOOD_PERMILLE 100
+
+/**
+ * Taux d'erreur par essai (‰) au-delà duquel un lien est mauvais: plus de
+ * réémissions n'y changeraient presque rien et occuperaient le canal.
+ */
+#define APP_RETRY_POOR_PERMILLE 600
+
+/** Perte de trame visée après toutes les réémissions, en ‰ */
+#define APP_RETRY_TARGET_LOSS_PERMILLE 10
+
+/**
+ * Plafond des réémissions choisies. Le plancher est la valeur par défaut de
+ * la pile: une réémission n'occupe le canal qu'après un échec, la retirer
+ * n'économise presque rien et multiplie la perte des commandes UDP sans
+ * accusé applicatif.
+ */
+#define APP_RETRY_MAX 7
+
+/** Échantillons consécutifs plus bas avant de baisser d'un cran */
+#define APP_RETRY_HOLD_SAMPLES 3
+
+/**
+ * @brief Modes de réglage
+ *
+ * - OFF:      valeurs par défaut de la pile pour toutes les destinations
+ * - ADAPTIVE: réémissions directes (voisins en écoute permanente) et
+ *             indirectes (enfants endormis) réglées par classe de lien
+ */
+typedef enum {
+    APP_RETRY_MODE_OFF = 0,
+    APP_RETRY_MODE_ADAPTIVE,
+    APP_RETRY_MODE_COUNT,
+} app_retry_mode_t;
+
+/** Classe d'un lien d'après son taux d'erreur par essai */
+typedef enum {
+    APP_RETRY_LINK_GOOD = 0,
+    APP_RETRY_LINK_MARGINAL,
+    APP_RETRY_LINK_POOR,
+} app_retry_link_class_t;
+
+/** Dernier échantillon d'un lien voisin */
+typedef struct {
+    uint16_t rloc16;
+    bool indirect;                  // Enfant endormi: trames envoyées sur sondage
+    uint16_t frameErrorPermille;    // Échecs par essai MAC
+    uint16_t messageErrorPermille;  // Messages perdus après réémissions
+    app_retry_link_class_t linkClass;
+    uint8_t neededRetries;          // Réémissions pour APP_RETRY_TARGET_LOSS_PERMILLE
+} app_retry_link_t;
+
+/** État du réglage */
+typedef struct {
+    uint8_t defaultDirect;  // Valeurs de la pile au démarrage
+    uint8_t defaultIndirect;
+    uint8_t direct;         // Valeurs appliquées
+    uint8_t indirect;
+    uint16_t links;
+    uint16_t marginalLinks;
+    uint16_t poorLinks;
+    uint32_t changes;       // Changements de réglage appliqués
+} app_retry_status_t;
+
+/**
+ * @brief Lit le mode enregistré et démarre l'échantillonnage des liens
+ *
+ * En mode ADAPTIVE, toutes les APP_RETRY_SAMPLE_PERIOD_S secondes, chaque
+ * classe (directe, indirecte) prend le besoin du plus exigeant de ses liens,
+ * sans descendre sous la valeur par défaut de la pile: seuls les liens
+ * marginaux la font monter. Un lien mauvais ne fait pas monter le réglage
+ * au-delà de la valeur par défaut.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+void app_retry_init_locked(otInstance *instance);
+
+/**
+ * @brief Retourne le mode courant
+ */
+app_retry_mode_t app_retry_mode_get(void);
+
+/**
+ * @brief Change le mode, l'applique et l'enregistre en NVS (verrou OpenThread tenu)
+ */
+esp_err_t app_retry_mode_set_locked(app_retry_mode_t mode);
+
+/**
+ * @brief Retourne le nom d'un mode ("off", "adaptive")
+ */
+const char *app_retry_mode_to_string(app_retry_mode_t mode);
+
+/**
+ * @brief Convertit un nom de mode
+ *
+ * @return true si le nom est reconnu, false sinon
+ */
+bool app_retry_mode_from_string(const char *name, app_retry_mode_t *outMode);
+
+/**
+ * @brief Copie l'état du réglage (verrou OpenThread tenu)
+ */
+void app_retry_get_status_locked(app_retry_status_t *outStatus);
+
+/**
+ * @brief Lit le lien rangé à un indice du dernier échantillon (verrou OpenThread tenu)
+ *
+ * @return false au-delà du dernier lien
+ */
+bool app_retry_get_link_locked(uint16_t index, app_retry_link_t *outLink);
+
+/**
+ * @brief Nom court d'une classe de lien ("good", "marginal", "poor")
+ */
+const char *app_retry_link_class_name(app_retry_link_class_t linkClass);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,197 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Rôle du nœud (leader ou enfant) et politique de rôle Thread des enfants
+ */
+
+#include "app_role.h"
+
+#include <string.h>
+#include <strings.h>
+
+#include "esp_log.h"
+#include "app_settings.h"
+
+#include "driver/gpio.h"
+
+#include "openthread/link.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+#define TAG "app_role"
+
+#define NODE_ROLE_KEY   "node_role"
+#define ROLE_POLICY_KEY "role_policy"
+
+static const char *const sNodeRoleNames[APP_NODE_ROLE_COUNT] = {
+    [APP_NODE_ROLE_LEADER] = "leader",
+    [APP_NODE_ROLE_END_DEVICE] = "child",
+    [APP_NODE_ROLE_STANDBY] = "standby",
+    [APP_NODE_ROLE_SNIFFER] = "sniffer",
+};
+
+static app_node_role_t sNodeRole = APP_NODE_ROLE_END_DEVICE;
+static app_node_role_source_t sNodeRoleSource = APP_NODE_ROLE_SOURCE_STRAP;
+
+static const char *const sPolicyNames[APP_ROLE_POLICY_COUNT] = {
+    [APP_ROLE_POLICY_REED] = "reed",
+    [APP_ROLE_POLICY_FED] = "fed",
+    [APP_ROLE_POLICY_MED] = "med",
+    [APP_ROLE_POLICY_SED] = "sed",
+};
+
+static app_node_role_t read_strap_role(void)
+{
+    gpio_config_t io_conf = {
+        .pin_bit_mask = (1ULL << APP_ROLE_STRAP_GPIO),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    ESP_ERROR_CHECK(gpio_config(&io_conf));
+
+    return (gpio_get_level(APP_ROLE_STRAP_GPIO) == 0) ? APP_NODE_ROLE_LEADER : APP_NODE_ROLE_END_DEVICE;
+}
+
+app_node_role_t app_node_role_resolve(void)
+{
+    uint8_t value;
+
+    if (app_settings_get_u8(NODE_ROLE_KEY, &value) == ESP_OK && value < APP_NODE_ROLE_COUNT) {
+        sNodeRole = (app_node_role_t)value;
+        sNodeRoleSource = APP_NODE_ROLE_SOURCE_NVS;
+    } else {
+        sNodeRole = read_strap_role();
+        sNodeRoleSource = APP_NODE_ROLE_SOURCE_STRAP;
+    }
+
+    ESP_LOGI(TAG, "Node role: %s (from %s)", app_node_role_to_string(sNodeRole),
+             (sNodeRoleSource == APP_NODE_ROLE_SOURCE_NVS) ? "nvs" : "strap");
+    return sNodeRole;
+}
+
+app_node_role_t app_node_role_get(void)
+{
+    return sNodeRole;
+}
+
+app_node_role_source_t app_node_role_get_source(void)
+{
+    return sNodeRoleSource;
+}
+
+esp_err_t app_node_role_save(app_node_role_t role)
+{
+    if (role >= APP_NODE_ROLE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return app_settings_set_u8(NODE_ROLE_KEY, (uint8_t)role);
+}
+
+esp_err_t app_node_role_clear(void)
+{
+    return app_settings_erase(NODE_ROLE_KEY);
+}
+
+const char *app_node_role_to_string(app_node_role_t role)
+{
+    if (role >= APP_NODE_ROLE_COUNT) {
+        return "unknown";
+    }
+
+    return sNodeRoleNames[role];
+}
+
+bool app_node_role_from_string(const char *name, app_node_role_t *outRole)
+{
+    for (int i = 0; i < APP_NODE_ROLE_COUNT; i++) {
+        if (strcasecmp(name, sNodeRoleNames[i]) == 0) {
+            *outRole = (app_node_role_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+app_role_policy_t app_role_policy_load(void)
+{
+    uint8_t value;
+
+    if (app_settings_get_u8(ROLE_POLICY_KEY, &value) != ESP_OK || value >= APP_ROLE_POLICY_COUNT) {
+        return APP_ROLE_POLICY_DEFAULT;
+    }
+
+    return (app_role_policy_t)value;
+}
+
+esp_err_t app_role_policy_save(app_role_policy_t policy)
+{
+    if (policy >= APP_ROLE_POLICY_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return app_settings_set_u8(ROLE_POLICY_KEY, (uint8_t)policy);
+}
+
+otError app_role_policy_apply_locked(otInstance *instance, app_role_policy_t policy)
+{
+    bool fullThreadDevice = (policy == APP_ROLE_POLICY_REED || policy == APP_ROLE_POLICY_FED);
+    otLinkModeConfig mode;
+
+    memset(&mode, 0, sizeof(mode));
+    mode.mRxOnWhenIdle = (policy != APP_ROLE_POLICY_SED);
+    mode.mDeviceType = fullThreadDevice;
+    mode.mNetworkData = fullThreadDevice;
+
+    if (policy == APP_ROLE_POLICY_SED) {
+        otError error = otLinkSetPollPeriod(instance, APP_ROLE_SED_POLL_PERIOD_MS);
+        if (error != OT_ERROR_NONE) {
+            ESP_LOGW(TAG, "Failed to set poll period: %d", error);
+        }
+    }
+
+    otError error = otThreadSetLinkMode(instance, mode);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to set link mode: %d", error);
+        return error;
+    }
+
+    // L'éligibilité routeur n'a de sens que pour un FTD
+    if (fullThreadDevice) {
+        error = otThreadSetRouterEligible(instance, policy == APP_ROLE_POLICY_REED);
+        if (error != OT_ERROR_NONE) {
+            ESP_LOGE(TAG, "Failed to set router eligibility: %d", error);
+            return error;
+        }
+    }
+
+    ESP_LOGI(TAG, "Role policy applied: %s (rx-on: %d, ftd: %d)",
+             app_role_policy_to_string(policy), mode.mRxOnWhenIdle, mode.mDeviceType);
+    return OT_ERROR_NONE;
+}
+
+const char *app_role_policy_to_string(app_role_policy_t policy)
+{
+    if (policy >= APP_ROLE_POLICY_COUNT) {
+        return "unknown";
+    }
+
+    return sPolicyNames[policy];
+}
+
+bool app_role_policy_from_string(const char *name, app_role_policy_t *outPolicy)
+{
+    for (int i = 0; i < APP_ROLE_POLICY_COUNT; i++) {
+        if (strcasecmp(name, sPolicyNames[i]) == 0) {
+            *outPolicy = (app_role_policy_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,164 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Rôle du nœud (leader ou enfant) et politique de rôle Thread des enfants
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Rôle applicatif du nœud, choisi au démarrage
+ *
+ * Une seule image contient les deux chemins de code. Le rôle est lu dans
+ * l'ordre: valeur NVS (fixée par « relay node »), puis broche de strap.
+ */
+typedef enum {
+    APP_NODE_ROLE_LEADER = 0,
+    APP_NODE_ROLE_END_DEVICE,
+    APP_NODE_ROLE_STANDBY,      // Routeur câblé à l'hôte, prend le relais du leader
+    APP_NODE_ROLE_SNIFFER,      // Hors réseau: capture pcapng sur le lien hôte
+    APP_NODE_ROLE_COUNT,
+} app_node_role_t;
+
+/** Origine du rôle retenu au démarrage */
+typedef enum {
+    APP_NODE_ROLE_SOURCE_NVS = 0,
+    APP_NODE_ROLE_SOURCE_STRAP,
+} app_node_role_source_t;
+
+/**
+ * Broche de strap lue au démarrage si aucun rôle n'est enregistré en NVS.
+ * Tirage interne vers le haut: broche reliée à la masse = leader,
+ * broche en l'air = enfant. Les rôles de secours et de renifleur se fixent
+ * uniquement en NVS.
+ */
+#define APP_ROLE_STRAP_GPIO 3
+
+/**
+ * @brief Détermine le rôle du nœud au démarrage
+ *
+ * Doit être appelée une fois, après nvs_flash_init() et avant la configuration
+ * d'OpenThread. Le résultat est conservé pour app_node_role_get().
+ *
+ * @return Le rôle retenu
+ */
+app_node_role_t app_node_role_resolve(void);
+
+/**
+ * @brief Retourne le rôle déterminé par app_node_role_resolve()
+ */
+app_node_role_t app_node_role_get(void);
+
+/**
+ * @brief Retourne l'origine du rôle retenu (NVS ou strap)
+ */
+app_node_role_source_t app_node_role_get_source(void);
+
+/**
+ * @brief Enregistre le rôle du nœud en NVS, pris en compte au prochain démarrage
+ *
+ * @param role Rôle à enregistrer
+ * @return ESP_OK ou une erreur NVS
+ */
+esp_err_t app_node_role_save(app_node_role_t role);
+
+/**
+ * @brief Efface le rôle enregistré: la broche de strap décide au prochain démarrage
+ *
+ * @return ESP_OK ou une erreur NVS
+ */
+esp_err_t app_node_role_clear(void);
+
+/**
+ * @brief Retourne le nom court d'un rôle ("leader", "child", "standby")
+ */
+const char *app_node_role_to_string(app_node_role_t role);
+
+/**
+ * @brief Convertit un nom court en rôle de nœud
+ *
+ * @param name Nom court, insensible à la casse
+ * @param outRole Rôle correspondant
+ * @return true si le nom est reconnu, false sinon
+ */
+bool app_node_role_from_string(const char *name, app_node_role_t *outRole);
+
+/**
+ * @brief Politique de rôle Thread d'un appareil non-leader
+ *
+ * - REED: routeur potentiel, peut être promu routeur et accepter des enfants
+ * - FED:  appareil Thread complet, reste enfant (pas de promotion routeur)
+ * - MED:  appareil minimal, récepteur toujours actif
+ * - SED:  appareil minimal endormi, interroge son parent périodiquement
+ */
+typedef enum {
+    APP_ROLE_POLICY_REED = 0,
+    APP_ROLE_POLICY_FED,
+    APP_ROLE_POLICY_MED,
+    APP_ROLE_POLICY_SED,
+    APP_ROLE_POLICY_COUNT,
+} app_role_policy_t;
+
+/** Politique appliquée tant qu'aucune valeur n'est enregistrée en NVS */
+#define APP_ROLE_POLICY_DEFAULT APP_ROLE_POLICY_MED
+
+/** Période d'interrogation du parent pour un appareil SED */
+#define APP_ROLE_SED_POLL_PERIOD_MS 1000
+
+/**
+ * @brief Charge la politique de rôle enregistrée en NVS
+ *
+ * @return La politique enregistrée, ou APP_ROLE_POLICY_DEFAULT si absente/invalide
+ */
+app_role_policy_t app_role_policy_load(void);
+
+/**
+ * @brief Enregistre la politique de rôle en NVS
+ *
+ * @param policy Politique à enregistrer
+ * @return ESP_OK ou une erreur NVS
+ */
+esp_err_t app_role_policy_save(app_role_policy_t policy);
+
+/**
+ * @brief Applique une politique de rôle à l'instance OpenThread
+ *
+ * Configure le mode de liaison, l'éligibilité routeur et, pour un SED,
+ * la période d'interrogation du parent. Peut être appelée avant ou après
+ * le démarrage de Thread: un changement à chaud déclenche une mise à jour
+ * du mode auprès du parent.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param policy Politique à appliquer
+ * @return OT_ERROR_NONE en cas de succès, une erreur OpenThread sinon
+ */
+otError app_role_policy_apply_locked(otInstance *instance, app_role_policy_t policy);
+
+/**
+ * @brief Retourne le nom court d'une politique ("reed", "fed", "med", "sed")
+ */
+const char *app_role_policy_to_string(app_role_policy_t policy);
+
+/**
+ * @brief Convertit un nom court en politique de rôle
+ *
+ * @param name Nom court, insensible à la casse
+ * @param outPolicy Politique correspondante
+ * @return true si le nom est reconnu, false sinon
+ */
+bool app_role_policy_from_string(const char *name, app_role_policy_t *outPolicy);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,542 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Planificateur de commandes périodiques ou différées (roue de temporisation hiérarchique)
+ */
+
+#include "app_sched.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_deferred.h"
+#include "app_lock.h"
+#include "app_settings.h"
+
+#include "freertos/FreeRTOS.h"
+
+#define TAG "app_sched"
+
+/*
+ * Trois niveaux de 64 cases: 1 s, 64 s et 4096 s par case. Une planification
+ * descend d'un niveau quand sa case supérieure arrive à échéance; chaque
+ * seconde ne traite que la case courante du niveau 0.
+ */
+#define WHEEL_BITS   6
+#define WHEEL_SLOTS  (1 << WHEEL_BITS)
+#define WHEEL_MASK   (WHEEL_SLOTS - 1)
+#define WHEEL_LEVELS 3
+#define WHEEL_SPAN   (1UL << (WHEEL_BITS * WHEEL_LEVELS))
+#define NIL          0xffff
+
+// Décalage de la première échéance d'une planification périodique, pour étaler les phases
+#define PHASE_SPREAD_FACTOR 37
+
+#define SCHED_MAP_KEY    "sch_map"
+#define SCHED_KEY_FORMAT "sch%u"
+#define SCHED_RECORD_VERSION 1
+
+// Écritures NVS regroupées: une rafale d'ajouts ou d'échéances ne coûte qu'une écriture de la table
+#define SCHED_WRITER_SETTLE_MS    1000
+#define SCHED_WRITER_MAX_DEFER_MS 10000
+
+typedef struct {
+    bool used;
+    bool periodic;
+    bool ready;
+    bool linked;
+    uint8_t level;
+    uint8_t slot;
+    uint16_t next;
+    uint16_t prev;
+    uint32_t intervalS;
+    uint32_t expiryTick;
+    uint8_t len;
+    uint8_t frame[APP_SCHED_FRAME_MAX];
+} sched_t;
+
+// Copie persistée d'une planification
+typedef struct __attribute__((packed)) {
+    uint8_t version;
+    uint8_t periodic;
+    uint32_t intervalS;
+    uint8_t len;
+    uint8_t frame[APP_SCHED_FRAME_MAX];
+} sched_record_t;
+
+static sched_t sScheds[APP_SCHED_MAX];
+static uint16_t sWheel[WHEEL_LEVELS][WHEEL_SLOTS];
+/*
+ * Table des identifiants utilisés, identifiants à écrire et à effacer en NVS.
+ * Seule la tâche d'écriture touche la NVS. Une planification libérée (échue ou
+ * supprimée) garde son identifiant jusqu'à l'effacement de sa copie.
+ */
+static portMUX_TYPE sMapLock = portMUX_INITIALIZER_UNLOCKED;
+static uint8_t sUsedMap[APP_SCHED_MAX / 8];
+static uint8_t sWriteMap[APP_SCHED_MAX / 8];
+static uint8_t sEraseMap[APP_SCHED_MAX / 8];
+static app_deferred_writer_t sWriter;
+
+// Planifications échues, envoyées une par quantum pour ne pas saturer la radio
+static uint16_t sReady[APP_SCHED_MAX];
+static uint16_t sReadyHead = 0;
+static uint16_t sReadyCount = 0;
+
+static app_sched_send_fn_t sSend = NULL;
+static esp_timer_handle_t sTimer = NULL;
+static int64_t sStartUs = 0;
+static uint32_t sTick = 0;
+static app_sched_stats_t sStats;
+
+static void unlink_sched(uint16_t id)
+{
+    sched_t *sched = &sScheds[id];
+
+    if (!sched->linked) {
+        return;
+    }
+
+    if (sched->prev != NIL) {
+        sScheds[sched->prev].next = sched->next;
+    } else {
+        sWheel[sched->level][sched->slot] = sched->next;
+    }
+    if (sched->next != NIL) {
+        sScheds[sched->next].prev = sched->prev;
+    }
+    sched->linked = false;
+}
+
+static void make_ready(uint16_t id)
+{
+    sScheds[id].ready = true;
+    sReady[(sReadyHead + sReadyCount) % APP_SCHED_MAX] = id;
+    sReadyCount++;
+    if (sReadyCount > sStats.maxReady) {
+        sStats.maxReady = sReadyCount;
+    }
+}
+
+// Range la planification dans la case du niveau le plus fin qui couvre son échéance
+static void insert_sched(uint16_t id)
+{
+    sched_t *sched = &sScheds[id];
+    uint32_t delta = sched->expiryTick - sTick;
+    uint8_t level;
+
+    if (sched->expiryTick <= sTick) {
+        make_ready(id);
+        return;
+    }
+
+    if (delta < WHEEL_SLOTS) {
+        level = 0;
+    } else if (delta < WHEEL_SLOTS * WHEEL_SLOTS) {
+        level = 1;
+    } else {
+        level = 2;
+    }
+
+    // Au-delà de la roue: dernière case du niveau supérieur, reclassée à sa descente
+    uint32_t target = (delta < WHEEL_SPAN) ? sched->expiryTick : sTick + WHEEL_SPAN - 1;
+    uint16_t slot = (target >> (WHEEL_BITS * level)) & WHEEL_MASK;
+
+    sched->level = level;
+    sched->slot = (uint8_t)slot;
+    sched->prev = NIL;
+    sched->next = sWheel[level][slot];
+    if (sched->next != NIL) {
+        sScheds[sched->next].prev = id;
+    }
+    sWheel[level][slot] = id;
+    sched->linked = true;
+}
+
+// Vide une case; ses planifications sont reclassées (niveau inférieur ou file des échues)
+static void drain_slot(uint8_t level, uint16_t slot)
+{
+    uint16_t id = sWheel[level][slot];
+
+    sWheel[level][slot] = NIL;
+    while (id != NIL) {
+        uint16_t next = sScheds[id].next;
+        sScheds[id].linked = false;
+        insert_sched(id);
+        id = next;
+    }
+}
+
+static void advance_tick(void)
+{
+    sTick++;
+
+    if ((sTick & WHEEL_MASK) == 0) {
+        if (((sTick >> WHEEL_BITS) & WHEEL_MASK) == 0) {
+            drain_slot(2, (sTick >> (2 * WHEEL_BITS)) & WHEEL_MASK);
+        }
+        drain_slot(1, (sTick >> WHEEL_BITS) & WHEEL_MASK);
+    }
+    drain_slot(0, sTick & WHEEL_MASK);
+}
+
+static void set_map_bit(uint16_t id, bool used)
+{
+    portENTER_CRITICAL(&sMapLock);
+    if (used) {
+        sUsedMap[id / 8] |= (uint8_t)(1u << (id % 8));
+    } else {
+        sUsedMap[id / 8] &= (uint8_t)~(1u << (id % 8));
+    }
+    portEXIT_CRITICAL(&sMapLock);
+}
+
+static bool erase_pending(uint16_t id)
+{
+    bool pending;
+
+    portENTER_CRITICAL(&sMapLock);
+    pending = (sEraseMap[id / 8] & (1u << (id % 8))) != 0;
+    portEXIT_CRITICAL(&sMapLock);
+    return pending;
+}
+
+// Copie une planification à écrire; false si elle a été libérée entre-temps
+static bool snapshot_record(uint16_t id, sched_record_t *outRecord)
+{
+    bool used;
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    const sched_t *sched = &sScheds[id];
+    used = sched->used;
+    if (used) {
+        outRecord->version = SCHED_RECORD_VERSION;
+        outRecord->periodic = sched->periodic;
+        outRecord->intervalS = sched->intervalS;
+        outRecord->len = sched->len;
+        memcpy(outRecord->frame, sched->frame, sizeof(outRecord->frame));
+    }
+    esp_openthread_lock_release();
+    return used;
+}
+
+/**
+ * @brief Écrit les planifications ajoutées, efface les libérées, puis réécrit
+ *        la table (tâche d'écriture)
+ *
+ * Le verrou OpenThread n'est tenu que pour copier une planification, jamais
+ * pendant une écriture. La table écrite ne marque que les planifications dont
+ * la copie est en NVS.
+ *
+ * @param context Non utilisé
+ */
+static void write_changes(void *context)
+{
+    uint8_t usedMap[sizeof(sUsedMap)];
+    uint8_t writeMap[sizeof(sWriteMap)];
+    uint8_t eraseMap[sizeof(sEraseMap)];
+    sched_record_t record;
+    char key[16];
+    (void)context;
+
+    portENTER_CRITICAL(&sMapLock);
+    memcpy(usedMap, sUsedMap, sizeof(usedMap));
+    memcpy(writeMap, sWriteMap, sizeof(writeMap));
+    memcpy(eraseMap, sEraseMap, sizeof(eraseMap));
+    portEXIT_CRITICAL(&sMapLock);
+
+    for (uint16_t id = 0; id < APP_SCHED_MAX; id++) {
+        uint8_t bit = (uint8_t)(1u << (id % 8));
+        if ((writeMap[id / 8] & bit) == 0) {
+            continue;
+        }
+        snprintf(key, sizeof(key), SCHED_KEY_FORMAT, id);
+        // Libérée entre-temps (son effacement suit) ou écriture refusée: absente de la table
+        if (!snapshot_record(id, &record)) {
+            usedMap[id / 8] &= (uint8_t)~bit;
+        } else if (app_settings_set_blob(key, &record, sizeof(record)) != ESP_OK) {
+            ESP_LOGW(TAG, "Failed to save schedule %u", id);
+            usedMap[id / 8] &= (uint8_t)~bit;
+            writeMap[id / 8] &= (uint8_t)~bit;
+        }
+    }
+    for (uint16_t id = 0; id < APP_SCHED_MAX; id++) {
+        if (eraseMap[id / 8] & (1u << (id % 8))) {
+            snprintf(key, sizeof(key), SCHED_KEY_FORMAT, id);
+            app_settings_erase(key);
+        }
+    }
+    if (app_settings_set_blob(SCHED_MAP_KEY, usedMap, sizeof(usedMap)) != ESP_OK) {
+        ESP_LOGW(TAG, "Failed to save schedule map");
+    }
+
+    // Une écriture refusée reste marquée: la notification suivante la retente
+    portENTER_CRITICAL(&sMapLock);
+    for (size_t i = 0; i < sizeof(sEraseMap); i++) {
+        sWriteMap[i] &= (uint8_t)~writeMap[i];
+        sEraseMap[i] &= (uint8_t)~eraseMap[i];
+    }
+    portEXIT_CRITICAL(&sMapLock);
+}
+
+static void remove_from_ready(uint16_t id)
+{
+    uint16_t kept = 0;
+
+    for (uint16_t i = 0; i < sReadyCount; i++) {
+        uint16_t other = sReady[(sReadyHead + i) % APP_SCHED_MAX];
+        if (other != id) {
+            sReady[(sReadyHead + kept) % APP_SCHED_MAX] = other;
+            kept++;
+        }
+    }
+    sReadyCount = kept;
+}
+
+static void release_sched(uint16_t id)
+{
+    unlink_sched(id);
+    if (sScheds[id].ready) {
+        remove_from_ready(id);
+    }
+    memset(&sScheds[id], 0, sizeof(sScheds[id]));
+    sStats.count--;
+
+    portENTER_CRITICAL(&sMapLock);
+    sUsedMap[id / 8] &= (uint8_t)~(1u << (id % 8));
+    sWriteMap[id / 8] &= (uint8_t)~(1u << (id % 8));
+    sEraseMap[id / 8] |= (uint8_t)(1u << (id % 8));
+    portEXIT_CRITICAL(&sMapLock);
+    app_deferred_notify(&sWriter);
+}
+
+// La temporisation ne tourne que tant qu'une planification existe: aucun réveil ni verrou au repos
+static void update_timer_locked(void)
+{
+    bool pending = sStats.count > 0 || sReadyCount > 0;
+
+    if (pending && !esp_timer_is_active(sTimer)) {
+        esp_timer_start_periodic(sTimer, APP_SCHED_QUANTUM_MS * 1000ULL);
+    } else if (!pending && esp_timer_is_active(sTimer)) {
+        esp_timer_stop(sTimer);
+    }
+}
+
+static void arm_sched(uint16_t id, bool periodic, uint32_t intervalS, const uint8_t *frame, uint8_t len)
+{
+    sched_t *sched = &sScheds[id];
+
+    memset(sched, 0, sizeof(*sched));
+    sched->used = true;
+    sched->periodic = periodic;
+    sched->intervalS = intervalS;
+    sched->len = len;
+    memcpy(sched->frame, frame, len);
+
+    // Phases étalées: deux planifications de même période ne partent pas à la même seconde
+    uint32_t phase = periodic ? ((uint32_t)id * PHASE_SPREAD_FACTOR) % intervalS : 0;
+    sched->expiryTick = sTick + (periodic ? phase + 1 : intervalS);
+    insert_sched(id);
+    sStats.count++;
+}
+
+static void fire_next(void)
+{
+    uint16_t id = sReady[sReadyHead];
+    sched_t *sched = &sScheds[id];
+
+    sReadyHead = (sReadyHead + 1) % APP_SCHED_MAX;
+    sReadyCount--;
+    sched->ready = false;
+
+    int64_t dueUs = sStartUs + (int64_t)sched->expiryTick * 1000000LL;
+    int64_t lateMs = (esp_timer_get_time() - dueUs) / 1000;
+    if (lateMs > (int64_t)sStats.maxLateMs) {
+        sStats.maxLateMs = (uint32_t)lateMs;
+    }
+
+    sStats.fires++;
+    if (!sSend(sched->frame, sched->len)) {
+        sStats.failures++;
+        ESP_LOGW(TAG, "Schedule %u send failed", id);
+    }
+
+    if (!sched->periodic) {
+        release_sched(id);
+        return;
+    }
+
+    // Échéance suivante calée sur la précédente: pas de dérive avec le retard d'envoi
+    sched->expiryTick += sched->intervalS;
+    if (sched->expiryTick <= sTick) {
+        sched->expiryTick = sTick + 1;
+    }
+    insert_sched(id);
+}
+
+static void sched_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    // Rattrape les secondes manquées si le verrou n'a pas pu être pris
+    uint32_t targetTick = (uint32_t)((esp_timer_get_time() - sStartUs) / 1000000);
+    while (sTick < targetTick) {
+        advance_tick();
+    }
+
+    if (sReadyCount > 0) {
+        fire_next();
+    }
+    update_timer_locked();
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_SCHED, start);
+    esp_openthread_lock_release();
+}
+
+static bool valid_schedule(bool periodic, uint32_t intervalS, uint8_t len)
+{
+    (void)periodic;
+
+    return intervalS > 0 && intervalS <= APP_SCHED_MAX_PERIOD_S && len > 0 && len <= APP_SCHED_FRAME_MAX;
+}
+
+static void load_schedules(void)
+{
+    size_t length = sizeof(sUsedMap);
+    char key[16];
+    sched_record_t record;
+
+    if (app_settings_get_blob(SCHED_MAP_KEY, sUsedMap, &length) != ESP_OK || length != sizeof(sUsedMap)) {
+        memset(sUsedMap, 0, sizeof(sUsedMap));
+        return;
+    }
+
+    for (uint16_t id = 0; id < APP_SCHED_MAX; id++) {
+        if ((sUsedMap[id / 8] & (1u << (id % 8))) == 0) {
+            continue;
+        }
+
+        length = sizeof(record);
+        snprintf(key, sizeof(key), SCHED_KEY_FORMAT, id);
+        if (app_settings_get_blob(key, &record, &length) != ESP_OK || length != sizeof(record) ||
+                record.version != SCHED_RECORD_VERSION ||
+                !valid_schedule(record.periodic, record.intervalS, record.len)) {
+            ESP_LOGW(TAG, "Schedule %u unreadable, skipped", id);
+            set_map_bit(id, false);
+            continue;
+        }
+        arm_sched(id, record.periodic, record.intervalS, record.frame, record.len);
+    }
+}
+
+void app_sched_init_locked(otInstance *instance, app_sched_send_fn_t send)
+{
+    (void)instance;
+
+    if (sTimer != NULL) {
+        return;
+    }
+
+    if (!app_deferred_start(&sWriter, "sched_nvs", SCHED_WRITER_SETTLE_MS, SCHED_WRITER_MAX_DEFER_MS, write_changes,
+                            NULL)) {
+        ESP_LOGE(TAG, "Failed to create schedule writer task");
+        return;
+    }
+
+    sSend = send;
+    sStartUs = esp_timer_get_time();
+    memset(sWheel, 0xff, sizeof(sWheel));
+    load_schedules();
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = sched_timer_cb,
+        .name = "sched_wheel",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sTimer));
+    update_timer_locked();
+
+    ESP_LOGI(TAG, "Scheduler started with %u schedule(s)", sStats.count);
+}
+
+esp_err_t app_sched_add_locked(bool periodic, uint32_t intervalS, const uint8_t *frame, uint8_t len, uint16_t *outId)
+{
+    if (!valid_schedule(periodic, intervalS, len)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sTimer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Un identifiant dont la copie NVS attend son effacement n'est pas réattribué
+    uint16_t id = 0;
+    while (id < APP_SCHED_MAX && (sScheds[id].used || erase_pending(id))) {
+        id++;
+    }
+    if (id == APP_SCHED_MAX) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // Roue à l'arrêt: l'échéance part du compteur de secondes remis à jour
+    if (!esp_timer_is_active(sTimer)) {
+        sTick = (uint32_t)((esp_timer_get_time() - sStartUs) / 1000000);
+    }
+    arm_sched(id, periodic, intervalS, frame, len);
+    update_timer_locked();
+
+    // Copie NVS écrite par la tâche d'écriture, jamais depuis la tâche OpenThread
+    portENTER_CRITICAL(&sMapLock);
+    sUsedMap[id / 8] |= (uint8_t)(1u << (id % 8));
+    sWriteMap[id / 8] |= (uint8_t)(1u << (id % 8));
+    portEXIT_CRITICAL(&sMapLock);
+    app_deferred_notify(&sWriter);
+
+    *outId = id;
+    return ESP_OK;
+}
+
+esp_err_t app_sched_remove_locked(uint16_t id)
+{
+    if (id >= APP_SCHED_MAX || !sScheds[id].used) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    release_sched(id);
+    update_timer_locked();
+    return ESP_OK;
+}
+
+bool app_sched_next_locked(uint16_t *ioId, app_sched_entry_t *outEntry)
+{
+    for (uint16_t id = *ioId; id < APP_SCHED_MAX; id++) {
+        const sched_t *sched = &sScheds[id];
+        if (!sched->used) {
+            continue;
+        }
+
+        outEntry->id = id;
+        outEntry->periodic = sched->periodic;
+        outEntry->intervalS = sched->intervalS;
+        outEntry->nextInS = (sched->expiryTick > sTick) ? sched->expiryTick - sTick : 0;
+        outEntry->len = sched->len;
+        memcpy(outEntry->frame, sched->frame, sched->len);
+        *ioId = id;
+        return true;
+    }
+
+    return false;
+}
+
+void app_sched_get_stats_locked(app_sched_stats_t *outStats)
+{
+    *outStats = sStats;
+}
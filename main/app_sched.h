@@ -0,0 +1,113 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Planificateur de commandes périodiques ou différées (roue de temporisation hiérarchique)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Planifications au plus */
+#define APP_SCHED_MAX 256
+
+/** Trame hôte la plus longue d'une planification (commandes ou trame adressée 0xD0) */
+#define APP_SCHED_FRAME_MAX 16
+
+/** Quantum d'émission: au plus une planification part par quantum */
+#define APP_SCHED_QUANTUM_MS 50
+
+/** Plus longue période acceptée (64^3 s, environ 3 jours) */
+#define APP_SCHED_MAX_PERIOD_S (64UL * 64UL * 64UL - 1UL)
+
+/**
+ * @brief Envoi d'une trame planifiée (verrou OpenThread tenu)
+ *
+ * @return true si la trame est partie ou volontairement ignorée
+ */
+typedef bool (*app_sched_send_fn_t)(const uint8_t *data, uint16_t len);
+
+/** Planification, telle que listée */
+typedef struct {
+    uint16_t id;
+    bool periodic;
+    uint32_t intervalS;  // Période, ou délai d'une planification unique
+    uint32_t nextInS;
+    uint8_t len;
+    uint8_t frame[APP_SCHED_FRAME_MAX];
+} app_sched_entry_t;
+
+/** Mesures du planificateur */
+typedef struct {
+    uint16_t count;
+    uint32_t fires;
+    uint32_t failures;
+    uint16_t maxReady;   // Plus longue file de planifications échues en attente du quantum
+    uint32_t maxLateMs;  // Plus long retard entre l'échéance et l'envoi
+} app_sched_stats_t;
+
+/**
+ * @brief Recharge les planifications depuis la NVS et démarre la roue
+ *
+ * Une seule temporisation esp_timer fait avancer la roue (une case par
+ * seconde) et vide la file des planifications échues, une par quantum.
+ * Elle est arrêtée tant qu'aucune planification n'existe.
+ * Les délais repartent du démarrage: il n'y a pas d'heure murale.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param send Envoi des trames planifiées
+ */
+void app_sched_init_locked(otInstance *instance, app_sched_send_fn_t send);
+
+/**
+ * @brief Ajoute une planification et la persiste
+ *
+ * La copie NVS est écrite par la tâche d'écriture de basse priorité, hors
+ * du verrou OpenThread; un échec d'écriture est journalisé et retenté au passage suivant.
+ *
+ * @param periodic true pour répéter toutes les intervalS secondes, false pour un envoi unique
+ * @param intervalS Période ou délai, de 1 à APP_SCHED_MAX_PERIOD_S
+ * @param frame Trame hôte envoyée à chaque échéance
+ * @param len Longueur de la trame
+ * @param outId Identifiant attribué
+ * @return ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM si la table est pleine, ESP_ERR_INVALID_STATE
+ *         si le planificateur n'a pas démarré
+ */
+esp_err_t app_sched_add_locked(bool periodic, uint32_t intervalS, const uint8_t *frame, uint8_t len, uint16_t *outId);
+
+/**
+ * @brief Supprime une planification et sa copie en NVS
+ *
+ * La copie NVS est effacée par une tâche de basse priorité, comme celle
+ * d'une planification unique qui vient d'être envoyée.
+ *
+ * @return ESP_ERR_NOT_FOUND si l'identifiant est libre
+ */
+esp_err_t app_sched_remove_locked(uint16_t id);
+
+/**
+ * @brief Lit la planification suivante à partir de l'identifiant *ioId
+ *
+ * @param ioId Identifiant de départ, mis à jour avec celui trouvé
+ * @return false s'il n'y en a plus
+ */
+bool app_sched_next_locked(uint16_t *ioId, app_sched_entry_t *outEntry);
+
+/**
+ * @brief Copie les mesures du planificateur (verrou OpenThread tenu)
+ */
+void app_sched_get_stats_locked(app_sched_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
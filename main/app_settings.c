@@ -0,0 +1,102 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Paramètres applicatifs persistés en NVS
+ */
+
+#include "app_settings.h"
+
+#include "esp_log.h"
+#include "nvs.h"
+
+#define TAG "app_settings"
+
+esp_err_t app_settings_get_u8(const char *key, uint8_t *value)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(APP_SETTINGS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        // Namespace absent au premier démarrage: équivalent à une clé absente
+        return err;
+    }
+
+    err = nvs_get_u8(handle, key, value);
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t app_settings_set_u8(const char *key, uint8_t value)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(APP_SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_u8(handle, key, value);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write '%s': %s", key, esp_err_to_name(err));
+    }
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t app_settings_get_blob(const char *key, void *value, size_t *length)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(APP_SETTINGS_NAMESPACE, NVS_READONLY, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_get_blob(handle, key, value, length);
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t app_settings_set_blob(const char *key, const void *value, size_t length)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(APP_SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to open NVS namespace: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    err = nvs_set_blob(handle, key, value, length);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to write '%s': %s", key, esp_err_to_name(err));
+    }
+
+    nvs_close(handle);
+    return err;
+}
+
+esp_err_t app_settings_erase(const char *key)
+{
+    nvs_handle_t handle;
+    esp_err_t err = nvs_open(APP_SETTINGS_NAMESPACE, NVS_READWRITE, &handle);
+    if (err != ESP_OK) {
+        return err;
+    }
+
+    err = nvs_erase_key(handle, key);
+    if (err == ESP_ERR_NVS_NOT_FOUND) {
+        err = ESP_OK;
+    } else if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+
+    nvs_close(handle);
+    return err;
+}
@@ -0,0 +1,75 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Paramètres applicatifs persistés en NVS
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Namespace NVS réservé aux paramètres de l'application
+ *
+ * Distinct du namespace utilisé par OpenThread sur la même partition "nvs".
+ */
+#define APP_SETTINGS_NAMESPACE "relay_app"
+
+/**
+ * @brief Lit un octet dans le namespace applicatif
+ *
+ * @param key Clé NVS (15 caractères maximum)
+ * @param value Pointeur vers la valeur lue
+ * @return ESP_OK, ESP_ERR_NVS_NOT_FOUND si la clé n'existe pas, ou une autre erreur NVS
+ */
+esp_err_t app_settings_get_u8(const char *key, uint8_t *value);
+
+/**
+ * @brief Écrit un octet dans le namespace applicatif et valide l'écriture
+ *
+ * @param key Clé NVS (15 caractères maximum)
+ * @param value Valeur à écrire
+ * @return ESP_OK ou une erreur NVS
+ */
+esp_err_t app_settings_set_u8(const char *key, uint8_t value);
+
+/**
+ * @brief Lit un blob dans le namespace applicatif
+ *
+ * @param key Clé NVS (15 caractères maximum)
+ * @param value Buffer de destination
+ * @param length En entrée la taille du buffer, en sortie la taille lue
+ * @return ESP_OK, ESP_ERR_NVS_NOT_FOUND si la clé n'existe pas, ou une autre erreur NVS
+ */
+esp_err_t app_settings_get_blob(const char *key, void *value, size_t *length);
+
+/**
+ * @brief Écrit un blob dans le namespace applicatif et valide l'écriture
+ *
+ * @param key Clé NVS (15 caractères maximum)
+ * @param value Données à écrire
+ * @param length Taille des données en octets
+ * @return ESP_OK ou une erreur NVS
+ */
+esp_err_t app_settings_set_blob(const char *key, const void *value, size_t length);
+
+/**
+ * @brief Supprime une clé du namespace applicatif
+ *
+ * @param key Clé NVS à supprimer
+ * @return ESP_OK (y compris si la clé n'existait pas) ou une erreur NVS
+ */
+esp_err_t app_settings_erase(const char *key);
+
+#ifdef __cplusplus
+}
+#endif
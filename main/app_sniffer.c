@@ -0,0 +1,308 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Mode renifleur 802.15.4: trames capturées en pcapng sur le lien hôte UART0
+ */
+
+#include "app_sniffer.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "app_cbwatch.h"
+#include "app_settings.h"
+
+#include "openthread/link.h"
+
+#include "driver/uart.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define TAG "app_sniffer"
+
+#define SNIFFER_CHANNEL_KEY "sniff_channel"
+
+// Mêmes broches que le lien hôte UART0 (app_ingress.c), qui n'est pas démarré en renifleur
+#define SNIFFER_UART_PORT UART_NUM_0
+#define SNIFFER_UART_TX_PIN 16
+#define SNIFFER_UART_RX_PIN 17
+#define SNIFFER_UART_RX_BUF_SIZE 256
+
+// Chaque écriture dans l'anneau UART ajoute un en-tête d'élément: marge par paquet
+#define SNIFFER_RING_MARGIN 64
+
+// Blocs pcapng
+#define PCAPNG_SHB_TYPE 0x0A0D0D0A
+#define PCAPNG_SHB_LEN 28
+#define PCAPNG_BYTE_ORDER_MAGIC 0x1A2B3C4D
+#define PCAPNG_IDB_TYPE 0x00000001
+#define PCAPNG_IDB_LEN 20
+#define PCAPNG_EPB_TYPE 0x00000006
+#define PCAPNG_EPB_HEADER_LEN 28
+#define PCAPNG_SNAPLEN 256
+
+// En-tête TAP 802.15.4: version, réserve, longueur, puis TLV alignés sur 4 octets
+#define TAP_HEADER_LEN 4
+#define TAP_TLV_LEN 8
+#define TAP_TLV_FCS_TYPE 0
+#define TAP_TLV_RSS 1
+#define TAP_TLV_CHANNEL 3
+#define TAP_TLV_LQI 10
+#define TAP_MAX_LEN (TAP_HEADER_LEN + 4 * TAP_TLV_LEN)
+
+// Les octets de FCS du tampon radio ne sont pas garantis: retirés du paquet (type FCS « aucune »)
+#define FRAME_FCS_LEN 2
+
+static otInstance *sInstance = NULL;
+static app_sniffer_stats_t sStats;
+static volatile bool sSectionPending = false;
+
+static uint8_t *put_le16(uint8_t *out, uint16_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    return out + 2;
+}
+
+static uint8_t *put_le32(uint8_t *out, uint32_t value)
+{
+    out = put_le16(out, (uint16_t)value);
+    return put_le16(out, (uint16_t)(value >> 16));
+}
+
+static uint8_t *put_tlv(uint8_t *out, uint16_t type, uint16_t len, uint32_t value)
+{
+    out = put_le16(out, type);
+    out = put_le16(out, len);
+    return put_le32(out, value);
+}
+
+static bool ring_has_room(size_t needed)
+{
+    size_t freeBytes = 0;
+
+    return uart_get_tx_buffer_free_size(SNIFFER_UART_PORT, &freeBytes) == ESP_OK &&
+           freeBytes >= needed + SNIFFER_RING_MARGIN;
+}
+
+// En-tête de section et description de l'interface: début de fichier pour l'hôte
+static bool write_section(void)
+{
+    uint8_t block[PCAPNG_SHB_LEN + PCAPNG_IDB_LEN];
+    uint8_t *out = block;
+
+    if (!ring_has_room(sizeof(block))) {
+        return false;
+    }
+
+    out = put_le32(out, PCAPNG_SHB_TYPE);
+    out = put_le32(out, PCAPNG_SHB_LEN);
+    out = put_le32(out, PCAPNG_BYTE_ORDER_MAGIC);
+    out = put_le16(out, 1);  // Version 1.0
+    out = put_le16(out, 0);
+    out = put_le32(out, 0xFFFFFFFF);  // Longueur de section inconnue (-1)
+    out = put_le32(out, 0xFFFFFFFF);
+    out = put_le32(out, PCAPNG_SHB_LEN);
+
+    out = put_le32(out, PCAPNG_IDB_TYPE);
+    out = put_le32(out, PCAPNG_IDB_LEN);
+    out = put_le16(out, APP_SNIFFER_LINKTYPE);
+    out = put_le16(out, 0);
+    out = put_le32(out, PCAPNG_SNAPLEN);
+    put_le32(out, PCAPNG_IDB_LEN);
+
+    uart_write_bytes(SNIFFER_UART_PORT, block, sizeof(block));
+    sStats.sections++;
+    sStats.bytes += sizeof(block);
+    return true;
+}
+
+/*
+ * Seuls l'en-tête du bloc et la fin sont construits ici: les octets de la
+ * trame vont du tampon radio à l'anneau d'émission UART sans copie
+ * intermédiaire. Un paquet qui ne tient pas entier dans l'anneau est perdu.
+ */
+static bool write_packet(const otRadioFrame *frame, bool isTx)
+{
+    if (sSectionPending) {
+        if (!write_section()) {
+            return false;
+        }
+        sSectionPending = false;
+    }
+
+    uint16_t capLen = (frame->mLength > FRAME_FCS_LEN) ? frame->mLength - FRAME_FCS_LEN : 0;
+    uint16_t tapLen = TAP_HEADER_LEN + (isTx ? 2 : 4) * TAP_TLV_LEN;
+    uint16_t packetLen = tapLen + capLen;
+    uint16_t padLen = (4 - (packetLen & 3)) & 3;
+    uint32_t blockLen = PCAPNG_EPB_HEADER_LEN + packetLen + padLen + 4;
+
+    if (!ring_has_room(blockLen)) {
+        return false;
+    }
+
+    uint64_t timestampUs = esp_timer_get_time();
+    if (!isTx && frame->mInfo.mRxInfo.mTimestamp != 0) {
+        timestampUs = frame->mInfo.mRxInfo.mTimestamp;
+    }
+
+    uint8_t header[PCAPNG_EPB_HEADER_LEN + TAP_MAX_LEN];
+    uint8_t *out = header;
+    out = put_le32(out, PCAPNG_EPB_TYPE);
+    out = put_le32(out, blockLen);
+    out = put_le32(out, 0);  // Interface 0
+    out = put_le32(out, (uint32_t)(timestampUs >> 32));
+    out = put_le32(out, (uint32_t)timestampUs);
+    out = put_le32(out, packetLen);
+    out = put_le32(out, packetLen);
+
+    out[0] = 0;  // Version TAP
+    out[1] = 0;
+    out = put_le16(out + 2, tapLen);
+    out = put_tlv(out, TAP_TLV_FCS_TYPE, 1, 0);
+    out = put_tlv(out, TAP_TLV_CHANNEL, 3, frame->mChannel);  // Canal sur 16 bits, page 0
+    if (!isTx) {
+        float rssi = frame->mInfo.mRxInfo.mRssi;
+        uint32_t rssiBits;
+        memcpy(&rssiBits, &rssi, sizeof(rssiBits));
+        out = put_tlv(out, TAP_TLV_RSS, 4, rssiBits);
+        out = put_tlv(out, TAP_TLV_LQI, 1, frame->mInfo.mRxInfo.mLqi);
+    }
+
+    uint8_t trailer[3 + 4] = {0};
+    put_le32(&trailer[padLen], blockLen);
+
+    uart_write_bytes(SNIFFER_UART_PORT, header, out - header);
+    uart_write_bytes(SNIFFER_UART_PORT, frame->mPsdu, capLen);
+    uart_write_bytes(SNIFFER_UART_PORT, trailer, padLen + 4);
+
+    sStats.frames++;
+    sStats.bytes += blockLen;
+    if (isTx) {
+        sStats.txFrames++;
+    }
+    return true;
+}
+
+// Appelé par la pile pour chaque trame reçue ou émise
+static void pcap_cb(const otRadioFrame *frame, bool isTx, void *context)
+{
+    (void)context;
+    uint32_t start = app_cbwatch_begin();
+
+    if (!write_packet(frame, isTx)) {
+        sStats.drops++;
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_SNIFFER, start);
+}
+
+// Un lecteur qui se connecte envoie un octet: nouvelle section avant le paquet suivant
+static void sniffer_rx_task(void *arg)
+{
+    uint8_t buf[16];
+    (void)arg;
+
+    while (true) {
+        if (uart_read_bytes(SNIFFER_UART_PORT, buf, sizeof(buf), portMAX_DELAY) > 0) {
+            sSectionPending = true;
+        }
+    }
+}
+
+static esp_err_t install_uart(void)
+{
+    uart_config_t uart_config = {
+        .baud_rate = CONFIG_APP_SNIFFER_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    esp_err_t err = uart_driver_install(SNIFFER_UART_PORT, SNIFFER_UART_RX_BUF_SIZE, APP_SNIFFER_TX_RING_SIZE, 0,
+                                        NULL, 0);
+    if (err == ESP_OK) {
+        err = uart_param_config(SNIFFER_UART_PORT, &uart_config);
+    }
+    if (err == ESP_OK) {
+        err = uart_set_pin(SNIFFER_UART_PORT, SNIFFER_UART_TX_PIN, SNIFFER_UART_RX_PIN, UART_PIN_NO_CHANGE,
+                           UART_PIN_NO_CHANGE);
+    }
+    return err;
+}
+
+void app_sniffer_start_locked(otInstance *instance, uint8_t defaultChannel)
+{
+    uint8_t channel = defaultChannel;
+    uint8_t value;
+
+    if (sStats.running) {
+        return;
+    }
+
+    sInstance = instance;
+    if (app_settings_get_u8(SNIFFER_CHANNEL_KEY, &value) == ESP_OK && value >= APP_SNIFFER_CHANNEL_MIN &&
+        value <= APP_SNIFFER_CHANNEL_MAX) {
+        channel = value;
+    }
+
+    esp_err_t err = install_uart();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install UART0 for capture: %s", esp_err_to_name(err));
+        return;
+    }
+
+    otError error = otLinkSetChannel(instance, channel);
+    if (error == OT_ERROR_NONE) {
+        otLinkSetPcapCallback(instance, pcap_cb, NULL);
+        error = otLinkSetPromiscuous(instance, true);
+    }
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to start capture on channel %u: %d", channel, error);
+        return;
+    }
+
+    sStats.channel = channel;
+    sStats.running = true;
+    sSectionPending = true;
+    if (xTaskCreate(sniffer_rx_task, "sniffer_rx", 2048, NULL, 4, NULL) != pdPASS) {
+        ESP_LOGW(TAG, "No reader task: section header sent once at start only");
+    }
+
+    // UART0 porte aussi la console par défaut: plus aucun journal ne doit s'intercaler dans le flux
+    ESP_LOGI(TAG, "Sniffing channel %u, pcapng on UART0 at %d baud; logs now off", channel,
+             CONFIG_APP_SNIFFER_UART_BAUD);
+    esp_log_level_set("*", ESP_LOG_NONE);
+}
+
+bool app_sniffer_is_running(void)
+{
+    return sStats.running;
+}
+
+esp_err_t app_sniffer_set_channel_locked(uint8_t channel)
+{
+    if (channel < APP_SNIFFER_CHANNEL_MIN || channel > APP_SNIFFER_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (sStats.running) {
+        if (otLinkSetChannel(sInstance, channel) != OT_ERROR_NONE) {
+            return ESP_FAIL;
+        }
+        sStats.channel = channel;
+    }
+    return app_settings_set_u8(SNIFFER_CHANNEL_KEY, channel);
+}
+
+void app_sniffer_get_stats_locked(app_sniffer_stats_t *outStats)
+{
+    *outStats = sStats;
+}
@@ -0,0 +1,80 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Mode renifleur 802.15.4: trames capturées en pcapng sur le lien hôte UART0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Taille de l'anneau d'émission du pilote UART, où les trames sont écrites directement */
+#define APP_SNIFFER_TX_RING_SIZE 8192
+
+/** Canaux 802.15.4 de la bande 2,4 GHz */
+#define APP_SNIFFER_CHANNEL_MIN 11
+#define APP_SNIFFER_CHANNEL_MAX 26
+
+/**
+ * Type de lien de l'interface pcapng: LINKTYPE_IEEE802_15_4_TAP. Chaque
+ * paquet porte un en-tête TAP avec le RSSI, le LQI et le canal.
+ */
+#define APP_SNIFFER_LINKTYPE 283
+
+/** Mesures de la capture */
+typedef struct {
+    bool running;
+    uint8_t channel;
+    uint32_t frames;      // Paquets écrits
+    uint32_t bytes;       // Octets pcapng écrits
+    uint32_t drops;       // Trames perdues: anneau UART plein
+    uint32_t sections;    // En-têtes de section émis (démarrage et demandes de l'hôte)
+    uint32_t txFrames;    // Dont trames émises par ce nœud
+} app_sniffer_stats_t;
+
+/**
+ * @brief Démarre la capture à la place du rôle Thread (verrou OpenThread tenu)
+ *
+ * Installe UART0 à CONFIG_APP_SNIFFER_UART_BAUD avec un anneau d'émission,
+ * règle le canal enregistré (ou defaultChannel), passe la radio en mode
+ * promiscuous et écrit un en-tête de section pcapng. Thread doit être
+ * désactivé: le nœud ne participe pas au réseau.
+ *
+ * Tout octet reçu de l'hôte fait émettre un nouvel en-tête de section avant
+ * le paquet suivant, pour un lecteur qui se connecte en cours de capture.
+ *
+ * @param instance Instance OpenThread
+ * @param defaultChannel Canal sans valeur enregistrée (celui du réseau)
+ */
+void app_sniffer_start_locked(otInstance *instance, uint8_t defaultChannel);
+
+/**
+ * @brief Indique si le nœud a démarré en renifleur
+ */
+bool app_sniffer_is_running(void);
+
+/**
+ * @brief Enregistre le canal capturé, et l'applique si la capture tourne (verrou OpenThread tenu)
+ *
+ * @return ESP_ERR_INVALID_ARG hors 11..26, ESP_FAIL si la radio refuse le canal, ou une erreur NVS
+ */
+esp_err_t app_sniffer_set_channel_locked(uint8_t channel);
+
+/**
+ * @brief Copie les mesures de la capture (verrou OpenThread tenu)
+ */
+void app_sniffer_get_stats_locked(app_sniffer_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
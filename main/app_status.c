@@ -0,0 +1,69 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Canal d'état binaire sur le lien hôte (disponible sans CLI)
+ */
+
+#include "app_status.h"
+
+#include "esp_timer.h"
+#include "app_coex.h"
+#include "app_failover.h"
+#include "app_ingress.h"
+#include "app_role.h"
+
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+static void put_u32(uint8_t *dst, uint32_t value)
+{
+    dst[0] = (uint8_t)(value >> 24);
+    dst[1] = (uint8_t)(value >> 16);
+    dst[2] = (uint8_t)(value >> 8);
+    dst[3] = (uint8_t)(value & 0xff);
+}
+
+bool app_status_is_request(const uint8_t *data, uint16_t len)
+{
+    return (len == 1) && (data[0] == APP_STATUS_OPCODE);
+}
+
+uint16_t app_status_build_locked(otInstance *instance, uint8_t *outFrame)
+{
+    app_failover_status_t failover;
+    app_ingress_counters_t ingress;
+    app_coex_stats_t coex;
+    otChildInfo childInfo;
+    uint16_t childCount = 0;
+    uint32_t dropped = 0;
+
+    while (otThreadGetChildInfoByIndex(instance, childCount, &childInfo) == OT_ERROR_NONE) {
+        childCount++;
+    }
+
+    for (int channel = 0; channel < APP_INGRESS_CHANNEL_COUNT; channel++) {
+        app_ingress_get_counters((app_ingress_channel_t)channel, &ingress);
+        dropped += ingress.dropped;
+    }
+
+    app_failover_get_status(&failover);
+    app_coex_get_stats(&coex);
+
+    uint16_t rloc16 = otThreadGetRloc16(instance);
+
+    outFrame[0] = APP_STATUS_OPCODE;
+    outFrame[1] = APP_STATUS_VERSION;
+    outFrame[2] = (uint8_t)app_node_role_get();
+    outFrame[3] = (uint8_t)otThreadGetDeviceRole(instance);
+    outFrame[4] = (uint8_t)(rloc16 >> 8);
+    outFrame[5] = (uint8_t)(rloc16 & 0xff);
+    outFrame[6] = (childCount > UINT8_MAX) ? UINT8_MAX : (uint8_t)childCount;
+    outFrame[7] = (uint8_t)failover.state;
+    put_u32(&outFrame[8], (uint32_t)(esp_timer_get_time() / 1000000));
+    put_u32(&outFrame[12], dropped);
+    put_u32(&outFrame[16], coex.denials);
+
+    return APP_STATUS_FRAME_LEN;
+}
@@ -0,0 +1,49 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Canal d'état binaire sur le lien hôte (disponible sans CLI)
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Octet de commande hôte demandant l'état du nœud */
+#define APP_STATUS_OPCODE 0xC0
+
+/** Version du format de la réponse */
+#define APP_STATUS_VERSION 1
+
+/**
+ * Taille de la réponse. Format (entiers gros-boutistes):
+ * opcode, version, rôle du nœud, rôle Thread, rloc16 (2), nombre d'enfants,
+ * état du lien hôte, uptime en s (4), trames hôte perdues (4), refus radio (4).
+ */
+#define APP_STATUS_FRAME_LEN 20
+
+/**
+ * @brief Indique si une trame de l'hôte est une demande d'état
+ */
+bool app_status_is_request(const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Construit la réponse d'état
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param outFrame Tampon d'au moins APP_STATUS_FRAME_LEN octets
+ * @return Longueur de la réponse
+ */
+uint16_t app_status_build_locked(otInstance *instance, uint8_t *outFrame);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,385 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Profils de supervision des enfants et mesure du temps de détection
+ */
+
+#include "app_supervision.h"
+
+#include <string.h>
+#include <strings.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_settings.h"
+
+#include "openthread/child_supervision.h"
+#include "openthread/ping_sender.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+
+#define TAG "app_supervision"
+
+#define SUPERVISION_PROFILE_KEY "sup_profile"
+
+// Sonde d'un enfant disparu de la table: un écho vers son ML-EID, peut-être rattaché ailleurs
+#define PROBE_TIMEOUT_MS 3000
+
+/*
+ * Modèle de temps d'antenne 802.15.4 à 250 kbit/s: 32 us par octet,
+ * 6 octets d'en-tête PHY, ACK de 5 octets + 6 d'en-tête PHY, 192 us de
+ * retournement avant l'ACK. Tailles MAC typiques avec sécurité MAC.
+ */
+#define AIRTIME_US_PER_BYTE     32
+#define PHY_HEADER_BYTES        6
+#define ACK_AIRTIME_US          ((5 + PHY_HEADER_BYTES) * AIRTIME_US_PER_BYTE + 192)
+#define MLE_CHILD_UPDATE_BYTES  90
+#define SUPERVISION_FRAME_BYTES 21
+#define DATA_POLL_BYTES         18
+
+static const app_supervision_params_t sProfiles[APP_SUPERVISION_PROFILE_COUNT] = {
+    [APP_SUPERVISION_PROFILE_FAST] = {
+        .name = "fast",
+        .childTimeoutS = 10,
+        .supervisionIntervalS = 3,
+        .checkTimeoutS = 8,
+    },
+    [APP_SUPERVISION_PROFILE_DEFAULT] = {
+        .name = "default",
+        .childTimeoutS = 60,
+        .supervisionIntervalS = 129,
+        .checkTimeoutS = 190,
+    },
+    [APP_SUPERVISION_PROFILE_LOWPOWER] = {
+        .name = "lowpower",
+        .childTimeoutS = 240,
+        .supervisionIntervalS = 0,
+        .checkTimeoutS = 0,
+    },
+};
+
+/*
+ * Enfant suivi par son adresse étendue: un enfant rattaché de nouveau à ce
+ * nœud sous un autre RLOC16 reste la même entrée.
+ */
+typedef struct {
+    bool inUse;
+    bool seen;
+    bool vanished;       // Absent de la table, départ à confirmer
+    bool hasMleid;
+    uint16_t rloc16;
+    otExtAddress extAddress;
+    otIp6Address mleid;
+    int64_t lastHeardUs;
+    uint32_t detectionMs;
+} tracked_child_t;
+
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sMonitorTimer = NULL;
+static tracked_child_t sTracked[APP_SUPERVISION_MAX_CHILDREN];
+static tracked_child_t *sProbing = NULL;
+static bool sProbeReplied = false;
+static app_supervision_stats_t sStats;
+
+app_supervision_profile_t app_supervision_profile_load(void)
+{
+    uint8_t value;
+
+    if (app_settings_get_u8(SUPERVISION_PROFILE_KEY, &value) != ESP_OK || value >= APP_SUPERVISION_PROFILE_COUNT) {
+        return APP_SUPERVISION_PROFILE_DEFAULT;
+    }
+
+    return (app_supervision_profile_t)value;
+}
+
+esp_err_t app_supervision_profile_save(app_supervision_profile_t profile)
+{
+    if (profile >= APP_SUPERVISION_PROFILE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    return app_settings_set_u8(SUPERVISION_PROFILE_KEY, (uint8_t)profile);
+}
+
+const app_supervision_params_t *app_supervision_get_params(app_supervision_profile_t profile)
+{
+    if (profile >= APP_SUPERVISION_PROFILE_COUNT) {
+        profile = APP_SUPERVISION_PROFILE_DEFAULT;
+    }
+
+    return &sProfiles[profile];
+}
+
+bool app_supervision_profile_from_string(const char *name, app_supervision_profile_t *outProfile)
+{
+    for (int i = 0; i < APP_SUPERVISION_PROFILE_COUNT; i++) {
+        if (strcasecmp(name, sProfiles[i].name) == 0) {
+            *outProfile = (app_supervision_profile_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void app_supervision_apply_locked(otInstance *instance, app_supervision_profile_t profile)
+{
+    const app_supervision_params_t *params = app_supervision_get_params(profile);
+
+    otThreadSetChildTimeout(instance, params->childTimeoutS);
+    otChildSupervisionSetInterval(instance, params->supervisionIntervalS);
+    otChildSupervisionSetCheckTimeout(instance, params->checkTimeoutS);
+
+    ESP_LOGI(TAG, "Supervision profile %s: child timeout %lu s, interval %u s, check timeout %u s",
+             params->name, (unsigned long)params->childTimeoutS, params->supervisionIntervalS,
+             params->checkTimeoutS);
+}
+
+static uint32_t frame_airtime_us(uint32_t macBytes)
+{
+    return (macBytes + PHY_HEADER_BYTES) * AIRTIME_US_PER_BYTE + ACK_AIRTIME_US;
+}
+
+uint32_t app_supervision_estimate_airtime_ms_per_hour(const app_supervision_params_t *params, uint32_t pollPeriodMs)
+{
+    uint64_t airtimeUs = 0;
+
+    // Requête + réponse MLE Child Update à chaque période de timeout
+    if (params->childTimeoutS > 0) {
+        airtimeUs += (3600ULL / params->childTimeoutS) * 2 * frame_airtime_us(MLE_CHILD_UPDATE_BYTES);
+    }
+
+    // Trame vide du parent si aucun autre message dans l'intervalle (pire cas: lien inactif)
+    if (params->supervisionIntervalS > 0) {
+        airtimeUs += (3600ULL / params->supervisionIntervalS) * frame_airtime_us(SUPERVISION_FRAME_BYTES);
+    }
+
+    if (pollPeriodMs > 0) {
+        airtimeUs += (3600000ULL / pollPeriodMs) * frame_airtime_us(DATA_POLL_BYTES);
+    }
+
+    return (uint32_t)(airtimeUs / 1000);
+}
+
+static tracked_child_t *find_tracked(const otExtAddress *extAddress)
+{
+    tracked_child_t *freeSlot = NULL;
+
+    for (int i = 0; i < APP_SUPERVISION_MAX_CHILDREN; i++) {
+        if (sTracked[i].inUse && memcmp(&sTracked[i].extAddress, extAddress, sizeof(*extAddress)) == 0) {
+            return &sTracked[i];
+        }
+        if (!sTracked[i].inUse && freeSlot == NULL) {
+            freeSlot = &sTracked[i];
+        }
+    }
+
+    if (freeSlot != NULL) {
+        memset(freeSlot, 0, sizeof(*freeSlot));
+        freeSlot->inUse = true;
+        freeSlot->extAddress = *extAddress;
+    }
+
+    return freeSlot;
+}
+
+// ML-EID enregistré par l'enfant: préfixe mesh-local, hors RLOC/ALOC (IID 0000:00ff:fe00:xxxx)
+static void learn_mleid_locked(uint16_t childIndex, tracked_child_t *tracked)
+{
+    static const uint8_t locatorIid[6] = {0x00, 0x00, 0x00, 0xff, 0xfe, 0x00};
+    const otMeshLocalPrefix *prefix = otThreadGetMeshLocalPrefix(sInstance);
+    otChildIp6AddressIterator iterator = OT_CHILD_IP6_ADDRESS_ITERATOR_INIT;
+    otIp6Address address;
+
+    while (otThreadGetChildNextIp6Address(sInstance, childIndex, &iterator, &address) == OT_ERROR_NONE) {
+        if (memcmp(address.mFields.m8, prefix->m8, sizeof(prefix->m8)) == 0 &&
+            memcmp(&address.mFields.m8[8], locatorIid, sizeof(locatorIid)) != 0) {
+            tracked->mleid = address;
+            tracked->hasMleid = true;
+            return;
+        }
+    }
+}
+
+// L'enfant est-il toujours visible d'ici: routeur (REED promu) ou voisin?
+static bool still_visible_locked(const otExtAddress *extAddress)
+{
+    otNeighborInfoIterator iterator = OT_NEIGHBOR_INFO_ITERATOR_INIT;
+    otNeighborInfo neighbor;
+    otRouterInfo router;
+
+    for (uint16_t id = 0; id <= OT_NETWORK_MAX_ROUTER_ID; id++) {
+        if (otThreadGetRouterInfo(sInstance, id, &router) == OT_ERROR_NONE && router.mAllocated &&
+            memcmp(&router.mExtAddress, extAddress, sizeof(*extAddress)) == 0) {
+            return true;
+        }
+    }
+
+    while (otThreadGetNextNeighborInfo(sInstance, &iterator, &neighbor) == OT_ERROR_NONE) {
+        if (memcmp(&neighbor.mExtAddress, extAddress, sizeof(*extAddress)) == 0) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void count_moved(tracked_child_t *tracked, const char *how)
+{
+    sStats.childrenMoved++;
+    ESP_LOGI(TAG, "Child 0x%04x left this node's table but is alive (%s)", tracked->rloc16, how);
+    tracked->inUse = false;
+}
+
+static void count_lost(tracked_child_t *tracked)
+{
+    sStats.childrenLost++;
+    sStats.lastDetectionMs = tracked->detectionMs;
+    sStats.totalDetectionMs += tracked->detectionMs;
+    if (tracked->detectionMs > sStats.maxDetectionMs) {
+        sStats.maxDetectionMs = tracked->detectionMs;
+    }
+
+    ESP_LOGW(TAG, "Child 0x%04x removed, detected %lu ms after its last frame", tracked->rloc16,
+             (unsigned long)tracked->detectionMs);
+    tracked->inUse = false;
+}
+
+static void probe_reply_cb(const otPingSenderReply *reply, void *context)
+{
+    (void)reply;
+    (void)context;
+    sProbeReplied = true;
+}
+
+// Fin de la sonde (tâche OpenThread): réponse, l'enfant s'est rattaché à un autre parent
+static void probe_done_cb(const otPingSenderStatistics *statistics, void *context)
+{
+    (void)context;
+
+    if (sProbing == NULL) {
+        return;
+    }
+    if (sProbeReplied || statistics->mReceivedCount > 0) {
+        count_moved(sProbing, "re-parented");
+    } else {
+        count_lost(sProbing);
+    }
+    sProbing = NULL;
+}
+
+// Un seul écho à la fois: les autres départs attendent le tick suivant
+static void probe_locked(tracked_child_t *tracked)
+{
+    otPingSenderConfig config;
+
+    if (!tracked->hasMleid) {
+        count_lost(tracked);
+        return;
+    }
+
+    memset(&config, 0, sizeof(config));
+    config.mDestination = tracked->mleid;
+    config.mReplyCallback = probe_reply_cb;
+    config.mStatisticsCallback = probe_done_cb;
+    config.mCount = 1;
+    config.mTimeout = PROBE_TIMEOUT_MS;
+
+    otError error = otPingSenderPing(sInstance, &config);
+    if (error == OT_ERROR_NONE) {
+        sProbing = tracked;
+        sProbeReplied = false;
+    } else if (error != OT_ERROR_BUSY) {
+        count_lost(tracked);
+    }
+}
+
+/*
+ * Échantillonne la table des enfants et mesure le délai de détection des
+ * départs. Un enfant absent de la table n'est compté perdu qu'après deux
+ * vérifications: il n'est ni routeur (REED promu) ni voisin, et son ML-EID
+ * ne répond pas (il ne s'est pas rattaché à un autre parent).
+ */
+static void monitor_timer_cb(void *arg)
+{
+    (void)arg;
+    otChildInfo childInfo;
+    uint16_t childIndex = 0;
+    int64_t nowUs = esp_timer_get_time();
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    for (int i = 0; i < APP_SUPERVISION_MAX_CHILDREN; i++) {
+        sTracked[i].seen = false;
+    }
+
+    while (otThreadGetChildInfoByIndex(sInstance, childIndex, &childInfo) == OT_ERROR_NONE) {
+        tracked_child_t *tracked = find_tracked(&childInfo.mExtAddress);
+        if (tracked != NULL && tracked != sProbing) {
+            // mAge a une résolution d'une seconde: garder l'estimation la plus récente
+            int64_t heardUs = nowUs - (int64_t)childInfo.mAge * 1000000;
+            if (heardUs > tracked->lastHeardUs) {
+                tracked->lastHeardUs = heardUs;
+            }
+            tracked->rloc16 = childInfo.mRloc16;
+            tracked->vanished = false;
+            tracked->seen = true;
+            if (!tracked->hasMleid) {
+                learn_mleid_locked(childIndex, tracked);
+            }
+        }
+        childIndex++;
+    }
+
+    // Les statistiques sont lues par le CLI sur la tâche OpenThread: verrou conservé
+    for (int i = 0; i < APP_SUPERVISION_MAX_CHILDREN; i++) {
+        tracked_child_t *tracked = &sTracked[i];
+        if (!tracked->inUse || tracked->seen || tracked == sProbing) {
+            continue;
+        }
+
+        if (!tracked->vanished) {
+            tracked->vanished = true;
+            tracked->detectionMs = (uint32_t)((nowUs - tracked->lastHeardUs) / 1000);
+            if (still_visible_locked(&tracked->extAddress)) {
+                count_moved(tracked, "now a router or neighbor");
+                continue;
+            }
+        }
+        if (sProbing == NULL) {
+            probe_locked(tracked);
+        }
+    }
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_SUPERVISION, start);
+    esp_openthread_lock_release();
+}
+
+void app_supervision_monitor_start(otInstance *instance)
+{
+    if (sMonitorTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = monitor_timer_cb,
+        .name = "child_monitor",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sMonitorTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sMonitorTimer, APP_SUPERVISION_MONITOR_PERIOD_MS * 1000ULL));
+}
+
+void app_supervision_get_stats(app_supervision_stats_t *outStats)
+{
+    *outStats = sStats;
+}
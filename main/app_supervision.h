@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Profils de supervision des enfants et mesure du temps de détection
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Nombre maximal d'enfants suivis par le moniteur du leader */
+#define APP_SUPERVISION_MAX_CHILDREN 32
+
+/** Période d'échantillonnage de la table des enfants sur le leader */
+#define APP_SUPERVISION_MONITOR_PERIOD_MS 1000
+
+/**
+ * @brief Profils de supervision/timeout, appliqués identiquement sur les deux rôles
+ *
+ * - FAST:     détection rapide d'un enfant disparu, keep-alive fréquents
+ * - DEFAULT:  timeout de 60 s et supervision par défaut de la pile
+ * - LOWPOWER: keep-alive rares, détection lente
+ */
+typedef enum {
+    APP_SUPERVISION_PROFILE_FAST = 0,
+    APP_SUPERVISION_PROFILE_DEFAULT,
+    APP_SUPERVISION_PROFILE_LOWPOWER,
+    APP_SUPERVISION_PROFILE_COUNT,
+} app_supervision_profile_t;
+
+/** Paramètres d'un profil (secondes, 0 = désactivé) */
+typedef struct {
+    const char *name;
+    uint32_t childTimeoutS;
+    uint16_t supervisionIntervalS;
+    uint16_t checkTimeoutS;
+} app_supervision_params_t;
+
+/** Mesures du moniteur de supervision du leader */
+typedef struct {
+    uint32_t childrenLost;
+    uint32_t childrenMoved;  // Sortis de la table mais vivants: promus routeurs ou rattachés ailleurs
+    uint32_t lastDetectionMs;
+    uint32_t maxDetectionMs;
+    uint64_t totalDetectionMs;
+} app_supervision_stats_t;
+
+/**
+ * @brief Charge le profil enregistré en NVS (DEFAULT si absent)
+ */
+app_supervision_profile_t app_supervision_profile_load(void);
+
+/**
+ * @brief Enregistre le profil en NVS
+ */
+esp_err_t app_supervision_profile_save(app_supervision_profile_t profile);
+
+/**
+ * @brief Retourne les paramètres d'un profil
+ */
+const app_supervision_params_t *app_supervision_get_params(app_supervision_profile_t profile);
+
+/**
+ * @brief Convertit un nom de profil ("fast", "default", "lowpower")
+ *
+ * @return true si le nom est reconnu, false sinon
+ */
+bool app_supervision_profile_from_string(const char *name, app_supervision_profile_t *outProfile);
+
+/**
+ * @brief Applique un profil: timeout enfant, intervalle de supervision et
+ *        délai de vérification côté enfant
+ *
+ * Sur un enfant déjà attaché, le nouveau timeout est transmis au parent.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param profile Profil à appliquer
+ */
+void app_supervision_apply_locked(otInstance *instance, app_supervision_profile_t profile);
+
+/**
+ * @brief Démarre le moniteur de la table des enfants (leader)
+ *
+ * Mesure, pour chaque enfant retiré de la table, le délai entre la dernière
+ * trame reçue de lui et sa disparition.
+ *
+ * @param instance Instance OpenThread
+ */
+void app_supervision_monitor_start(otInstance *instance);
+
+/**
+ * @brief Copie les mesures du moniteur
+ */
+void app_supervision_get_stats(app_supervision_stats_t *outStats);
+
+/**
+ * @brief Estime le temps d'antenne des keep-alive d'un enfant, par heure
+ *
+ * Modèle: échanges MLE Child Update à chaque timeout, trame de supervision
+ * vide à chaque intervalle et, pour un enfant endormi, une requête de données
+ * par période d'interrogation. Trafic applicatif exclu.
+ *
+ * @param params Profil évalué
+ * @param pollPeriodMs Période d'interrogation d'un SED, 0 pour un enfant rx-on
+ * @return Temps d'antenne estimé en millisecondes par heure
+ */
+uint32_t app_supervision_estimate_airtime_ms_per_hour(const app_supervision_params_t *params, uint32_t pollPeriodMs);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,732 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Tunnel série transparent entre le lien hôte du leader et l'UART d'un enfant
+ */
+
+#include "app_tunnel.h"
+
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_openthread.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "sdkconfig.h"
+#include "app_addr.h"
+#include "app_cbwatch.h"
+#include "app_coex.h"
+#include "app_role.h"
+
+#include "driver/uart.h"
+
+#include "openthread/link.h"
+#include "openthread/message.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+#include "openthread/udp.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/stream_buffer.h"
+#include "freertos/task.h"
+
+#define TAG "app_tunnel"
+
+/*
+ * Messages (entiers gros-boutistes):
+ * DATA:  type, seq (2), octets du flux
+ * ACK:   type, prochain seq attendu (2), crédit en fragments
+ * OPEN:  type, options (bit 0: boucle)
+ * CLOSE: type
+ */
+#define TUNNEL_MSG_DATA  0x01
+#define TUNNEL_MSG_ACK   0x02
+#define TUNNEL_MSG_OPEN  0x03
+#define TUNNEL_MSG_CLOSE 0x04
+
+#define TUNNEL_OPEN_LOOPBACK 0x01
+
+#define TUNNEL_DATA_HEADER_LEN 3
+#define TUNNEL_ACK_LEN         4
+
+#define TUNNEL_STREAM_SIZE   1024
+#define TUNNEL_HOST_CHUNK    128
+#define TUNNEL_TICK_MS       20
+#define TUNNEL_BENCH_WAIT_MS 30000
+#define TUNNEL_BENCH_SEND_MS 100
+
+// Pair muet depuis ce délai: une ouverture venant d'un autre nœud est acceptée (leader redémarré)
+#define TUNNEL_PEER_IDLE_MS 30000
+
+#define TUNNEL_UART_NUM      UART_NUM_1
+#define TUNNEL_UART_BUF_SIZE 1024
+
+typedef struct {
+    uint16_t len;
+    bool retransmitted;
+    int64_t sentUs;
+    uint8_t data[APP_TUNNEL_CHUNK_MAX];
+} tunnel_chunk_t;
+
+static otInstance *sInstance = NULL;
+static otUdpSocket sSocket;
+static bool sSocketOpen = false;
+static StreamBufferHandle_t sTxStream = NULL;
+static TaskHandle_t sTxTask = NULL;
+static StreamBufferHandle_t sHostStream = NULL;  // Leader: flux reçu, vers le lien hôte
+
+// État protégé par le verrou OpenThread
+static bool sOpen = false;
+static bool sOpenAcked = false;
+static bool sStalled = false;
+static app_ingress_channel_t sHostChannel = APP_INGRESS_CHANNEL_UART0;
+static otIp6Address sPeerAddr;
+static tunnel_chunk_t sWindow[APP_TUNNEL_WINDOW];
+static uint16_t sBaseSeq = 0;      // Plus ancien fragment non acquitté
+static uint16_t sNextSeq = 0;      // Prochain fragment à numéroter
+static uint16_t sExpectedSeq = 0;  // Prochain fragment attendu en réception
+static uint8_t sPeerCredit = 0;
+static int64_t sLastAckUs = 0;
+static int64_t sLastPeerRxUs = 0;
+static int64_t sRttVarUs = 0;
+static int64_t sRtoFloorUs = APP_TUNNEL_RTO_MIN_MS * 1000LL;
+static app_tunnel_stats_t sStats;
+
+// Mesure de débit (leader)
+static volatile bool sBenchRunning = false;
+static uint32_t sBenchTotal = 0;
+static volatile uint32_t sBenchReceived = 0;
+static uint32_t sBenchDiscard = 0;  // Échos de la mesure encore attendus après sa fin, jamais vers l'hôte
+static TaskHandle_t sBenchTask = NULL;
+
+static bool tunnel_send_locked(const uint8_t *data, uint16_t len)
+{
+    otMessage *message = otUdpNewMessage(sInstance, NULL);
+    if (message == NULL) {
+        return false;
+    }
+
+    if (otMessageAppend(message, data, len) != OT_ERROR_NONE) {
+        otMessageFree(message);
+        return false;
+    }
+
+    otMessageInfo messageInfo;
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = sPeerAddr;
+    messageInfo.mPeerPort = APP_TUNNEL_PORT;
+
+    if (otUdpSend(sInstance, &sSocket, message, &messageInfo) != OT_ERROR_NONE) {
+        otMessageFree(message);
+        return false;
+    }
+
+    return true;
+}
+
+static void reset_window_locked(void)
+{
+    sBaseSeq = 0;
+    sNextSeq = 0;
+    sExpectedSeq = 0;
+    sPeerCredit = 0;
+    sStalled = false;
+    sLastAckUs = esp_timer_get_time();
+    memset(&sStats, 0, sizeof(sStats));
+    sStats.rttMinUs = INT64_MAX;
+}
+
+static int64_t clamp_rto(int64_t rtoUs)
+{
+    if (rtoUs < sRtoFloorUs) {
+        return sRtoFloorUs;
+    }
+    return (rtoUs > APP_TUNNEL_RTO_MAX_MS * 1000LL) ? APP_TUNNEL_RTO_MAX_MS * 1000LL : rtoUs;
+}
+
+/**
+ * @brief Plancher et valeur initiale du délai de retransmission, à l'ouverture
+ *
+ * Un lien qui passe par un enfant endormi (ce nœud ou le pair) n'acquitte
+ * pas plus vite que la période de sondage.
+ *
+ * @param peerRloc16 RLOC16 du pair, cherché parmi les enfants de ce nœud
+ */
+static void init_rto_locked(uint16_t peerRloc16)
+{
+    otChildInfo childInfo;
+
+    sRtoFloorUs = APP_TUNNEL_RTO_MIN_MS * 1000LL;
+    if (!otThreadGetLinkMode(sInstance).mRxOnWhenIdle) {
+        int64_t pollUs = otLinkGetPollPeriod(sInstance) * 1000LL;
+        sRtoFloorUs = (pollUs > sRtoFloorUs) ? pollUs : sRtoFloorUs;
+    } else if (otThreadGetChildInfoById(sInstance, peerRloc16, &childInfo) == OT_ERROR_NONE &&
+               !childInfo.mRxOnWhenIdle) {
+        int64_t pollUs = APP_ROLE_SED_POLL_PERIOD_MS * 1000LL;
+        sRtoFloorUs = (pollUs > sRtoFloorUs) ? pollUs : sRtoFloorUs;
+    }
+
+    sRttVarUs = 0;
+    sStats.srttUs = 0;
+    sStats.rtoUs = clamp_rto(APP_TUNNEL_RTO_INIT_MS * 1000LL);
+}
+
+// Nouvel échantillon d'aller-retour (fragment non retransmis)
+static void update_rto_locked(int64_t rttUs)
+{
+    if (sStats.srttUs == 0) {
+        sStats.srttUs = rttUs;
+        sRttVarUs = rttUs / 2;
+    } else {
+        int64_t deltaUs = (sStats.srttUs > rttUs) ? sStats.srttUs - rttUs : rttUs - sStats.srttUs;
+        sRttVarUs = (3 * sRttVarUs + deltaUs) / 4;
+        sStats.srttUs = (7 * sStats.srttUs + rttUs) / 8;
+    }
+    sStats.rtoUs = clamp_rto(sStats.srttUs + 4 * sRttVarUs);
+}
+
+// Place disponible en sortie du récepteur, en fragments
+static uint8_t output_credit_locked(void)
+{
+    // La mesure consomme sans limite pratique
+    size_t freeBytes = APP_TUNNEL_WINDOW * APP_TUNNEL_CHUNK_MAX;
+
+    if (app_node_role_get() != APP_NODE_ROLE_END_DEVICE) {
+        if (!sBenchRunning) {
+            freeBytes = xStreamBufferSpacesAvailable(sHostStream);
+        }
+    } else {
+        if (sStats.loopback) {
+            freeBytes = xStreamBufferSpacesAvailable(sTxStream);
+        } else {
+#if CONFIG_APP_TUNNEL_CHILD_UART_ENABLE
+            uart_get_tx_buffer_free_size(TUNNEL_UART_NUM, &freeBytes);
+#endif
+        }
+    }
+
+    size_t credit = freeBytes / APP_TUNNEL_CHUNK_MAX;
+    return (credit > APP_TUNNEL_WINDOW) ? APP_TUNNEL_WINDOW : (uint8_t)credit;
+}
+
+/**
+ * @brief Remet un fragment reçu dans l'ordre à la sortie du nœud
+ *
+ * Côté leader, les octets passent par la tâche d'écriture du lien hôte:
+ * l'UART peut bloquer, jamais la tâche OpenThread.
+ *
+ * @return false si la sortie n'a pas la place: le fragment n'est pas
+ *         acquitté et l'émetteur le renverra
+ */
+static bool output_locked(const uint8_t *data, uint16_t len)
+{
+    if (app_node_role_get() == APP_NODE_ROLE_END_DEVICE) {
+        if (sStats.loopback) {
+            if (xStreamBufferSpacesAvailable(sTxStream) < len) {
+                return false;
+            }
+            xStreamBufferSend(sTxStream, data, len, 0);
+            xTaskNotifyGive(sTxTask);
+        } else {
+#if CONFIG_APP_TUNNEL_CHILD_UART_ENABLE
+            uart_write_bytes(TUNNEL_UART_NUM, (const char *)data, len);
+#endif
+        }
+    } else if (sBenchRunning) {
+        sBenchReceived += len;
+        if (sBenchReceived >= sBenchTotal) {
+            xTaskNotifyGive(sBenchTask);
+        }
+    } else {
+        uint16_t discard = (sBenchDiscard < len) ? (uint16_t)sBenchDiscard : len;
+        if (xStreamBufferSpacesAvailable(sHostStream) < (size_t)(len - discard)) {
+            return false;
+        }
+        sBenchDiscard -= discard;
+        if (len > discard) {
+            xStreamBufferSend(sHostStream, data + discard, len - discard, 0);
+        }
+    }
+
+    sStats.bytesReceived += len;
+    return true;
+}
+
+static void send_ack_locked(void)
+{
+    uint8_t ack[TUNNEL_ACK_LEN] = {
+        TUNNEL_MSG_ACK,
+        (uint8_t)(sExpectedSeq >> 8),
+        (uint8_t)(sExpectedSeq & 0xff),
+        output_credit_locked(),
+    };
+
+    tunnel_send_locked(ack, sizeof(ack));
+}
+
+static void send_chunk_locked(uint16_t seq)
+{
+    tunnel_chunk_t *chunk = &sWindow[seq % APP_TUNNEL_WINDOW];
+    uint8_t frame[TUNNEL_DATA_HEADER_LEN + APP_TUNNEL_CHUNK_MAX];
+
+    frame[0] = TUNNEL_MSG_DATA;
+    frame[1] = (uint8_t)(seq >> 8);
+    frame[2] = (uint8_t)(seq & 0xff);
+    memcpy(&frame[TUNNEL_DATA_HEADER_LEN], chunk->data, chunk->len);
+
+    // Un envoi refusé (pool plein) reste dans la fenêtre et repart au délai de retransmission
+    chunk->sentUs = esp_timer_get_time();
+    tunnel_send_locked(frame, TUNNEL_DATA_HEADER_LEN + chunk->len);
+}
+
+static void handle_ack_locked(uint16_t ackSeq, uint8_t credit)
+{
+    int64_t nowUs = esp_timer_get_time();
+    uint16_t inFlight = (uint16_t)(sNextSeq - sBaseSeq);
+    uint16_t acked = (uint16_t)(ackSeq - sBaseSeq);
+
+    // Ouverture confirmée: donner à l'enfant son premier crédit pour le sens retour
+    if (!sOpenAcked) {
+        sOpenAcked = true;
+        send_ack_locked();
+    }
+
+    sPeerCredit = credit;
+    sLastAckUs = nowUs;
+
+    // Acquittement ancien ou hors fenêtre: seul le crédit est retenu
+    if (acked == 0 || acked > inFlight) {
+        return;
+    }
+
+    for (uint16_t seq = sBaseSeq; seq != ackSeq; seq++) {
+        tunnel_chunk_t *chunk = &sWindow[seq % APP_TUNNEL_WINDOW];
+
+        // Pas d'échantillon sur un fragment retransmis: l'acquittement est ambigu
+        if (!chunk->retransmitted) {
+            int64_t rttUs = nowUs - chunk->sentUs;
+            sStats.rttSamples++;
+            sStats.rttTotalUs += rttUs;
+            sStats.rttMinUs = (rttUs < sStats.rttMinUs) ? rttUs : sStats.rttMinUs;
+            sStats.rttMaxUs = (rttUs > sStats.rttMaxUs) ? rttUs : sStats.rttMaxUs;
+            update_rto_locked(rttUs);
+        }
+    }
+
+    sBaseSeq = ackSeq;
+}
+
+static void handle_tunnel_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    uint8_t frame[TUNNEL_DATA_HEADER_LEN + APP_TUNNEL_CHUNK_MAX];
+    uint16_t length = otMessageGetLength(aMessage);
+
+    if (length == 0 || length > sizeof(frame)) {
+        return;
+    }
+    otMessageRead(aMessage, 0, frame, length);
+
+    // Tunnel ouvert: seul le pair peut le faire avancer, le rouvrir ou le fermer
+    int64_t nowUs = esp_timer_get_time();
+    if (sOpen && !otIp6IsAddressEqual(&aMessageInfo->mPeerAddr, &sPeerAddr)) {
+        bool peerIdle = nowUs - sLastPeerRxUs >= TUNNEL_PEER_IDLE_MS * 1000LL;
+        if (frame[0] != TUNNEL_MSG_OPEN || !peerIdle) {
+            return;
+        }
+    }
+    sLastPeerRxUs = nowUs;
+
+    switch (frame[0]) {
+    case TUNNEL_MSG_OPEN:
+        // Côté enfant: le leader qui ouvre devient le pair du tunnel
+        if (length < 2) {
+            return;
+        }
+        sPeerAddr = aMessageInfo->mPeerAddr;
+        reset_window_locked();
+        init_rto_locked(0xfffe);  // Le pair est le leader, jamais un enfant de ce nœud
+        sOpen = true;
+        sOpenAcked = true;
+        sStats.loopback = (frame[1] & TUNNEL_OPEN_LOOPBACK) != 0;
+        ESP_LOGI(TAG, "Tunnel opened by leader%s", sStats.loopback ? " (loopback)" : "");
+        send_ack_locked();
+        break;
+
+    case TUNNEL_MSG_CLOSE:
+        sOpen = false;
+        ESP_LOGI(TAG, "Tunnel closed by peer");
+        break;
+
+    case TUNNEL_MSG_DATA:
+        if (!sOpen || length < TUNNEL_DATA_HEADER_LEN) {
+            return;
+        }
+        // Réception dans l'ordre uniquement: un trou fait rejouer la fenêtre par l'émetteur
+        if ((uint16_t)((frame[1] << 8) | frame[2]) == sExpectedSeq &&
+            output_locked(&frame[TUNNEL_DATA_HEADER_LEN], length - TUNNEL_DATA_HEADER_LEN)) {
+            sExpectedSeq++;
+        }
+        send_ack_locked();
+        break;
+
+    case TUNNEL_MSG_ACK:
+        if (!sOpen || length != TUNNEL_ACK_LEN) {
+            return;
+        }
+        handle_ack_locked((uint16_t)((frame[1] << 8) | frame[2]), frame[3]);
+        xTaskNotifyGive(sTxTask);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief Retransmet la fenêtre, remplit les places libres et relance une fenêtre fermée
+ *
+ * @return true si un délai reste à surveiller (ouverture non confirmée,
+ *         fragments en vol ou octets en attente), false si seul un
+ *         événement peut relancer l'émission
+ */
+static bool service_window_locked(void)
+{
+    int64_t nowUs = esp_timer_get_time();
+    uint16_t inFlight = (uint16_t)(sNextSeq - sBaseSeq);
+
+    if (!sOpenAcked) {
+        // Demande d'ouverture perdue: la renvoyer jusqu'au premier acquittement
+        if (nowUs - sLastAckUs > sStats.rtoUs) {
+            uint8_t open[2] = {TUNNEL_MSG_OPEN, sStats.loopback ? TUNNEL_OPEN_LOOPBACK : 0};
+            tunnel_send_locked(open, sizeof(open));
+            sLastAckUs = nowUs;
+        }
+        return true;
+    }
+
+    // Go-back-N: toute la fenêtre repart quand le plus ancien fragment expire, puis le délai double
+    if (inFlight > 0 && nowUs - sWindow[sBaseSeq % APP_TUNNEL_WINDOW].sentUs > sStats.rtoUs) {
+        for (uint16_t seq = sBaseSeq; seq != sNextSeq; seq++) {
+            sWindow[seq % APP_TUNNEL_WINDOW].retransmitted = true;
+            send_chunk_locked(seq);
+            sStats.retransmits++;
+        }
+        sStats.rtoUs = clamp_rto(2 * sStats.rtoUs);
+    }
+
+    // Fenêtre fermée sans rien en vol: sonder avec un fragment après un délai de retransmission
+    uint8_t credit = sPeerCredit;
+    if (credit == 0 && inFlight == 0 && nowUs - sLastAckUs > sStats.rtoUs) {
+        credit = 1;
+    }
+    uint16_t allowed = (credit < APP_TUNNEL_WINDOW) ? credit : APP_TUNNEL_WINDOW;
+
+    // Nouveaux fragments: trafic de masse, laissés dans le flux pendant une fenêtre de commande
+    // (le passage suivant réessaie, les octets en attente gardent le délai armé)
+    if (inFlight < allowed && xStreamBufferBytesAvailable(sTxStream) > 0 && !app_coex_bulk_allowed()) {
+        allowed = inFlight;
+    }
+
+    while (inFlight < allowed) {
+        tunnel_chunk_t *chunk = &sWindow[sNextSeq % APP_TUNNEL_WINDOW];
+        size_t len = xStreamBufferReceive(sTxStream, chunk->data, APP_TUNNEL_CHUNK_MAX, 0);
+        if (len == 0) {
+            break;
+        }
+
+        chunk->len = (uint16_t)len;
+        chunk->retransmitted = false;
+        send_chunk_locked(sNextSeq);
+        sNextSeq++;
+        inFlight++;
+        sStats.chunksSent++;
+        sStats.bytesSent += len;
+    }
+
+    bool blocked = (inFlight >= allowed) && xStreamBufferBytesAvailable(sTxStream) > 0;
+    if (blocked && !sStalled) {
+        sStats.creditStalls++;
+    }
+    sStalled = blocked;
+
+    return inFlight > 0 || xStreamBufferBytesAvailable(sTxStream) > 0;
+}
+
+/**
+ * @brief Tâche d'émission du tunnel
+ *
+ * Tunnel fermé ou fenêtre au repos: attente d'une notification (ouverture,
+ * écriture, acquittement) sans délai. Le passage toutes les TUNNEL_TICK_MS
+ * ne sert qu'à surveiller les délais de retransmission en cours.
+ *
+ * @param pvParameters Paramètres de la tâche (non utilisés)
+ */
+static void tunnel_tx_task(void *pvParameters)
+{
+    (void)pvParameters;
+    TickType_t wait = portMAX_DELAY;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, wait);
+
+        esp_openthread_lock_acquire(portMAX_DELAY);
+        bool timed = sOpen && service_window_locked();
+        esp_openthread_lock_release();
+
+        wait = timed ? pdMS_TO_TICKS(TUNNEL_TICK_MS) : portMAX_DELAY;
+    }
+}
+
+// Côté leader: flux reçu de l'enfant vers le lien hôte tunnelé
+static void tunnel_host_writer_task(void *pvParameters)
+{
+    (void)pvParameters;
+    uint8_t chunk[TUNNEL_HOST_CHUNK];
+
+    while (1) {
+        size_t len = xStreamBufferReceive(sHostStream, chunk, sizeof(chunk), portMAX_DELAY);
+        if (len > 0) {
+            app_ingress_write(sHostChannel, chunk, (uint16_t)len);
+        }
+    }
+}
+
+#if CONFIG_APP_TUNNEL_CHILD_UART_ENABLE
+// Côté enfant: flux de l'équipement série vers le leader
+static void tunnel_uart_read_task(void *pvParameters)
+{
+    (void)pvParameters;
+    uint8_t data[APP_TUNNEL_CHUNK_MAX];
+
+    while (1) {
+        int len = uart_read_bytes(TUNNEL_UART_NUM, data, sizeof(data), pdMS_TO_TICKS(TUNNEL_TICK_MS));
+        if (len <= 0 || !sOpen || sStats.loopback) {
+            continue;
+        }
+
+        xStreamBufferSend(sTxStream, data, len, portMAX_DELAY);
+        xTaskNotifyGive(sTxTask);
+    }
+}
+
+static void tunnel_uart_init(void)
+{
+    uart_config_t uart_config = {
+        .baud_rate = CONFIG_APP_TUNNEL_CHILD_UART_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_DEFAULT,
+    };
+
+    ESP_ERROR_CHECK(uart_driver_install(TUNNEL_UART_NUM, TUNNEL_UART_BUF_SIZE, TUNNEL_UART_BUF_SIZE, 0, NULL, 0));
+    ESP_ERROR_CHECK(uart_param_config(TUNNEL_UART_NUM, &uart_config));
+    ESP_ERROR_CHECK(uart_set_pin(TUNNEL_UART_NUM, CONFIG_APP_TUNNEL_CHILD_UART_TX_PIN,
+                                 CONFIG_APP_TUNNEL_CHILD_UART_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE));
+
+    xTaskCreate(tunnel_uart_read_task, "tunnel_uart", 3072, NULL, 5, NULL);
+}
+#endif
+
+void app_tunnel_init_locked(otInstance *instance)
+{
+    if (sSocketOpen) {
+        return;
+    }
+
+    sInstance = instance;
+
+    sTxStream = xStreamBufferCreate(TUNNEL_STREAM_SIZE, 1);
+    if (app_node_role_get() != APP_NODE_ROLE_END_DEVICE) {
+        sHostStream = xStreamBufferCreate(TUNNEL_STREAM_SIZE, 1);
+    }
+    if (sTxStream == NULL || (app_node_role_get() != APP_NODE_ROLE_END_DEVICE && sHostStream == NULL)) {
+        ESP_LOGE(TAG, "Failed to create tunnel stream buffer");
+        return;
+    }
+
+    otError error =
+        app_cbwatch_udp_open_locked(instance, &sSocket, handle_tunnel_receive, instance, APP_CBWATCH_UDP_TUNNEL);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to open tunnel UDP socket: %d", error);
+        return;
+    }
+
+    otSockAddr sockaddr;
+    memset(&sockaddr, 0, sizeof(sockaddr));
+    sockaddr.mPort = APP_TUNNEL_PORT;
+
+    error = otUdpBind(instance, &sSocket, &sockaddr, OT_NETIF_THREAD_INTERNAL);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to bind tunnel UDP socket: %d", error);
+        otUdpClose(instance, &sSocket);
+        return;
+    }
+
+    sSocketOpen = true;
+    xTaskCreate(tunnel_tx_task, "tunnel_tx", 3072, NULL, 5, &sTxTask);
+    if (sHostStream != NULL) {
+        xTaskCreate(tunnel_host_writer_task, "tunnel_host", 2048, NULL, 4, NULL);
+    }
+
+#if CONFIG_APP_TUNNEL_CHILD_UART_ENABLE
+    if (app_node_role_get() == APP_NODE_ROLE_END_DEVICE) {
+        tunnel_uart_init();
+    }
+#endif
+
+    ESP_LOGI(TAG, "Tunnel UDP socket initialized on port %d", APP_TUNNEL_PORT);
+}
+
+otError app_tunnel_open_locked(otInstance *instance, uint16_t peerRloc16, app_ingress_channel_t hostChannel,
+                               bool loopback)
+{
+    if (!sSocketOpen) {
+        return OT_ERROR_INVALID_STATE;
+    }
+
+    if (hostChannel >= APP_INGRESS_CHANNEL_COUNT) {
+        return OT_ERROR_INVALID_ARGS;
+    }
+
+    xStreamBufferReset(sTxStream);
+    reset_window_locked();
+    init_rto_locked(peerRloc16);
+    app_addr_build_rloc_locked(instance, peerRloc16, &sPeerAddr);
+    sHostChannel = hostChannel;
+    sStats.loopback = loopback;
+    sStats.peerRloc16 = peerRloc16;
+    sBenchDiscard = 0;
+    sOpenAcked = false;
+    sOpen = true;
+    sLastPeerRxUs = esp_timer_get_time();
+
+    // Le premier envoi part au prochain passage de la tâche d'émission
+    sLastAckUs = esp_timer_get_time() - sStats.rtoUs - 1;
+    xTaskNotifyGive(sTxTask);
+
+    ESP_LOGI(TAG, "Tunnel to 0x%04x on %s%s", peerRloc16, app_ingress_channel_name(hostChannel),
+             loopback ? " (loopback)" : "");
+    return OT_ERROR_NONE;
+}
+
+void app_tunnel_close_locked(void)
+{
+    if (!sOpen) {
+        return;
+    }
+
+    uint8_t close[1] = {TUNNEL_MSG_CLOSE};
+    tunnel_send_locked(close, sizeof(close));
+    sOpen = false;
+}
+
+bool app_tunnel_is_bound(app_ingress_channel_t channel)
+{
+    return sOpen && app_node_role_get() != APP_NODE_ROLE_END_DEVICE && channel == sHostChannel;
+}
+
+uint16_t app_tunnel_write(const uint8_t *data, uint16_t len, uint32_t timeoutMs)
+{
+    // Un seul écrivain par tampon de flux: la mesure en cours a la main
+    if (!sOpen || sBenchRunning) {
+        return 0;
+    }
+
+    size_t written = xStreamBufferSend(sTxStream, data, len, pdMS_TO_TICKS(timeoutMs));
+    xTaskNotifyGive(sTxTask);
+    return (uint16_t)written;
+}
+
+/**
+ * @brief Tâche de mesure du tunnel: flux en boucle vers l'enfant et retour
+ *
+ * @param pvParameters Instance OpenThread
+ */
+static void tunnel_bench_task(void *pvParameters)
+{
+    otInstance *instance = (otInstance *)pvParameters;
+    uint8_t pattern[APP_TUNNEL_CHUNK_MAX];
+    uint32_t queued = 0;
+    uint16_t nextHop = 0xfffe;
+    uint8_t pathCost = 0;
+
+    for (int i = 0; i < APP_TUNNEL_CHUNK_MAX; i++) {
+        pattern[i] = (uint8_t)i;
+    }
+
+    // Envoi borné: un tunnel fermé en cours de mesure ne doit pas bloquer la tâche
+    int64_t startUs = esp_timer_get_time();
+    int64_t deadlineUs = startUs + TUNNEL_BENCH_WAIT_MS * 1000LL;
+    while (queued < sBenchTotal && sOpen && esp_timer_get_time() < deadlineUs) {
+        uint32_t len = sBenchTotal - queued;
+        len = (len > sizeof(pattern)) ? sizeof(pattern) : len;
+        queued += xStreamBufferSend(sTxStream, pattern, len, pdMS_TO_TICKS(TUNNEL_BENCH_SEND_MS));
+        xTaskNotifyGive(sTxTask);
+    }
+
+    int64_t waitUs = deadlineUs - esp_timer_get_time();
+    bool complete = queued == sBenchTotal && sOpen && waitUs > 0 &&
+                    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitUs / 1000)) > 0;
+    int64_t elapsedUs = esp_timer_get_time() - startUs;
+
+    /*
+     * Fin de la mesure: les octets pas encore partis sont retirés, et les
+     * échos encore en route sont écartés à leur arrivée au lieu d'aller au
+     * lien hôte.
+     */
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    size_t unsent = xStreamBufferBytesAvailable(sTxStream);
+    xStreamBufferReset(sTxStream);
+    sBenchDiscard = sOpen ? (uint32_t)(queued - unsent) - sBenchReceived : 0;
+    sBenchRunning = false;
+    app_tunnel_stats_t stats = sStats;
+    otThreadGetNextHopAndPathCost(instance, stats.peerRloc16, &nextHop, &pathCost);
+    esp_openthread_lock_release();
+
+    ESP_LOGI(TAG, "Tunnel bench to 0x%04x (next hop 0x%04x, path cost %u): %lu/%lu bytes echoed in %lld ms%s",
+             stats.peerRloc16, nextHop, pathCost, (unsigned long)sBenchReceived, (unsigned long)sBenchTotal,
+             elapsedUs / 1000, complete ? "" : " (timeout)");
+    if (elapsedUs > 0) {
+        ESP_LOGI(TAG, "Tunnel throughput: %llu B/s each way", (unsigned long long)sBenchReceived * 1000000 / elapsedUs);
+    }
+    if (stats.rttSamples > 0) {
+        ESP_LOGI(TAG, "Chunk rtt min/avg/max %lld/%lld/%lld us, %lu chunks, %lu retransmits, %lu credit stalls",
+                 stats.rttMinUs, stats.rttTotalUs / stats.rttSamples, stats.rttMaxUs,
+                 (unsigned long)stats.chunksSent, (unsigned long)stats.retransmits,
+                 (unsigned long)stats.creditStalls);
+    }
+
+    vTaskDelete(NULL);
+}
+
+otError app_tunnel_bench_start(otInstance *instance, uint32_t totalBytes)
+{
+    if (sBenchRunning) {
+        return OT_ERROR_BUSY;
+    }
+
+    if (!sOpen || !sStats.loopback || totalBytes == 0) {
+        return OT_ERROR_INVALID_STATE;
+    }
+
+    sBenchTotal = totalBytes;
+    sBenchReceived = 0;
+    sBenchRunning = true;
+
+    if (xTaskCreate(tunnel_bench_task, "tunnel_bench", 3072, instance, 4, &sBenchTask) != pdPASS) {
+        sBenchRunning = false;
+        return OT_ERROR_NO_BUFS;
+    }
+
+    return OT_ERROR_NONE;
+}
+
+void app_tunnel_get_stats_locked(app_tunnel_stats_t *outStats)
+{
+    *outStats = sStats;
+    outStats->open = sOpen;
+}
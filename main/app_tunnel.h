@@ -0,0 +1,117 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Tunnel série transparent entre le lien hôte du leader et l'UART d'un enfant
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "app_ingress.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Port UDP du tunnel */
+#define APP_TUNNEL_PORT 12348
+
+/** Fragments en vol au maximum (fenêtre glissante) */
+#define APP_TUNNEL_WINDOW 8
+
+/** Octets utiles par fragment: une trame 802.15.4 par datagramme, saut mesh compris */
+#define APP_TUNNEL_CHUNK_MAX 64
+
+/**
+ * Délai de retransmission: SRTT + 4 x RTTVAR mesurés sur les fragments
+ * (RFC 6298), doublé à chaque expiration. Valeur initiale avant le premier
+ * échantillon, puis bornes. Vers ou depuis un enfant endormi, le plancher
+ * est sa période de sondage: un fragment n'y part qu'au sondage suivant.
+ */
+#define APP_TUNNEL_RTO_INIT_MS 1000
+#define APP_TUNNEL_RTO_MIN_MS  200
+#define APP_TUNNEL_RTO_MAX_MS  8000
+
+/** Mesures du tunnel (depuis la dernière ouverture) */
+typedef struct {
+    bool open;
+    bool loopback;
+    uint16_t peerRloc16;
+    uint32_t bytesSent;
+    uint32_t bytesReceived;
+    uint32_t chunksSent;
+    uint32_t retransmits;
+    uint32_t creditStalls;  // Envoi bloqué: le récepteur n'a plus de place
+    uint32_t rttSamples;
+    int64_t rttMinUs;
+    int64_t rttMaxUs;
+    int64_t rttTotalUs;
+    int64_t srttUs;         // Moyenne lissée, 0 sans échantillon
+    int64_t rtoUs;          // Délai de retransmission courant
+} app_tunnel_stats_t;
+
+/**
+ * @brief Ouvre le socket du tunnel et démarre sa tâche d'émission
+ *
+ * Sur un enfant, l'UART du tunnel (menuconfig) est installée et son flux
+ * est renvoyé vers le leader.
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+void app_tunnel_init_locked(otInstance *instance);
+
+/**
+ * @brief Ouvre le tunnel du leader vers un enfant
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ * @param peerRloc16 RLOC16 de l'enfant
+ * @param hostChannel Lien hôte dont le flux est tunnelé
+ * @param loopback L'enfant renvoie le flux au lieu de l'écrire sur son UART
+ * @return OT_ERROR_NONE si la demande d'ouverture est envoyée
+ */
+otError app_tunnel_open_locked(otInstance *instance, uint16_t peerRloc16, app_ingress_channel_t hostChannel,
+                               bool loopback);
+
+/**
+ * @brief Ferme le tunnel; le lien hôte retrouve le chemin des commandes
+ */
+void app_tunnel_close_locked(void);
+
+/**
+ * @brief Indique si le flux d'un lien hôte part dans le tunnel
+ */
+bool app_tunnel_is_bound(app_ingress_channel_t channel);
+
+/**
+ * @brief Ajoute des octets au flux sortant du tunnel
+ *
+ * Bloque jusqu'à timeoutMs quand le tampon est plein: le contrôle de flux
+ * se propage ainsi jusqu'au lecteur du lien série.
+ *
+ * @return Nombre d'octets acceptés
+ */
+uint16_t app_tunnel_write(const uint8_t *data, uint16_t len, uint32_t timeoutMs);
+
+/**
+ * @brief Lance une mesure de débit et de latence (tunnel ouvert en boucle)
+ *
+ * Pousse totalBytes octets dans le tunnel et attend leur retour; le débit
+ * soutenu, l'aller-retour par fragment et le coût du chemin sont journalisés.
+ *
+ * @return OT_ERROR_NONE si lancée, OT_ERROR_INVALID_STATE sans tunnel en boucle
+ */
+otError app_tunnel_bench_start(otInstance *instance, uint32_t totalBytes);
+
+/**
+ * @brief Copie les mesures du tunnel (verrou OpenThread tenu)
+ */
+void app_tunnel_get_stats_locked(app_tunnel_stats_t *outStats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,297 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Puissance d'émission réglée sur la marge des liens et énergie par commande
+ */
+
+#include "app_txpower.h"
+
+#include <strings.h>
+
+#include "esp_log.h"
+#include "esp_openthread_lock.h"
+#include "esp_timer.h"
+#include "app_cbwatch.h"
+#include "app_lock.h"
+#include "app_pack.h"
+#include "app_settings.h"
+
+#include "openthread/link.h"
+#include "openthread/thread.h"
+#include "openthread/thread_ftd.h"
+#include "openthread/platform/radio.h"
+
+#define TAG "app_txpower"
+
+#define TXPOWER_MODE_KEY "txpower_mode"
+
+// Durée d'un essai d'émission: trame moyenne de 64 octets plus en-tête PHY, à 32 us par octet
+#define TXPOWER_ATTEMPT_US ((64 + 6) * 32)
+
+static const char *const sModeNames[APP_TXPOWER_MODE_COUNT] = {
+    [APP_TXPOWER_MODE_OFF] = "off",
+    [APP_TXPOWER_MODE_ADAPTIVE] = "adaptive",
+};
+
+// 10^(n/10) x 1000, pour n = 0..9
+static const uint16_t sDecibelTable[10] = {1000, 1259, 1585, 1995, 2512, 3162, 3981, 5012, 6310, 7943};
+
+static otInstance *sInstance = NULL;
+static esp_timer_handle_t sPeriodTimer = NULL;
+static app_txpower_mode_t sMode = APP_TXPOWER_MODE_OFF;
+static app_txpower_status_t sStatus;
+static otMacCounters sLastCounters;
+static uint32_t sLastCommands;
+
+// Puissance rayonnée en microwatts (-30 dBm au minimum)
+static uint32_t power_uw(int8_t dbm)
+{
+    int steps = (dbm < -30) ? 0 : dbm + 30;
+    uint32_t value = sDecibelTable[steps % 10];
+
+    for (int i = 0; i < steps / 10; i++) {
+        value *= 10;
+    }
+    return value / 1000;
+}
+
+// Courant d'alimentation de l'amplificateur, en microampères: uW x 1000 / mV, divisé par le rendement
+static uint32_t pa_current_ua(int8_t dbm)
+{
+    return (uint32_t)((uint64_t)power_uw(dbm) * 1000 * 100 / (APP_TXPOWER_SUPPLY_MV * APP_TXPOWER_PA_EFFICIENCY_PCT));
+}
+
+// Énergie d'un essai d'émission à la puissance donnée, en nanojoules
+static uint32_t attempt_energy_nj(int8_t dbm)
+{
+    uint64_t currentUa = APP_TXPOWER_TX_BASE_MA * 1000ULL + pa_current_ua(dbm);
+
+    return (uint32_t)(TXPOWER_ATTEMPT_US * currentUa * APP_TXPOWER_SUPPLY_MV / 1000000ULL);
+}
+
+static void set_power_locked(int8_t dbm)
+{
+    if (dbm == sStatus.powerDbm) {
+        return;
+    }
+
+    if (otPlatRadioSetTransmitPower(sInstance, dbm) != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "Failed to set TX power to %d dBm", dbm);
+        return;
+    }
+    if (dbm < sStatus.powerDbm) {
+        sStatus.stepsDown++;
+    } else {
+        sStatus.stepsUp++;
+    }
+    ESP_LOGI(TAG, "TX power %d -> %d dBm (worst margin %d dB, errors %u/1000)", sStatus.powerDbm, dbm,
+             sStatus.worstMarginDb, sStatus.errorPermille);
+    sStatus.powerDbm = dbm;
+}
+
+/*
+ * Plus faible marge vue sur les liens (parent, routeurs voisins, enfants) et
+ * pire taux d'échec par essai vers l'un d'eux. La marge est mesurée en
+ * réception: elle suppose un lien symétrique, d'où la remontée sur échecs.
+ */
+static void survey_links_locked(uint16_t *outLinks, int16_t *outWorstMarginDb, uint16_t *outWorstErrorPermille)
+{
+    otNeighborInfoIterator iterator = OT_NEIGHBOR_INFO_ITERATOR_INIT;
+    otNeighborInfo neighbor;
+    uint16_t links = 0;
+    int16_t worstMarginDb = -1;
+    uint16_t worstErrorPermille = 0;
+
+    while (otThreadGetNextNeighborInfo(sInstance, &iterator, &neighbor) == OT_ERROR_NONE) {
+        uint16_t errorPermille = (uint16_t)((uint32_t)neighbor.mFrameErrorRate * 1000 / 0xffff);
+
+        if (worstMarginDb < 0 || neighbor.mLinkMargin < worstMarginDb) {
+            worstMarginDb = neighbor.mLinkMargin;
+        }
+        if (errorPermille > worstErrorPermille) {
+            worstErrorPermille = errorPermille;
+        }
+        links++;
+    }
+
+    // Un enfant ne voit pas toujours son parent dans la table des voisins
+    int8_t parentRssi;
+    if (otThreadGetDeviceRole(sInstance) == OT_DEVICE_ROLE_CHILD &&
+        otThreadGetParentAverageRssi(sInstance, &parentRssi) == OT_ERROR_NONE) {
+        int16_t marginDb = parentRssi - otPlatRadioGetReceiveSensitivity(sInstance);
+
+        if (marginDb < 0) {
+            marginDb = 0;
+        }
+        if (worstMarginDb < 0 || marginDb < worstMarginDb) {
+            worstMarginDb = marginDb;
+        }
+        links++;
+    }
+
+    *outLinks = links;
+    *outWorstMarginDb = worstMarginDb;
+    *outWorstErrorPermille = worstErrorPermille;
+}
+
+// Bilan de la période puis un pas de réglage
+static void run_period_locked(void)
+{
+    const otMacCounters *counters = otLinkGetCounters(sInstance);
+    app_pack_stats_t packStats;
+    uint16_t linkErrorPermille;
+
+    app_pack_get_stats(&packStats);
+
+    uint32_t retries = counters->mTxRetry - sLastCounters.mTxRetry;
+    uint32_t expiries = (counters->mTxDirectMaxRetryExpiry - sLastCounters.mTxDirectMaxRetryExpiry) +
+                        (counters->mTxIndirectMaxRetryExpiry - sLastCounters.mTxIndirectMaxRetryExpiry);
+    uint32_t ackedAttempts = (counters->mTxAckRequested - sLastCounters.mTxAckRequested) + retries;
+    uint32_t frames = counters->mTxTotal - sLastCounters.mTxTotal;
+
+    sStatus.txAttempts = frames + retries;
+    sStatus.deliveredFrames = (counters->mTxAcked - sLastCounters.mTxAcked) +
+                              (counters->mTxNoAckRequested - sLastCounters.mTxNoAckRequested);
+    sStatus.commands = packStats.frames - sLastCommands;
+    sStatus.deliveredCommands = sStatus.commands;
+    if (frames > 0 && sStatus.deliveredFrames < frames) {
+        sStatus.deliveredCommands = (uint32_t)((uint64_t)sStatus.commands * sStatus.deliveredFrames / frames);
+    }
+    sStatus.energyUj = (uint32_t)((uint64_t)sStatus.txAttempts * attempt_energy_nj(sStatus.powerDbm) / 1000);
+    sStatus.totalEnergyUj += sStatus.energyUj;
+    sStatus.totalDeliveredFrames += sStatus.deliveredFrames;
+    sStatus.totalDeliveredCommands += sStatus.deliveredCommands;
+    sLastCounters = *counters;
+    sLastCommands = packStats.frames;
+
+    survey_links_locked(&sStatus.links, &sStatus.worstMarginDb, &linkErrorPermille);
+    sStatus.errorPermille = (ackedAttempts > 0) ? (uint16_t)((retries + expiries) * 1000 / ackedAttempts) : 0;
+    if (linkErrorPermille > sStatus.errorPermille) {
+        sStatus.errorPermille = linkErrorPermille;
+    }
+
+    if (sMode != APP_TXPOWER_MODE_ADAPTIVE) {
+        return;
+    }
+
+    int power = sStatus.powerDbm;
+    if (sStatus.links == 0) {
+        // Sans lien (rattachement, partition seule): pleine puissance pour être entendu
+        power = sStatus.maxDbm;
+    } else if (sStatus.errorPermille > APP_TXPOWER_RAISE_ERROR_PERMILLE) {
+        power += 2 * APP_TXPOWER_STEP_DB;
+    } else if (sStatus.worstMarginDb < APP_TXPOWER_TARGET_MARGIN_DB) {
+        power += APP_TXPOWER_STEP_DB;
+    } else if (sStatus.worstMarginDb > APP_TXPOWER_TARGET_MARGIN_DB + APP_TXPOWER_HYSTERESIS_DB) {
+        power -= APP_TXPOWER_STEP_DB;
+    }
+
+    if (power > sStatus.maxDbm) {
+        power = sStatus.maxDbm;
+    }
+    if (power < APP_TXPOWER_MIN_DBM) {
+        power = APP_TXPOWER_MIN_DBM;
+    }
+    set_power_locked((int8_t)power);
+}
+
+static void period_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        return;
+    }
+    uint32_t start = app_cbwatch_begin();
+
+    run_period_locked();
+
+    app_cbwatch_end_locked(APP_CBWATCH_TICK_TXPOWER, start);
+    esp_openthread_lock_release();
+}
+
+void app_txpower_init_locked(otInstance *instance)
+{
+    app_pack_stats_t packStats;
+    uint8_t value;
+    int8_t power;
+
+    if (sPeriodTimer != NULL) {
+        return;
+    }
+
+    sInstance = instance;
+    if (otPlatRadioGetTransmitPower(instance, &power) != OT_ERROR_NONE) {
+        ESP_LOGW(TAG, "TX power not readable, adaptive control disabled");
+        return;
+    }
+    sStatus.powerDbm = power;
+    sStatus.maxDbm = power;
+    sStatus.worstMarginDb = -1;
+    sLastCounters = *otLinkGetCounters(instance);
+    app_pack_get_stats(&packStats);
+    sLastCommands = packStats.frames;
+
+    if (app_settings_get_u8(TXPOWER_MODE_KEY, &value) == ESP_OK && value < APP_TXPOWER_MODE_COUNT) {
+        sMode = (app_txpower_mode_t)value;
+    }
+
+    const esp_timer_create_args_t timerArgs = {
+        .callback = period_timer_cb,
+        .name = "txpower",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&timerArgs, &sPeriodTimer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(sPeriodTimer, APP_TXPOWER_PERIOD_S * 1000000ULL));
+
+    ESP_LOGI(TAG, "TX power mode: %s (configured %d dBm)", sModeNames[sMode], sStatus.maxDbm);
+}
+
+app_txpower_mode_t app_txpower_mode_get(void)
+{
+    return sMode;
+}
+
+esp_err_t app_txpower_mode_set_locked(app_txpower_mode_t mode)
+{
+    if (mode >= APP_TXPOWER_MODE_COUNT) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (sPeriodTimer == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    sMode = mode;
+    if (mode == APP_TXPOWER_MODE_OFF) {
+        set_power_locked(sStatus.maxDbm);
+    }
+
+    // Nouveau bilan: les deux modes se comparent sur des périodes distinctes
+    sStatus.totalEnergyUj = 0;
+    sStatus.totalDeliveredFrames = 0;
+    sStatus.totalDeliveredCommands = 0;
+    return app_settings_set_u8(TXPOWER_MODE_KEY, (uint8_t)mode);
+}
+
+const char *app_txpower_mode_to_string(app_txpower_mode_t mode)
+{
+    return (mode < APP_TXPOWER_MODE_COUNT) ? sModeNames[mode] : "unknown";
+}
+
+bool app_txpower_mode_from_string(const char *name, app_txpower_mode_t *outMode)
+{
+    for (int i = 0; i < APP_TXPOWER_MODE_COUNT; i++) {
+        if (strcasecmp(name, sModeNames[i]) == 0) {
+            *outMode = (app_txpower_mode_t)i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void app_txpower_get_status_locked(app_txpower_status_t *outStatus)
+{
+    *outStatus = sStatus;
+}
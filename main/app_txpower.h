@@ -0,0 +1,121 @@
+/*
+ * SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: CC0-1.0
+ *
+ * Puissance d'émission réglée sur la marge des liens et énergie par commande
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "openthread/instance.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Période de la boucle de réglage */
+#define APP_TXPOWER_PERIOD_S 10
+
+/** Marge visée sur le lien le plus faible, en dB au-dessus du plancher de bruit */
+#define APP_TXPOWER_TARGET_MARGIN_DB 20
+
+/** Marge en plus de la cible avant de baisser la puissance */
+#define APP_TXPOWER_HYSTERESIS_DB 6
+
+/** Pas de réglage (doublé à la remontée sur erreurs) */
+#define APP_TXPOWER_STEP_DB 2
+
+/** Puissance plancher; le plafond est la puissance configurée au démarrage */
+#define APP_TXPOWER_MIN_DBM (-16)
+
+/** Taux d'échec par essai (‰) qui fait remonter la puissance */
+#define APP_TXPOWER_RAISE_ERROR_PERMILLE 100
+
+/**
+ * Modèle de consommation en émission: courant fixe de la radio, plus le
+ * courant que l'amplificateur tire de l'alimentation pour la puissance
+ * rayonnée, P / (Vdd x rendement). Sert à comparer les réglages, pas à
+ * remplacer une mesure.
+ */
+#define APP_TXPOWER_TX_BASE_MA 16
+#define APP_TXPOWER_SUPPLY_MV 3300
+#define APP_TXPOWER_PA_EFFICIENCY_PCT 30
+
+/**
+ * @brief Modes de réglage
+ *
+ * - OFF:      puissance configurée pour tous les envois
+ * - ADAPTIVE: baisse tant que la marge reste au-dessus de la cible, remonte
+ *             sous la cible ou quand les échecs par essai augmentent
+ */
+typedef enum {
+    APP_TXPOWER_MODE_OFF = 0,
+    APP_TXPOWER_MODE_ADAPTIVE,
+    APP_TXPOWER_MODE_COUNT,
+} app_txpower_mode_t;
+
+/** État de la boucle et bilan énergétique (depuis le dernier changement de mode) */
+typedef struct {
+    int8_t powerDbm;
+    int8_t maxDbm;               // Puissance configurée au démarrage
+    uint16_t links;              // Parent, voisins routeurs et enfants
+    int16_t worstMarginDb;       // -1 sans lien
+    uint16_t errorPermille;      // Échecs par essai de la dernière période
+    uint32_t stepsDown;
+    uint32_t stepsUp;
+    // Dernière période
+    uint32_t txAttempts;
+    uint32_t deliveredFrames;    // Trames acquittées ou diffusées
+    uint32_t commands;           // Commandes applicatives envoyées
+    uint32_t deliveredCommands;  // Au prorata des trames délivrées
+    uint32_t energyUj;           // Énergie d'émission estimée, tout trafic compris
+    // Cumul depuis le dernier changement de mode
+    uint64_t totalEnergyUj;
+    uint32_t totalDeliveredFrames;
+    uint32_t totalDeliveredCommands;
+} app_txpower_status_t;
+
+/**
+ * @brief Lit le mode enregistré et démarre la boucle de réglage
+ *
+ * @param instance Instance OpenThread (verrou OpenThread tenu)
+ */
+void app_txpower_init_locked(otInstance *instance);
+
+/**
+ * @brief Retourne le mode courant
+ */
+app_txpower_mode_t app_txpower_mode_get(void);
+
+/**
+ * @brief Change le mode, l'enregistre en NVS et remet le bilan à zéro (verrou OpenThread tenu)
+ *
+ * Le mode OFF rétablit la puissance configurée.
+ */
+esp_err_t app_txpower_mode_set_locked(app_txpower_mode_t mode);
+
+/**
+ * @brief Retourne le nom d'un mode ("off", "adaptive")
+ */
+const char *app_txpower_mode_to_string(app_txpower_mode_t mode);
+
+/**
+ * @brief Convertit un nom de mode
+ *
+ * @return true si le nom est reconnu, false sinon
+ */
+bool app_txpower_mode_from_string(const char *name, app_txpower_mode_t *outMode);
+
+/**
+ * @brief Copie l'état de la boucle (verrou OpenThread tenu)
+ */
+void app_txpower_get_status_locked(app_txpower_status_t *outStatus);
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,10 +23,41 @@
 #include "esp_openthread_lock.h"
 #include "esp_openthread_types.h"
 #include "esp_openthread_netif_glue.h"
+#include "esp_system.h"
+#include "esp_timer.h"
 #include "esp_ot_config.h"
 #include "esp_vfs_eventfd.h"
 #include "nvs_flash.h"
 
+#include "app_actuator.h"
+#include "app_addr.h"
+#include "app_airtime.h"
+#include "app_attach.h"
+#include "app_cbwatch.h"
+#include "app_coalesce.h"
+#include "app_coex.h"
+#include "app_discovery.h"
+#include "app_failover.h"
+#include "app_ingress.h"
+#include "app_load.h"
+#include "app_lock.h"
+#include "app_netdiag.h"
+#include "app_pack.h"
+#include "app_probe.h"
+#include "app_registry.h"
+#include "app_retry.h"
+#include "app_role.h"
+#include "app_sched.h"
+#include "app_sniffer.h"
+#include "app_status.h"
+#include "app_supervision.h"
+#include "app_tunnel.h"
+#include "app_txpower.h"
+
+#if CONFIG_OPENTHREAD_CLI
+#include "app_cli.h"
+#endif
+
 #include "openthread/thread.h"
 #include "openthread/thread_ftd.h"
 #include "openthread/instance.h"
@@ -35,7 +66,6 @@
 #include "openthread/dataset_ftd.h"
 
 #include "driver/gpio.h"
-#include "driver/uart.h"
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
@@ -53,18 +83,16 @@
 #define TAG "ot_esp_cli"
 #define LED_GPIO 10
 
-#define UART_NUM        UART_NUM_0
-#define UART_TX_PIN     16
-#define UART_RX_PIN     17
-#define UART_BUF_SIZE   1024
 #define CONTROL_PIN_1 7
 #define CONTROL_PIN_2 8
 #define CONTROL_PIN_3 9
+#define CONTROL_PINS_TXT "7,8,9"  // Publié en TXT par la découverte de services
 
 
 #define UDP_PORT        12345
-#define CHILD_TIMEOUT_S 60
-#define SEND_PERIOD_MS  5000
+#define STANDBY_ROUTER_JITTER_S 2
+#define TUNNEL_HOST_WRITE_TIMEOUT_MS 1000
+#define LED_PULSE_MS 3000  // Impulsion verte de la commande 0x00
 
 
 
@@ -78,6 +106,11 @@ static otIp6Address sChildAddr;
 static bool sChildAddrSet = false;
 static bool sLedCommandReceived = false;
 static uint8_t sCurrentLedColor = 0x42;  // 'B'
+static uint8_t sPinLevels = 0;  // Bit n: niveau de CONTROL_PIN_(n+1), persisté par app_actuator
+
+static const gpio_num_t sControlPins[] = {CONTROL_PIN_1, CONTROL_PIN_2, CONTROL_PIN_3};
+static esp_timer_handle_t sLedPulseTimer = NULL;
+static bool sLedPulseActive = false;  // La couleur appartient encore à l'impulsion 0x00
 
 // Tâche de test pour faire clignoter les LED en rouge, vert et bleu
 static void check_uart_and_control_pin(const uint8_t *data, int len)
@@ -140,78 +173,150 @@ static bool init_udp_socket_locked(otInstance *instance)
     ESP_LOGI(TAG, "UDP send socket initialized on port %d", UDP_PORT);
     return true;
 }
-// Fonction de rappel pour la réception de messages UDP
-static void handle_udp_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+/**
+ * @brief Pilote une broche de contrôle et retient son niveau pour la persistance
+ *
+ * @param index Index de la broche dans sControlPins
+ * @param level Niveau à appliquer (0 ou 1)
+ */
+static void set_control_pin(int index, uint32_t level)
 {
-    (void)aContext;
-    (void)aMessageInfo;
+    gpio_set_level(sControlPins[index], level);
+    if (level) {
+        sPinLevels |= (uint8_t)(1u << index);
+    } else {
+        sPinLevels &= (uint8_t)~(1u << index);
+    }
+}
 
-    uint16_t length = otMessageGetLength(aMessage);
+/**
+ * @brief Signale l'état des actionneurs (écriture NVS différée et regroupée par app_actuator)
+ */
+static void save_actuator_state(void)
+{
+    const app_actuator_state_t state = {
+        .pinLevels = sPinLevels,
+        .ledColor = sCurrentLedColor,
+    };
+    app_actuator_update(&state);
+}
 
-    if (length == 0 || length > 256) {
-        ESP_LOGW(TAG, "Received UDP message with invalid length: %u", length);
+// Fin de l'impulsion de la commande 0x00, hors de la tâche OpenThread
+static void led_pulse_timer_cb(void *arg)
+{
+    (void)arg;
+
+    if (!esp_openthread_lock_acquire(pdMS_TO_TICKS(APP_LOCK_WAIT_MS))) {
+        esp_timer_start_once(sLedPulseTimer, APP_LOCK_WAIT_MS * 1000);
         return;
     }
 
-    uint8_t data[256] = {0};
-    uint16_t bytesRead = otMessageRead(aMessage, 0, data, length);
-
-    if (bytesRead != length) {
-        ESP_LOGE(TAG, "Partial UDP read: expected %u, got %u", length, bytesRead);
-        return;
+    // Une commande de couleur reçue pendant l'impulsion l'a remplacée: ne pas l'effacer
+    if (sLedPulseActive) {
+        sLedPulseActive = false;
+        sCurrentLedColor = 0x00;
+        save_actuator_state();
     }
+    esp_openthread_lock_release();
+}
 
-    ESP_LOGI(TAG, "Received UDP data: 0x%02X", data[0]);
-    if (data[0] == 0x00) {
-   // gpio_set_level(CONTROL_PIN_1, 1);
-    sCurrentLedColor = 0x47;
-    vTaskDelay(pdMS_TO_TICKS(3000));
-    sCurrentLedColor = 0x00;
-    //ESP_LOGI(TAG, "0x00 -> GPIO %d HIGH", CONTROL_PIN_1);
+// Une couleur explicite remplace l'impulsion en cours (verrou OpenThread tenu)
+static void set_led_color(uint8_t color)
+{
+    sLedPulseActive = false;
+    esp_timer_stop(sLedPulseTimer);
+    sCurrentLedColor = color;
+    sLedCommandReceived = true;
+}
 
-    } else if (data[0] == 0x01) {
-        gpio_set_level(CONTROL_PIN_1, 0);
+/**
+ * @brief Applique une commande reçue du leader (broches de contrôle ou LED)
+ *
+ * @param opcode Octet de commande
+ */
+static void apply_command(uint8_t opcode)
+{
+    ESP_LOGI(TAG, "Received UDP data: 0x%02X", opcode);
+    if (opcode == 0x00) {
+        // Impulsion verte terminée par un timer: un vTaskDelay ici bloquerait la tâche OpenThread
+        sCurrentLedColor = 0x47;
+        sLedPulseActive = true;
+        esp_timer_stop(sLedPulseTimer);
+        esp_timer_start_once(sLedPulseTimer, LED_PULSE_MS * 1000);
+        ESP_LOGI(TAG, "0x00 -> LED green for %d ms", LED_PULSE_MS);
+
+    } else if (opcode == 0x01) {
+        set_control_pin(0, 0);
         ESP_LOGI(TAG, "0x01 -> GPIO %d LOW", CONTROL_PIN_1);
 
-    } else if (data[0] == 0x02) {
-        gpio_set_level(CONTROL_PIN_2, 1);
+    } else if (opcode == 0x02) {
+        set_control_pin(1, 1);
         ESP_LOGI(TAG, "0x02 -> GPIO %d HIGH", CONTROL_PIN_2);
 
-    } else if (data[0] == 0x03) {
-        gpio_set_level(CONTROL_PIN_2, 0);
+    } else if (opcode == 0x03) {
+        set_control_pin(1, 0);
         ESP_LOGI(TAG, "0x03 -> GPIO %d LOW", CONTROL_PIN_2);
 
-    } else if (data[0] == 0x04) {
-        gpio_set_level(CONTROL_PIN_3, 1);
+    } else if (opcode == 0x04) {
+        set_control_pin(2, 1);
         ESP_LOGI(TAG, "0x04 -> GPIO %d HIGH", CONTROL_PIN_3);
 
-    } else if (data[0] == 0x05) {
-        gpio_set_level(CONTROL_PIN_3, 0);
+    } else if (opcode == 0x05) {
+        set_control_pin(2, 0);
         ESP_LOGI(TAG, "0x05 -> GPIO %d LOW", CONTROL_PIN_3);
 
     } 
     // 🔵 LED BLEU
-    else if (data[0] == 0x42) {
-        sCurrentLedColor = 0x42;
-        sLedCommandReceived = true;
+    else if (opcode == 0x42) {
+        set_led_color(0x42);
         ESP_LOGI(TAG, "LED color changed to BLUE");
 
     } 
     // 🟢 LED VERT
-    else if (data[0] == 0x47) {
-        sCurrentLedColor = 0x47;
-        sLedCommandReceived = true;
+    else if (opcode == 0x47) {
+        set_led_color(0x47);
         ESP_LOGI(TAG, "LED color changed to GREEN");
 
     } 
     // 🔴 LED ROUGE
-    else if (data[0] == 0x46) {
-        sCurrentLedColor = 0x46;
-        sLedCommandReceived = true;
+    else if (opcode == 0x46) {
+        set_led_color(0x46);
         ESP_LOGI(TAG, "LED color changed to RED");
 
     } else {
-        ESP_LOGW(TAG, "Unknown command: 0x%02X", data[0]);
+        ESP_LOGW(TAG, "Unknown command: 0x%02X", opcode);
+        return;
+    }
+
+    save_actuator_state();
+}
+
+// Fonction de rappel pour la réception de messages UDP
+static void handle_udp_receive(void *aContext, otMessage *aMessage, const otMessageInfo *aMessageInfo)
+{
+    (void)aContext;
+    (void)aMessageInfo;
+
+    uint16_t length = otMessageGetLength(aMessage);
+
+    if (length == 0 || length > 256) {
+        ESP_LOGW(TAG, "Received UDP message with invalid length: %u", length);
+        return;
+    }
+
+    uint8_t data[256] = {0};
+    uint16_t bytesRead = otMessageRead(aMessage, 0, data, length);
+
+    if (bytesRead != length) {
+        ESP_LOGE(TAG, "Partial UDP read: expected %u, got %u", length, bytesRead);
+        return;
+    }
+
+    // Un datagramme peut regrouper plusieurs commandes (app_pack)
+    uint16_t offset = 0;
+    while (offset < length) {
+        apply_command(data[offset]);
+        offset += app_pack_frame_len(&data[offset], length - offset);
     }
 }
 // Fonction pour initialiser le socket de réception UDP
@@ -221,7 +326,8 @@ static bool init_receive_socket_locked(otInstance *instance)
         return true;
     }
 
-    otError error = otUdpOpen(instance, &sReceiveSocket, handle_udp_receive, NULL);
+    otError error =
+        app_cbwatch_udp_open_locked(instance, &sReceiveSocket, handle_udp_receive, NULL, APP_CBWATCH_UDP_COMMAND);
     if (error != OT_ERROR_NONE) {
         ESP_LOGE(TAG, "Failed to open receive UDP socket: %d", error);
         return false;
@@ -264,7 +370,8 @@ static bool is_role_ready_to_send_locked(otInstance *instance)
  *
  * Cette fonction parcourt tous les appareils enfants connectés au réseau Thread
  * et retourne l'adresse IPv6 du premier enfant trouvé. Elle est utilisée pour
- * établir la communication UDP entre le parent et l'enfant.
+ * établir la communication UDP entre le parent et l'enfant. L'adresse retenue
+ * est la plus compressible (RLOC de l'enfant direct plutôt que son ML-EID).
  *
  * @param instance Instance OpenThread pour accéder aux informations des enfants
  * @param outAddr Pointeur vers la structure où stocker l'adresse découverte
@@ -282,12 +389,24 @@ static bool discover_first_child_address_locked(otInstance *instance, otIp6Addre
         ESP_LOGI(TAG, "Found child %u with RLOC16: 0x%04x, timeout: %u s",
                  childIndex, childInfo.mRloc16, childInfo.mTimeout);
 
+        // Adresse stable de l'enfant: son ML-EID de préférence, sinon la première enregistrée
+        otIp6Address stableAddr;
+        bool found = false;
         while (otThreadGetChildNextIp6Address(instance, childIndex, &iterator, &candidate) == OT_ERROR_NONE) {
             char addrStr[OT_IP6_ADDRESS_STRING_SIZE];
             otIp6AddressToString(&candidate, addrStr, sizeof(addrStr));
             ESP_LOGI(TAG, "Child %u IPv6 address: %s", childIndex, addrStr);
 
-            *outAddr = candidate;
+            if (!found || app_addr_form_locked(instance, &candidate) == APP_ADDR_FORM_ML_EID) {
+                stableAddr = candidate;
+                found = true;
+            }
+        }
+
+        if (found) {
+            uint8_t saved = app_addr_select_locked(instance, childInfo.mRloc16, &stableAddr, outAddr);
+            ESP_LOGI(TAG, "Child %u reached by %s address, %u header bytes saved per frame", childIndex,
+                     app_addr_form_name(app_addr_form_locked(instance, outAddr)), saved);
             return true;
         }
 
@@ -302,7 +421,8 @@ static bool discover_first_child_address_locked(otInstance *instance, otIp6Addre
  *
  * Cette fonction vérifie si l'adresse IPv6 d'un enfant est toujours présente
  * dans la liste des adresses des enfants connectés. Cela permet de détecter
- * si un enfant s'est déconnecté du réseau.
+ * si un enfant s'est déconnecté du réseau. Une RLOC reste valide tant que
+ * l'enfant de même RLOC16 est dans la table des enfants.
  *
  * @param instance Instance OpenThread pour vérifier les enfants
  * @param addrToCheck Adresse IPv6 à vérifier
@@ -312,11 +432,17 @@ static bool child_address_still_valid_locked(otInstance *instance, const otIp6Ad
 {
     otChildInfo childInfo;
     uint16_t childIndex = 0;
+    uint16_t rloc16;
+    bool isRloc = app_addr_get_rloc16_locked(instance, addrToCheck, &rloc16);
 
     while (otThreadGetChildInfoByIndex(instance, childIndex, &childInfo) == OT_ERROR_NONE) {
         otChildIp6AddressIterator iterator = OT_CHILD_IP6_ADDRESS_ITERATOR_INIT;
         otIp6Address checkAddr;
 
+        if (isRloc && childInfo.mRloc16 == rloc16) {
+            return true;
+        }
+
         while (otThreadGetChildNextIp6Address(instance, childIndex, &iterator, &checkAddr) == OT_ERROR_NONE) {
             if (memcmp(addrToCheck, &checkAddr, sizeof(otIp6Address)) == 0) {
                 return true;
@@ -360,12 +486,103 @@ static bool ensure_child_address_locked(otInstance *instance)
     return false;
 }
 
+/**
+ * @brief Envoie un datagramme UDP de commandes
+ *
+ * @param instance Instance OpenThread pour l'envoi réseau
+ * @param dst Adresse de destination
+ * @param data Pointeur vers les données à envoyer
+ * @param len Longueur des données en octets
+ * @return true si l'envoi réussit, false en cas d'erreur
+ */
+static bool send_datagram_locked(otInstance *instance, const otIp6Address *dst, const uint8_t *data, uint16_t len)
+{
+    otMessage *message = otUdpNewMessage(instance, NULL);
+    if (message == NULL) {
+        ESP_LOGE(TAG, "Failed to create UDP message");
+        return false;
+    }
+
+    otError error = otMessageAppend(message, data, len);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to append data: %d", error);
+        otMessageFree(message);
+        return false;
+    }
+
+    otMessageInfo messageInfo;
+    memset(&messageInfo, 0, sizeof(messageInfo));
+    messageInfo.mPeerAddr = *dst;
+    messageInfo.mPeerPort = UDP_PORT;
+    messageInfo.mSockPort = UDP_PORT;
+
+    error = otUdpSend(instance, &sUdpSocket, message, &messageInfo);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to send UDP message: %d", error);
+        otMessageFree(message);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Envoie des commandes en datagrammes d'une seule trame 802.15.4
+ *
+ * @param instance Instance OpenThread pour l'envoi réseau
+ * @param dst Adresse de destination
+ * @param multiHop true si la destination n'est pas un voisin direct
+ * @param data Commandes à envoyer
+ * @param len Longueur des commandes en octets
+ * @return true si tous les datagrammes sont partis, false sinon
+ */
+static bool send_packed_now_locked(otInstance *instance, const otIp6Address *dst, bool multiHop, const uint8_t *data,
+                                   uint16_t len)
+{
+    uint16_t budget = app_pack_budget_locked(instance, dst, UDP_PORT, UDP_PORT, multiHop);
+
+    // Commande de l'hôte: priorité radio haute face au Wi-Fi le temps de l'envoi
+    app_coex_control_begin();
+
+    // Un datagramme par trame 802.15.4: jamais de fragmentation 6LoWPAN pour des commandes entières
+    uint16_t offset = 0;
+    while (offset < len) {
+        uint16_t chunk = app_pack_next(&data[offset], len - offset, budget);
+
+        if (!send_datagram_locked(instance, dst, &data[offset], chunk)) {
+            return false;
+        }
+
+        app_pack_note_sent(&data[offset], chunk, budget);
+        app_airtime_note_commands_locked(&data[offset], chunk, budget);
+        offset += chunk;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Envoie des commandes par la file d'envoi applicative
+ *
+ * Tant que la radio n'a pas vidé les envois précédents, ou qu'un enfant
+ * endormi n'a pas sondé, les commandes en attente pour un même actionneur
+ * sont remplacées par les plus récentes (app_coalesce).
+ *
+ * @return true si les commandes sont parties ou retenues, false sinon
+ */
+static bool send_packed_locked(otInstance *instance, const otIp6Address *dst, bool multiHop, const uint8_t *data,
+                               uint16_t len)
+{
+    return app_coalesce_submit_locked(instance, dst, multiHop, data, len);
+}
+
 /**
  * @brief Envoie des données UDP à l'appareil enfant
  *
  * Cette fonction envoie un message UDP à l'appareil enfant dont l'adresse
  * a été découverte précédemment. Elle gère l'initialisation du socket UDP,
  * la validation de l'adresse de destination et l'envoi effectif des données.
+ * Les commandes sont regroupées en datagrammes tenant chacun dans une trame.
  *
  * @param instance Instance OpenThread pour l'envoi réseau
  * @param data Pointeur vers les données à envoyer
@@ -391,33 +608,57 @@ static bool send_to_child_locked(otInstance *instance, const uint8_t *data, uint
     otIp6AddressToString(&sChildAddr, addrStr, sizeof(addrStr));
     ESP_LOGI(TAG, "Sending to child address: %s", addrStr);
 
-    otMessage *message = otUdpNewMessage(instance, NULL);
-    if (message == NULL) {
-        ESP_LOGE(TAG, "Failed to create UDP message");
+    // L'enfant est un voisin direct: pas d'en-tête mesh
+    if (!send_packed_locked(instance, &sChildAddr, false, data, len)) {
         return false;
     }
 
-    otError error = otMessageAppend(message, data, len);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "Failed to append data: %d", error);
-        otMessageFree(message);
+    ESP_LOGI(TAG, "Data sent to child (%u bytes)", len);
+    return true;
+}
+
+/**
+ * @brief Envoie les commandes d'une trame adressée à l'appareil désigné par son ID
+ *
+ * L'ID logique est résolu dans le registre du nœud du lien hôte. Un enfant direct est
+ * joint par sa RLOC, tout autre appareil par son ML-EID: le cache EID de
+ * OpenThread fournit alors la route vers son parent.
+ *
+ * @param instance Instance OpenThread pour l'envoi réseau
+ * @param data Trame adressée (APP_REGISTRY_OPCODE, ID, commandes)
+ * @param len Longueur de la trame en octets
+ * @return true si l'envoi réussit, false en cas d'erreur
+ */
+static bool send_to_device_locked(otInstance *instance, const uint8_t *data, uint16_t len)
+{
+    app_registry_entry_t entry;
+    otIp6Address dst;
+
+    if (len <= APP_REGISTRY_HEADER_LEN) {
+        ESP_LOGW(TAG, "Addressed frame without command");
         return false;
     }
 
-    otMessageInfo messageInfo;
-    memset(&messageInfo, 0, sizeof(messageInfo));
-    messageInfo.mPeerAddr = sChildAddr;
-    messageInfo.mPeerPort = UDP_PORT;
-    messageInfo.mSockPort = UDP_PORT;
+    if (!is_role_ready_to_send_locked(instance) || !init_udp_socket_locked(instance)) {
+        ESP_LOGW(TAG, "Leader/router not ready to send");
+        return false;
+    }
 
-    error = otUdpSend(instance, &sUdpSocket, message, &messageInfo);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "Failed to send UDP message: %d", error);
-        otMessageFree(message);
+    uint16_t id = app_registry_frame_id(data);
+    if (!app_registry_lookup_locked(id, &entry)) {
+        ESP_LOGW(TAG, "Device ID %u not registered or not located since boot", id);
         return false;
     }
 
-    ESP_LOGI(TAG, "Data sent to child (%u bytes)", len);
+    app_addr_select_locked(instance, entry.rloc16, &entry.address, &dst);
+    bool multiHop = (app_addr_form_locked(instance, &dst) != APP_ADDR_FORM_RLOC);
+
+    uint16_t commandsLen = len - APP_REGISTRY_HEADER_LEN;
+    if (!send_packed_locked(instance, &dst, multiHop, &data[APP_REGISTRY_HEADER_LEN], commandsLen)) {
+        return false;
+    }
+
+    ESP_LOGI(TAG, "Data sent to device ID %u (0x%04x, %u bytes)", id, entry.rloc16, commandsLen);
     return true;
 }
 
@@ -470,20 +711,20 @@ static void led_blink_task(void *pvParameters)
         esp_openthread_lock_release();
 
         // Logging périodique du rôle (différent selon le type d'appareil)
-#ifdef CONFIG_DEVICE_TYPE_END_DEVICE
-        // Pour les end devices: log toutes les 50 itérations
-        static uint32_t log_counter = 0;
-        if ((log_counter++ % 50) == 0) {
-            ESP_LOGI(TAG, "Device role: %d (0=disabled, 1=detached, 2=child, 3=router, 4=leader)", role);
-        }
-#else
-        // Pour les autres appareils: log une fois devenu leader
-        static bool role_printed = false;
-        if (!role_printed && role == OT_DEVICE_ROLE_LEADER) {
-            ESP_LOGI(TAG, "Device role: %d (leader)", role);
-            role_printed = true;
+        if (app_node_role_get() == APP_NODE_ROLE_END_DEVICE) {
+            // Pour les end devices: log toutes les 50 itérations
+            static uint32_t log_counter = 0;
+            if ((log_counter++ % 50) == 0) {
+                ESP_LOGI(TAG, "Device role: %d (0=disabled, 1=detached, 2=child, 3=router, 4=leader)", role);
+            }
+        } else {
+            // Pour les autres appareils: log une fois devenu leader
+            static bool role_printed = false;
+            if (!role_printed && role == OT_DEVICE_ROLE_LEADER) {
+                ESP_LOGI(TAG, "Device role: %d (leader)", role);
+                role_printed = true;
+            }
         }
-#endif
 
         // Contrôle LED selon le rôle réseau
         if (role == OT_DEVICE_ROLE_LEADER || role == OT_DEVICE_ROLE_ROUTER) {
@@ -526,143 +767,130 @@ static void led_blink_task(void *pvParameters)
 }
 
 /**
- * @brief Tâche de lecture UART pour débogage et contrôle
- *
- * Cette tâche FreeRTOS lit en continu les données reçues sur l'interface UART
- * et les traite pour le débogage et le contrôle des broches GPIO. Elle permet
- * de recevoir des commandes via le port série et de les retransmettre.
+ * @brief Relaie une trame de l'hôte vers sa destination (verrou OpenThread tenu)
  *
- * La tâche:
- * - Alloue un buffer pour les données UART
- * - Lit les données avec un timeout de 2 secondes
- * - Affiche les données reçues en hexadécimal
- * - Traite les données via check_uart_and_control_pin()
- * - Retransmet les données sur UART (echo)
- *
- * @param pvParameters Paramètres de la tâche (non utilisés)
+ * Trame adressée par ID logique: tout appareil du maillage; sinon, le premier enfant.
  */
-static void uart_read_task(void *pvParameters)
+static bool forward_host_frame_locked(const uint8_t *data, uint16_t len)
 {
-    otInstance *instance = (otInstance *)pvParameters;
+    otInstance *instance = esp_openthread_get_instance();
 
-    // Allocation du buffer UART
-    uint8_t *data = (uint8_t *)malloc(UART_BUF_SIZE);
-    if (data == NULL) {
-        ESP_LOGE(TAG, "Failed to allocate UART buffer");
-        vTaskDelete(NULL);
-        return;
-    }
+    return app_registry_is_routed_frame(data, len) ? send_to_device_locked(instance, data, len)
+                                                   : send_to_child_locked(instance, data, len);
+}
 
-    // Boucle de lecture UART
-    while (1) {
-        // Lecture des données UART avec timeout
-        int len = uart_read_bytes(UART_NUM, data, UART_BUF_SIZE, pdMS_TO_TICKS(2000));
-        if (len > 0) {
-            ESP_LOGI(TAG, "UART received %d bytes:", len);
-            ESP_LOG_BUFFER_HEX(TAG, data, len);
-
-            // Traitement des données reçues
-            check_uart_and_control_pin(data, len);
-                        // 🔥 ENVOI UDP DIRECT
-            esp_openthread_lock_acquire(portMAX_DELAY);
-            bool ok = send_to_child_locked(instance, data, len);
-            esp_openthread_lock_release();
+/**
+ * @brief Relaie une trame de l'hôte vers l'enfant, verrou OpenThread acquis ici
+ *
+ * Une trame adressée (APP_REGISTRY_OPCODE) part vers l'appareil de cet ID.
+ *
+ * @param data Trame reçue de l'hôte
+ * @param len Longueur en octets
+ * @return true si l'envoi réussit, false sinon
+ */
+static bool forward_host_frame(const uint8_t *data, uint16_t len)
+{
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    bool ok = forward_host_frame_locked(data, len);
+    esp_openthread_lock_release();
 
-            if (ok) {
-                ESP_LOGI(TAG, "UDP sent from UART (%d bytes)", len);
-            } else {
-                ESP_LOGW(TAG, "UDP send failed");
-            }
-            // Echo des données sur UART
-            uart_write_bytes(UART_NUM, (const char *)data, len);
-        } else {
-            ESP_LOGI(TAG, "UART: Waiting for data on GPIO%d...", UART_RX_PIN);
-        }
-    }
+    return ok;
 }
 
+/**
+ * @brief Envoie une trame planifiée (app_sched), verrou OpenThread tenu
+ *
+ * Seul le nœud qui tient le lien hôte envoie: un nœud de secours garde ses
+ * planifications pour le jour où il prend la main.
+ */
+static bool send_scheduled_frame_locked(const uint8_t *data, uint16_t len)
+{
+    if (!app_failover_is_active()) {
+        return true;
+    }
 
+    return forward_host_frame_locked(data, len);
+}
 
 /**
- * @brief Tâche d'exemple d'envoi périodique de données aux enfants
+ * @brief Traite une trame reçue sur l'un des liens hôte
  *
- * Cette tâche démontre l'envoi automatique de commandes de couleur aux appareils
- * enfants toutes les SEND_PERIOD_MS millisecondes. Elle alterne entre l'envoi
- * de la commande bleue (0x42) et verte (0x47).
+ * Appelée par la tâche de répartition des liens hôte (app_ingress), dans
+ * l'ordre équitable entre canaux. Relaie la trame vers l'enfant puis la
+ * renvoie en écho sur le lien d'origine.
  *
- * La tâche:
- * - Attend 5 secondes au démarrage pour laisser le réseau s'initialiser
- * - Envoie alternativement les commandes de couleur bleu/vert
- * - Utilise le verrou OpenThread pour la sécurité des threads
- * - Log les succès/échecs d'envoi
- *
- * @param pvParameters Instance OpenThread passée en paramètre
+ * @param channel Lien hôte d'origine
+ * @param data Trame reçue
+ * @param len Longueur en octets
  */
-/*static void send_data_example_task(void *pvParameters)
+static void handle_host_frame(app_ingress_channel_t channel, const uint8_t *data, uint16_t len)
 {
-    otInstance *instance = (otInstance *)pvParameters;
-    bool blue_color = true;
+    const char *link = app_ingress_channel_name(channel);
 
-    // Attendre que le réseau Thread soit prêt
-    vTaskDelay(pdMS_TO_TICKS(5000));
+    ESP_LOGI(TAG, "%s received %u bytes:", link, len);
+    ESP_LOG_BUFFER_HEX(TAG, data, len);
 
-    // Boucle d'envoi périodique
-    while (1) {
-        // Préparer la commande de couleur (alternance bleu/vert)
-        uint8_t color_command = blue_color ? 0x42 : 0x47;
+    // Lien tunnelé: flux transparent vers l'enfant, aucun octet n'est interprété
+    if (app_tunnel_is_bound(channel)) {
+        if (app_tunnel_write(data, len, TUNNEL_HOST_WRITE_TIMEOUT_MS) < len) {
+            ESP_LOGW(TAG, "Tunnel full, %s bytes dropped", link);
+        }
+        return;
+    }
 
-        // Envoi avec verrouillage thread-safe
-        esp_openthread_lock_acquire(portMAX_DELAY);
-        bool ok = send_to_child_locked(instance, &color_command, 1);
-        esp_openthread_lock_release();
+    // Demande d'état: réponse binaire locale, jamais relayée ni rejouée
+    if (app_status_is_request(data, len)) {
+        if (app_failover_is_active()) {
+            uint8_t status[APP_STATUS_FRAME_LEN];
+            esp_openthread_lock_acquire(portMAX_DELAY);
+            uint16_t statusLen = app_status_build_locked(esp_openthread_get_instance(), status);
+            esp_openthread_lock_release();
+            app_ingress_write(channel, status, statusLen);
+        }
+        return;
+    }
 
-        if (ok) {
-            ESP_LOGI(TAG, "Sent color command: %c (%s)",
-                     color_command, blue_color ? "BLUE" : "GREEN");
-            blue_color = !blue_color;  // Alterner la couleur pour le prochain envoi
-        } else {
-            ESP_LOGW(TAG, "Send skipped or failed");
+    // Abonnement au flux de topologie: servi par le nœud actif, sur le lien qui le demande
+    if (app_netdiag_is_request(data, len)) {
+        if (app_failover_is_active()) {
+            esp_openthread_lock_acquire(portMAX_DELAY);
+            app_netdiag_handle_request_locked(channel, data);
+            esp_openthread_lock_release();
         }
+        return;
+    }
+
+    // Nœud de secours: conserver le bloc sans le relayer ni répondre à l'hôte
+    if (!app_failover_is_active()) {
+        app_failover_hold(channel, data, len);
+        return;
+    }
+
+    // Traitement des données reçues
+    check_uart_and_control_pin(data, len);
 
-        // Attendre avant le prochain envoi
-        vTaskDelay(pdMS_TO_TICKS(SEND_PERIOD_MS));
+    if (forward_host_frame(data, len)) {
+        app_failover_note_forwarded();
+        ESP_LOGI(TAG, "UDP sent from %s (%u bytes)", link, len);
+    } else {
+        ESP_LOGW(TAG, "UDP send failed");
     }
-}*/
+
+    // Echo des données sur le lien d'origine
+    app_ingress_write(channel, data, len);
+}
 
 /**
- * @brief Configure l'UART et les GPIO pour le débogage et le contrôle
- *
- * Cette fonction initialise l'interface UART pour la communication série
- * et configure une broche GPIO en sortie pour le contrôle matériel.
- * L'UART est configuré à 115200 bauds avec 8 bits de données, pas de parité.
+ * @brief Configure les broches GPIO de contrôle
  *
- * Configuration UART:
- * - Baud rate: 115200
- * - Data bits: 8
- * - Parity: None
- * - Stop bits: 1
- * - Flow control: None
+ * Les liens hôte (UART0, UART1, USB Serial/JTAG) sont configurés par
+ * app_ingress_start().
  *
  * Configuration GPIO:
- * - Broche CONTROL_PIN en mode sortie
+ * - Broches CONTROL_PIN_1..3 en mode sortie
  */
-static void configure_uart_and_gpio(void)
-{
-    // Configuration UART
-    uart_config_t uart_config = {
-        .baud_rate = 115200,
-        .data_bits = UART_DATA_8_BITS,
-        .parity = UART_PARITY_DISABLE,
-        .stop_bits = UART_STOP_BITS_1,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .source_clk = UART_SCLK_DEFAULT,
-    };
-
-    // Installation et configuration du driver UART
-    ESP_ERROR_CHECK(uart_driver_install(UART_NUM, UART_BUF_SIZE * 2, 0, 0, NULL, 0));
-    ESP_ERROR_CHECK(uart_param_config(UART_NUM, &uart_config));
-    ESP_ERROR_CHECK(uart_set_pin(UART_NUM, UART_TX_PIN, UART_RX_PIN, -1, -1));
-
+static void configure_control_gpio(void)
+{
     // Configuration de la broche GPIO de contrôle
     gpio_config_t io_conf = {
             .pin_bit_mask = (1ULL << CONTROL_PIN_1) |
@@ -673,6 +901,35 @@ static void configure_uart_and_gpio(void)
     ESP_ERROR_CHECK(gpio_config(&io_conf));
 }
 
+/**
+ * @brief Rétablit l'état enregistré des actionneurs avant le démarrage d'OpenThread
+ *
+ * Les niveaux sont écrits avant l'activation des sorties: les broches passent
+ * directement à leur état enregistré, sans impulsion à 0 au démarrage. Crée
+ * aussi le timer qui termine l'impulsion LED de la commande 0x00.
+ */
+static void restore_actuators(void)
+{
+    app_actuator_state_t state = {
+        .pinLevels = 0,
+        .ledColor = sCurrentLedColor,
+    };
+    app_actuator_init(&state);
+
+    sPinLevels = state.pinLevels;
+    sCurrentLedColor = state.ledColor;
+    for (int i = 0; i < (int)(sizeof(sControlPins) / sizeof(sControlPins[0])); i++) {
+        gpio_set_level(sControlPins[i], (sPinLevels >> i) & 1u);
+    }
+    configure_control_gpio();
+
+    const esp_timer_create_args_t pulseArgs = {
+        .callback = led_pulse_timer_cb,
+        .name = "led_pulse",
+    };
+    ESP_ERROR_CHECK(esp_timer_create(&pulseArgs, &sLedPulseTimer));
+}
+
 /**
  * @brief Remplit le dataset opérationnel OpenThread avec les paramètres réseau
  *
@@ -726,83 +983,32 @@ static void fill_dataset(otOperationalDataset *dataset)
 }
 
 /**
- * @brief Fonction principale de l'application ESP32
- *
- * Cette fonction initialise tous les composants nécessaires au fonctionnement
- * de l'application Thread avec contrôle LED et communication UDP.
+ * @brief Démarre le nœud en appareil enfant (End Device)
  *
- * Séquence d'initialisation:
- * 1. Initialisation du système (NVS, event loop, netif, VFS)
- * 2. Configuration OpenThread selon le type d'appareil
- * 3. Configuration UART et GPIO
- * 4. Création des tâches FreeRTOS
- *
- * L'application supporte deux modes de fonctionnement:
- * - End Device (enfant): reçoit des commandes UDP et contrôle la LED
- * - Leader/Router (parent): envoie des commandes UDP aux enfants
+ * Applique le dataset (ou conserve celui enregistré pour un rattachement rapide),
+ * la politique de rôle et le profil de supervision enregistrés, active Thread puis
+ * ouvre le socket de réception des commandes.
  *
- * @note Cette fonction ne retourne jamais (boucle infinie dans les tâches)
+ * @param instance Instance OpenThread
  */
-void app_main(void)
+static void start_end_device(otInstance *instance)
 {
-    // Configuration VFS pour les descripteurs de fichiers d'événements
-    esp_vfs_eventfd_config_t eventfd_config = {
-        .max_fds = 3,
-    };
-
-    // Initialisation des composants système de base
-    ESP_ERROR_CHECK(nvs_flash_init());
-    ESP_ERROR_CHECK(esp_event_loop_create_default());
-    ESP_ERROR_CHECK(esp_netif_init());
-    ESP_ERROR_CHECK(esp_vfs_eventfd_register(&eventfd_config));
-
-    // Initialisation de l'interface CLI OpenThread si activée
-#if CONFIG_OPENTHREAD_CLI
-    esp_openthread_cli_init();
-#endif
-
-    // Configuration OpenThread
-    const esp_openthread_config_t config = {
-        .netif_config = ESP_NETIF_DEFAULT_OPENTHREAD(),
-        .platform_config = {
-            .radio_config = ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG(),
-            .host_config = ESP_OPENTHREAD_DEFAULT_HOST_CONFIG(),
-            .port_config = {
-                .storage_partition_name = "nvs",
-                .netif_queue_size = 10,
-                .task_queue_size = 10,
-            },
-        },
-    };
-
-    // Démarrage d'OpenThread
-    ESP_ERROR_CHECK(esp_openthread_start(&config));
-    otInstance *instance = esp_openthread_get_instance();
-
-    // Configuration spécifique selon le type d'appareil
-#ifdef CONFIG_DEVICE_TYPE_END_DEVICE
     // Configuration pour un appareil enfant (End Device)
     esp_openthread_lock_acquire(portMAX_DELAY);
 
+    // Dataset: conservé s'il est déjà enregistré en mode de rattachement rapide
     otOperationalDataset dataset;
     fill_dataset(&dataset);
+    app_attach_begin_locked(instance, &dataset);
 
-    otError error = otDatasetSetActive(instance, &dataset);
-    if (error != OT_ERROR_NONE) {
-        ESP_LOGE(TAG, "Failed to set active dataset: %d", error);
-    }
+    // Configuration du mode de liaison selon la politique de rôle enregistrée (REED/FED/MED/SED)
+    app_role_policy_apply_locked(instance, app_role_policy_load());
 
-    // Configuration du mode de liaison pour un enfant
-    otLinkModeConfig mode = {
-        .mRxOnWhenIdle = true,    // Récepteur toujours actif
-        .mDeviceType = false,     // Pas un routeur
-        .mNetworkData = false     // Ne gère pas les données réseau
-    };
-    otThreadSetLinkMode(instance, mode);
-    otThreadSetChildTimeout(instance, CHILD_TIMEOUT_S);
+    // Timeout enfant et supervision selon le profil enregistré (fast/default/lowpower)
+    app_supervision_apply_locked(instance, app_supervision_profile_load());
 
     // Activation des protocoles réseau
-    error = otIp6SetEnabled(instance, true);
+    otError error = otIp6SetEnabled(instance, true);
     if (error != OT_ERROR_NONE) {
         ESP_LOGE(TAG, "Failed to enable IP6: %d", error);
     }
@@ -814,14 +1020,32 @@ void app_main(void)
         ESP_LOGI(TAG, "Child thread enabled");
     }
 
-    // Initialisation du socket de réception UDP
+    // Initialisation du socket de réception UDP et du répondeur de la sonde de latence
     init_receive_socket_locked(instance);
+    app_probe_init_locked(instance);
+    app_tunnel_init_locked(instance);
+    app_registry_init_locked(instance);
+    app_discovery_init_locked(instance, UDP_PORT, CONTROL_PINS_TXT);
+    app_coalesce_init(instance, send_packed_now_locked);
+    app_airtime_init_locked(instance);
+    app_retry_init_locked(instance);
+    app_txpower_init_locked(instance);
     esp_openthread_lock_release();
 
     // Création de la tâche de contrôle LED
     xTaskCreate(led_blink_task, "led_blink", 4096, NULL, 5, NULL);
-   
-#else
+}
+
+/**
+ * @brief Démarre le nœud en leader
+ *
+ * Applique le dataset, active Thread, tente de devenir leader puis démarre
+ * les liens hôte dont les commandes sont relayées vers les enfants.
+ *
+ * @param instance Instance OpenThread
+ */
+static void start_leader(otInstance *instance)
+{
     // Configuration pour un appareil parent (Leader/Router)
     esp_openthread_lock_acquire(portMAX_DELAY);
 
@@ -833,6 +1057,9 @@ void app_main(void)
         ESP_LOGE(TAG, "Failed to set active dataset: %d", error);
     }
 
+    // Même profil de supervision que les enfants
+    app_supervision_apply_locked(instance, app_supervision_profile_load());
+
     // Activation des protocoles réseau
     error = otIp6SetEnabled(instance, true);
     if (error != OT_ERROR_NONE) {
@@ -844,8 +1071,18 @@ void app_main(void)
         ESP_LOGE(TAG, "Failed to enable thread: %d", error);
     }
 
-    // Initialisation du socket d'envoi UDP
+    // Initialisation du socket d'envoi UDP et de la sonde de latence
     init_udp_socket_locked(instance);
+    app_probe_init_locked(instance);
+    app_tunnel_init_locked(instance);
+    app_registry_init_locked(instance);
+    app_discovery_init_locked(instance, UDP_PORT, CONTROL_PINS_TXT);
+    app_coalesce_init(instance, send_packed_now_locked);
+    app_sched_init_locked(instance, send_scheduled_frame_locked);
+    app_netdiag_init_locked(instance);
+    app_airtime_init_locked(instance);
+    app_retry_init_locked(instance);
+    app_txpower_init_locked(instance);
     esp_openthread_lock_release();
 
     // Attendre un peu pour la stabilité
@@ -859,21 +1096,187 @@ void app_main(void)
     }
     esp_openthread_lock_release();
 
-    // Configuration UART et GPIO pour le débogage
-    configure_uart_and_gpio();
+    // Mesure du délai de détection des enfants disparus
+    app_supervision_monitor_start(instance);
+
+    // Lien hôte principal, relayé par le nœud de secours s'il se tait
+    app_failover_start(instance, APP_FAILOVER_PRIORITY_PRIMARY, forward_host_frame_locked);
+
+    // Liens hôte (GPIO de contrôle configurées dès app_main)
+    app_ingress_start(handle_host_frame);
+
+    // Tâche de contrôle LED; les envois périodiques passent par app_sched
+    xTaskCreate(led_blink_task, "led_blink", 4096, NULL, 5, NULL);
+}
+
+/**
+ * @brief Démarre le nœud en secours du lien hôte (hot standby)
+ *
+ * Nœud câblé sur la même liaison série que le leader. Il rejoint le réseau
+ * en routeur, écoute les heartbeats du nœud actif et reprend le relais des
+ * commandes de l'hôte si ceux-ci s'arrêtent.
+ *
+ * @param instance Instance OpenThread
+ */
+static void start_standby(otInstance *instance)
+{
+    esp_openthread_lock_acquire(portMAX_DELAY);
+
+    otOperationalDataset dataset;
+    fill_dataset(&dataset);
+
+    otError error = otDatasetSetActive(instance, &dataset);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to set active dataset: %d", error);
+    }
+
+    // Routeur dès que possible: seul un routeur peut relayer vers les enfants
+    app_role_policy_apply_locked(instance, APP_ROLE_POLICY_REED);
+    otThreadSetRouterSelectionJitter(instance, STANDBY_ROUTER_JITTER_S);
+    app_supervision_apply_locked(instance, app_supervision_profile_load());
+
+    // Activation des protocoles réseau
+    error = otIp6SetEnabled(instance, true);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to enable IP6: %d", error);
+    }
+
+    error = otThreadSetEnabled(instance, true);
+    if (error != OT_ERROR_NONE) {
+        ESP_LOGE(TAG, "Failed to enable thread: %d", error);
+    }
+
+    init_udp_socket_locked(instance);
+    app_probe_init_locked(instance);
+    app_tunnel_init_locked(instance);
+    app_registry_init_locked(instance);
+    app_discovery_init_locked(instance, UDP_PORT, CONTROL_PINS_TXT);
+    app_coalesce_init(instance, send_packed_now_locked);
+    app_sched_init_locked(instance, send_scheduled_frame_locked);
+    app_netdiag_init_locked(instance);
+    app_airtime_init_locked(instance);
+    app_retry_init_locked(instance);
+    app_txpower_init_locked(instance);
+    esp_openthread_lock_release();
+
+    app_supervision_monitor_start(instance);
+    app_failover_start(instance, APP_FAILOVER_PRIORITY_STANDBY, forward_host_frame_locked);
+
+    app_ingress_start(handle_host_frame);
 
-    // Création des tâches de contrôle LED, lecture UART et envoi périodique
-   
-    xTaskCreate(uart_read_task, "uart_read", 4096, instance, 5, NULL);
- //   xTaskCreate(send_data_example_task, "send_example", 4096, instance, 4, NULL);
     xTaskCreate(led_blink_task, "led_blink", 4096, NULL, 5, NULL);
+}
+
+/**
+ * @brief Démarre le nœud en renifleur
+ *
+ * Thread reste désactivé: la radio écoute le canal en mode promiscuous et
+ * UART0 porte le flux pcapng à la place des commandes de l'hôte.
+ *
+ * @param instance Instance OpenThread
+ */
+static void start_sniffer(otInstance *instance)
+{
+    otOperationalDataset dataset;
+
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    fill_dataset(&dataset);
+
+    // Le mode promiscuous et le changement de canal exigent l'interface Thread arrêtée
+    otThreadSetEnabled(instance, false);
+    otIp6SetEnabled(instance, false);
+    app_sniffer_start_locked(instance, dataset.mChannel);
+    esp_openthread_lock_release();
+}
+
+/**
+ * @brief Fonction principale de l'application ESP32
+ *
+ * Cette fonction initialise tous les composants nécessaires au fonctionnement
+ * de l'application Thread avec contrôle LED et communication UDP.
+ *
+ * Séquence d'initialisation:
+ * 1. Initialisation du système (NVS, event loop, netif, VFS)
+ *    et rétablissement des broches de contrôle et de la LED enregistrés
+ * 2. Choix du rôle du nœud (NVS, sinon broche de strap) et configuration OpenThread
+ * 3. Configuration des liens hôte
+ * 4. Création des tâches FreeRTOS
+ *
+ * La même image supporte quatre modes de fonctionnement, choisis au démarrage:
+ * - End Device (enfant): reçoit des commandes UDP et contrôle la LED
+ * - Leader/Router (parent): envoie des commandes UDP aux enfants
+ * - Standby (secours): reprend le lien hôte si le leader se tait
+ * - Sniffer (renifleur): capture le canal en pcapng sur UART0, hors réseau
+ *
+ * @note Cette fonction ne retourne jamais (boucle infinie dans les tâches)
+ */
+void app_main(void)
+{
+    // Configuration VFS pour les descripteurs de fichiers d'événements
+    esp_vfs_eventfd_config_t eventfd_config = {
+        .max_fds = 3,
+    };
+
+    // Initialisation des composants système de base
+    ESP_ERROR_CHECK(nvs_flash_init());
+
+    // Sorties rétablies avant OpenThread: le rattachement prend plusieurs secondes
+    restore_actuators();
+
+    ESP_ERROR_CHECK(esp_event_loop_create_default());
+    ESP_ERROR_CHECK(esp_netif_init());
+    ESP_ERROR_CHECK(esp_vfs_eventfd_register(&eventfd_config));
 
+    // Choix du rôle (leader ou enfant): NVS en priorité, sinon broche de strap
+    app_node_role_t nodeRole = app_node_role_resolve();
+
+    // Initialisation de l'interface CLI OpenThread si activée
+#if CONFIG_OPENTHREAD_CLI
+    esp_openthread_cli_init();
 #endif
 
+    // Configuration OpenThread
+    const esp_openthread_config_t config = {
+        .netif_config = ESP_NETIF_DEFAULT_OPENTHREAD(),
+        .platform_config = {
+            .radio_config = ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG(),
+            .host_config = ESP_OPENTHREAD_DEFAULT_HOST_CONFIG(),
+            // Files dimensionnées par le profil de charge (menuconfig)
+            .port_config = ESP_OPENTHREAD_DEFAULT_PORT_CONFIG(),
+        },
+    };
+
+    // Démarrage d'OpenThread, coût en tas mesuré pour comparer les profils de charge
+    uint32_t freeHeapBefore = esp_get_free_heap_size();
+    ESP_ERROR_CHECK(esp_openthread_start(&config));
+    app_load_set_start_heap(freeHeapBefore - esp_get_free_heap_size());
+    otInstance *instance = esp_openthread_get_instance();
+
+    // Priorités de coexistence Wi-Fi et statistiques, quel que soit le rôle
+    app_coex_init(instance);
+
+    // Configuration spécifique selon le rôle choisi au démarrage (NVS ou strap)
+    if (nodeRole == APP_NODE_ROLE_END_DEVICE) {
+        start_end_device(instance);
+    } else if (nodeRole == APP_NODE_ROLE_STANDBY) {
+        start_standby(instance);
+    } else if (nodeRole == APP_NODE_ROLE_SNIFFER) {
+        start_sniffer(instance);
+    } else {
+        start_leader(instance);
+    }
+
     // Initialisation des commandes CLI personnalisées si activées
 #if CONFIG_OPENTHREAD_CLI_ESP_EXTENSION
     esp_cli_custom_command_init();
 #endif
 
+    // Commandes de l'application (relay role, relay bench, ...)
+#if CONFIG_OPENTHREAD_CLI
+    esp_openthread_lock_acquire(portMAX_DELAY);
+    app_cli_init(instance);
+    esp_openthread_lock_release();
+#endif
+
 
 }
\ No newline at end of file
@@ -15,22 +15,23 @@
 #pragma once
 
 #include "esp_openthread_types.h"
+#include "sdkconfig.h"
 
-#if SOC_IEEE802154_SUPPORTED
+#if CONFIG_APP_RADIO_NATIVE
 #define ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG()              \
     {                                                      \
         .radio_mode = RADIO_MODE_NATIVE,                   \
     }
 
-#else
+#elif CONFIG_APP_RADIO_UART_RCP
 #define ESP_OPENTHREAD_DEFAULT_RADIO_CONFIG()                 \
     {                                                         \
         .radio_mode = RADIO_MODE_UART_RCP,                    \
         .radio_uart_config = {                                \
-            .port = 1,                                        \
+            .port = CONFIG_APP_RCP_UART_PORT,                 \
             .uart_config =                                    \
                 {                                             \
-                    .baud_rate = 115200,                      \
+                    .baud_rate = CONFIG_APP_RCP_UART_BAUD,    \
                     .data_bits = UART_DATA_8_BITS,            \
                     .parity = UART_PARITY_DISABLE,            \
                     .stop_bits = UART_STOP_BITS_1,            \
@@ -38,10 +39,13 @@
                     .rx_flow_ctrl_thresh = 0,                 \
                     .source_clk = UART_SCLK_DEFAULT,          \
                 },                                            \
-            .rx_pin = 4,                                      \
-            .tx_pin = 5,                                      \
+            .rx_pin = CONFIG_APP_RCP_UART_RX_PIN,             \
+            .tx_pin = CONFIG_APP_RCP_UART_TX_PIN,             \
         },                                                    \
     }
+
+#else
+#error "OpenThread radio type must be native or spinel over UART"
 #endif
 
 #define ESP_OPENTHREAD_DEFAULT_HOST_CONFIG()                        \
@@ -49,9 +53,9 @@
         .host_connection_mode = HOST_CONNECTION_MODE_NONE,          \
     }
 
-#define ESP_OPENTHREAD_DEFAULT_PORT_CONFIG()    \
-    {                                           \
-        .storage_partition_name = "nvs",        \
-        .netif_queue_size = 10,                 \
-        .task_queue_size = 10,                  \
+#define ESP_OPENTHREAD_DEFAULT_PORT_CONFIG()                \
+    {                                                       \
+        .storage_partition_name = "nvs",                    \
+        .netif_queue_size = CONFIG_APP_OT_NETIF_QUEUE_SIZE, \
+        .task_queue_size = CONFIG_APP_OT_TASK_QUEUE_SIZE,   \
     }
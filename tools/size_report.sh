@@ -0,0 +1,50 @@
+#!/usr/bin/env bash
+#
+# SPDX-FileCopyrightText: 2021-2025 Espressif Systems (Shanghai) CO LTD
+#
+# SPDX-License-Identifier: CC0-1.0
+#
+# Compare l'empreinte flash/RAM par composant entre profils de configuration.
+#
+# Usage: tools/size_report.sh [profil_de_référence profil...]
+#        (défaut: cli production, soit sdkconfig.ci.cli et sdkconfig.ci.production)
+#
+# Chaque profil est construit dans build_<profil>/ à partir de sdkconfig.defaults
+# et de sdkconfig.ci.<profil>. Les rapports sont écrits dans size_report/:
+#   <profil>.txt              totaux (idf.py size)
+#   <profil>-components.txt   flash et RAM par composant, depuis le fichier map
+#   <profil>-vs-<réf>.txt     écarts par composant avec le profil de référence
+
+set -euo pipefail
+
+cd "$(dirname "$0")/.."
+
+if [ $# -eq 0 ]; then
+    set -- cli production
+fi
+
+out=size_report
+mkdir -p "$out"
+
+for profile in "$@"; do
+    if [ ! -f "sdkconfig.ci.$profile" ]; then
+        echo "Unknown profile: $profile (no sdkconfig.ci.$profile)" >&2
+        exit 1
+    fi
+
+    build="build_$profile"
+    echo "Building $profile..."
+    idf.py -B "$build" -D SDKCONFIG="$build/sdkconfig" \
+        -D SDKCONFIG_DEFAULTS="sdkconfig.defaults;sdkconfig.ci.$profile" build > "$out/$profile-build.log"
+
+    idf.py -B "$build" size > "$out/$profile.txt"
+    idf.py -B "$build" size-components > "$out/$profile-components.txt"
+done
+
+reference="$1"
+shift
+for profile in "$@"; do
+    idf.py -B "build_$profile" size-components --diff "build_$reference" > "$out/$profile-vs-$reference.txt"
+    echo "== $profile vs $reference"
+    cat "$out/$profile-vs-$reference.txt"
+done